@@ -0,0 +1,132 @@
+#!/bin/bash
+
+# Benchmark of DeltaMake itself on a synthetic solution (see `bench/GenSolution.sh`)
+# Usage: ./bench.sh [sub solutions] [files per solution] [workers...]
+#
+# One JSON object per line on stdout, progress on stderr:
+#	{"commit": "abc1234", "subs": 15, "files": 50, "workers": 4, "metric": "noop_build", "value": 12.345, "unit": "ms"}
+#
+# Env:
+#	DELTAMAKE		Binary to measure (default: ./deltamake of `build.sh`)
+#	BENCH_DIR		Generated solution (default: temporary directory, removed at the end)
+#	BENCH_RUNS		Runs of every measurement, the best one is taken (default: 5)
+#	BENCH_SLEEP		ms of the stub compiler (default: 0)
+#	BENCH_FLAGS		Extra flags of every run, like `--binary-diff`
+
+# Colors
+CReset="\033[0m"
+CRed="\033[0;31m"
+CGreen="\033[0;32m"
+CCyan="\033[0;36m"
+
+NSubs=${1:-15}
+NFiles=${2:-50}
+Workers=${*:3}
+Workers=${Workers:-1 2 4 8}
+
+Root=$(cd "$(dirname "$0")" && pwd)
+DeltaMake=$(realpath "${DELTAMAKE:-$Root/deltamake}")
+Runs=${BENCH_RUNS:-5}
+Commit=$(git -C "$Root" rev-parse --short HEAD 2> /dev/null)
+
+if [ ! -x "$DeltaMake" ]; then
+	echo -e "["$CRed"NO BINARY"$CReset"] Run "$CCyan"./build.sh"$CReset" first, or set DELTAMAKE" >&2
+	exit 1
+fi
+
+Dir=${BENCH_DIR:-$(mktemp -d /tmp/deltamake-bench-XXXXXX)}
+if [ -z "$BENCH_DIR" ]; then
+	trap 'rm -rf "$Dir"' EXIT
+fi
+
+echo -e "Generating "$CGreen$NSubs$CReset" sub solutions of "$CGreen$NFiles$CReset" files in "$CCyan$Dir$CReset"..." >&2
+"$Root/bench/GenSolution.sh" "$Dir" "$NSubs" "$NFiles" "${BENCH_SLEEP:-0}" || exit 1
+cd "$Dir"
+
+# Metric line: <workers> <metric> <value> <unit>
+Report() {
+	echo "{\"commit\": \"$Commit\", \"subs\": $NSubs, \"files\": $NFiles, \"workers\": $1, \"metric\": \"$2\", \"value\": $3, \"unit\": \"$4\"}"
+}
+
+# Main thread phase of the last trace in ms: <phase name>
+Phase() {
+	grep -o "\"cat\":\"phase\",\"dur\":[0-9]*,\"name\":\"$1\"" trace.json | sed -e 's/.*"dur":\([0-9]*\).*/\1/' | awk '{ sum += $1 } END { printf "%.3f", sum / 1000 }'
+}
+
+# Measurement of the last `--measure` output: <label>
+Measure() {
+	sed -n -e "s/^\s*$1:\s*\([0-9.]*\).*/\1/p" output.txt | head -1
+}
+
+# Wall time of one run in ms: <flags...>
+Run() {
+	local begin=$(date +%s%N)
+	"$DeltaMake" --plain --measure --trace trace.json $BENCH_FLAGS "$@" > output.txt 2>&1
+	local status=$?
+	local end=$(date +%s%N)
+
+	if [ $status -ne 0 ]; then
+		echo -e "["$CRed"FAILED"$CReset"] $DeltaMake $*" >&2
+		cat output.txt >&2
+		exit 1
+	fi
+
+	awk "BEGIN { printf \"%.3f\", ($end - $begin) / 1e6 }"
+}
+
+Clean() {
+	find . \( -name tmp -o -name build \) -type d -prune -exec rm -rf {} +
+	find . \( -name 'deltamake.json' -o -name 'deltamake.bin' -o -name 'deltamake.journal' \) -delete
+}
+
+# Cold builds, every source and link is a task
+for w in $Workers; do
+	echo -e "Cold build with "$CGreen"-w $w"$CReset"..." >&2
+
+	Best=""
+	for ((i = 0; i < Runs; ++i)); do
+		Clean
+		Wall=$(Run -s -w $w) || exit 1
+		if [ -z "$Best" ] || [ $(awk "BEGIN { print ($Wall < $Best) }") -eq 1 ]; then
+			Best=$Wall
+			NTasks=$(grep -o '"cat":"\(local\|remote\|cached\)"' trace.json | wc -l)
+			Build=$(Phase "Build")
+			Scheduler=$(Measure "Scheduler CPU")
+			Latency=$(Measure "Dispatch latency")
+			Generate=$(Phase "Generate tasks")
+			SaveDiff=$(awk "BEGIN { printf \"%.3f\", $(Phase "Save diff") + $(Phase "Save sub diffs") }")
+		fi
+	done
+
+	Report $w cold_build $Best ms
+	Report $w tasks $NTasks count
+	Report $w throughput $(awk "BEGIN { printf \"%.1f\", ($Build != 0) ? $NTasks / ($Build / 1000) : 0 }") tasks/s
+	Report $w scheduler_cpu_per_task $(awk "BEGIN { printf \"%.3f\", ($NTasks != 0) ? $Scheduler * 1000 / $NTasks : 0 }") us
+	Report $w dispatch_latency $Latency ms
+	Report $w generate_tasks $Generate ms
+	Report $w diff_save $SaveDiff ms
+done
+
+# No-op builds of the last cold one, only loading and checking
+w=${Workers##* }
+echo -e "No-op build with "$CGreen"-w $w"$CReset"..." >&2
+
+Best=""
+for ((i = 0; i < Runs; ++i)); do
+	Wall=$(Run -s -w $w) || exit 1
+	if [ -z "$Best" ] || [ $(awk "BEGIN { print ($Wall < $Best) }") -eq 1 ]; then
+		Best=$Wall
+		Load=$(awk "BEGIN { printf \"%.3f\", $(Phase "Load solutions") + $(Phase "Load sub solutions") }")
+		LoadDiff=$(Phase "Load diff")
+		Scan=$(Phase "Scan")
+		Generate=$(Phase "Generate tasks")
+	fi
+done
+
+Report $w noop_build $Best ms
+Report $w solution_load $Load ms
+Report $w diff_load $LoadDiff ms
+Report $w scan $Scan ms
+Report $w noop_generate_tasks $Generate ms
+
+echo -e $CGreen"Done."$CReset >&2
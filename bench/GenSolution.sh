@@ -0,0 +1,109 @@
+#!/bin/bash
+
+# Synthetic solution for `bench.sh`: a root and a binary tree of sub solutions
+# Usage: ./bench/GenSolution.sh <directory> <sub solutions> <files per solution> [compile ms]
+#
+# Commands are a stub that only writes the object and the depfile (and sleeps
+# `compile ms`), so DeltaMake itself is measured, not the compiler
+
+if [ $# -lt 3 ]; then
+	echo "Usage: $0 <directory> <sub solutions> <files per solution> [compile ms]"
+	exit 1
+fi
+
+Dir=$1
+NSubs=$2
+NFiles=$3
+Sleep=${4:-0}
+
+rm -rf "$Dir"
+mkdir -p "$Dir"
+Dir=$(cd "$Dir" && pwd)
+
+# Stub compiler: `-MF <depfile>` and `-o <object>`
+Stub=$Dir/cc.sh
+cat > "$Stub" <<STUB
+#!/bin/sh
+while [ \$# -gt 0 ]; do
+	case "\$1" in
+		-o) out=\$2; shift ;;
+		-MF) dep=\$2; shift ;;
+	esac
+	shift
+done
+[ $Sleep -ne 0 ] && sleep $(awk "BEGIN { print $Sleep / 1000 }")
+[ -n "\$out" ] && : > "\$out"
+[ -n "\$dep" ] && echo "\$out: $Dir/common.h" > "\$dep"
+exit 0
+STUB
+chmod +x "$Stub"
+echo "#pragma once" > "$Dir/common.h"
+
+# Sources of one solution
+GenFiles() {
+	mkdir -p "$1/src"
+	for ((f = 0; f < NFiles; ++f)); do
+		echo "int f$f() { return $f; }" > "$1/src/f$f.cpp"
+	done
+}
+
+# Children of sub `i` are `2i + 1` and `2i + 2`
+SubsOf() {
+	local first=$(($1 * 2 + 1))
+	local list=""
+	for child in $first $((first + 1)); do
+		if [ $child -lt $NSubs ]; then
+			list+="${list:+, }\"s$child\": \"../s$child\""
+		fi
+	done
+	echo "$list"
+}
+
+SubBuildsOf() {
+	local first=$(($1 * 2 + 1))
+	local list=""
+	for child in $first $((first + 1)); do
+		if [ $child -lt $NSubs ]; then
+			list+="${list:+, }\"s$child\": { \"build\": \"lib\" }"
+		fi
+	done
+	echo "$list"
+}
+
+for ((i = 0; i < NSubs; ++i)); do
+	Sub=$Dir/subs/s$i
+	GenFiles "$Sub"
+	cat > "$Sub/solution.json" <<JSON
+{
+	"version": "3.0.0",
+	"type": "c/cpp",
+	"paths": { "scan": ["src/"], "build": "build/", "tmp": "tmp/" },
+	"solutions": { $(SubsOf $i) },
+	"files": [],
+	"builds": {
+		"lib": { "type": "lib", "compiler": "$Stub", "archiver": "true", "solutions": { $(SubBuildsOf $i) }, "outname": "s$i.a" }
+	}
+}
+JSON
+done
+
+GenFiles "$Dir"
+RootSubs=""
+RootBuilds=""
+if [ $NSubs -gt 0 ]; then
+	RootSubs="\"s0\": \"subs/s0\""
+	RootBuilds="\"s0\": { \"build\": \"lib\" }"
+fi
+
+cat > "$Dir/solution.json" <<JSON
+{
+	"version": "3.0.0",
+	"type": "c/cpp",
+	"paths": { "scan": ["src/"], "build": "build/", "tmp": "tmp/" },
+	"solutions": { $RootSubs },
+	"files": [],
+	"builds": {
+		"default": { "type": "exec", "compiler": "$Stub", "linker": "true", "solutions": { $RootBuilds }, "outname": "app" }
+	}
+}
+JSON
@@ -0,0 +1,132 @@
+/**
+ * \file	SpawnBench.cpp
+ * \brief	Spawn overhead per task: `fork()` + `sh -c`, `posix_spawn()` + `sh -c`, `posix_spawn()` + argv
+ * \date	14 oct 2026
+ * \author	Reklov
+ *
+ * g++ --std=c++17 -O2 -I./source/ ./bench/SpawnBench.cpp ./source/Process.cpp -lpthread -o spawnbench
+ * ./spawnbench [tasks per thread] [threads] [RSS MiB]
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <unistd.h>
+#include <paths.h>
+#include <wait.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string>
+
+#include "Process.h"
+
+using namespace DeltaMake;
+
+// ******************************************************************************** //
+
+#define BENCH_COMMAND					"true"
+
+extern char** environ;
+
+/**
+ * The old way of `CProcess::Exec()`
+ */
+static bool ForkExec(const char command[], int& rReturnStatus) {
+	int outPipe[2];
+	if (pipe(outPipe) < 0)
+		return false;
+
+	const pid_t pid = fork();
+	if (pid < 0)
+		return false;
+
+	if (pid == 0) {
+		close(outPipe[0]);
+		dup2(outPipe[1], STDOUT_FILENO);
+		close(outPipe[1]);
+
+		const char* args[] = { "sh", "-c", command, NULL };
+		execve(_PATH_BSHELL, const_cast<char* const*>(args), environ);
+		_exit(127);
+	}
+
+	close(outPipe[1]);
+
+	char buffer[256];
+	while (read(outPipe[0], buffer, sizeof(buffer)) > 0) { }
+
+	close(outPipe[0]);
+
+	int status;
+	while ((waitpid(pid, &status, 0) < 0) && (errno == EINTR)) { }
+
+	rReturnStatus = WEXITSTATUS(status);
+
+	return true;
+}
+
+/**
+ * \returns µs per task
+ */
+template<typename TFunction>
+static double Run(size_t nTasks, size_t nThreads, TFunction function) {
+	const auto begin = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < nThreads; ++i) {
+		threads.emplace_back([nTasks, &function]() {
+			for (size_t j = 0; j < nTasks; ++j) {
+				int returnStatus = -1;
+				if ((function(returnStatus) == false) || (returnStatus != 0)) {
+					fprintf(stderr, "Task failed\n");
+					exit(1);
+				}
+			}
+		});
+	}
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	const std::chrono::duration<double, std::micro> time = std::chrono::steady_clock::now() - begin;
+
+	return time.count() / (nTasks * nThreads);
+}
+
+/* ****************************************
+ * main
+ */
+int main(int argc, const char* argv[]) {
+	const size_t nTasks = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 500;
+	const size_t nThreads = (argc > 2) ? strtoul(argv[2], nullptr, 10) : 4;
+	const size_t rss = (argc > 3) ? strtoul(argv[3], nullptr, 10) : 512;
+
+	// Touched memory, like the big JSON trees of a big solution
+	std::vector<char> memory(rss << 20);
+	for (size_t i = 0; i < memory.size(); i += 4096)
+		memory[i] = 1;
+
+	std::vector<std::string> args;
+	CProcess::SplitCommand(BENCH_COMMAND, args);
+
+	printf("%zu tasks x %zu threads, %zu MiB RSS\n", nTasks, nThreads, rss);
+
+	printf("fork() + sh -c:        %8.1f us\n", Run(nTasks, nThreads, [](int& rReturnStatus) {
+		return ForkExec(BENCH_COMMAND, rReturnStatus);
+	}));
+
+	printf("posix_spawn() + sh -c: %8.1f us\n", Run(nTasks, nThreads, [](int& rReturnStatus) {
+		CProcess process;
+		return process.Exec(BENCH_COMMAND, rReturnStatus);
+	}));
+
+	printf("posix_spawn() + argv:  %8.1f us\n", Run(nTasks, nThreads, [&args](int& rReturnStatus) {
+		CProcess process;
+		return process.Exec(args, rReturnStatus);
+	}));
+
+	return 0;
+}
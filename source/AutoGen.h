@@ -0,0 +1,12 @@
+// Automatically generated code
+
+// Defines
+#define DELTAMAKE_COMMIT_DATE "14.10.2026"
+#define DELTAMAKE_COMMIT_HASH "8151581"
+
+// Plugins
+#include "plugins/SolutionCPP.h"
+
+void LoadPlugins() {
+	RegisterPlugin(CSolutionCPP::GetInstance());
+}
@@ -0,0 +1,198 @@
+/**
+ * \file	BuildGraph.cpp
+ * \brief	Inputs of the last build without tasks
+ * \date	14 oct 2026
+ * \author	Reklov
+ */
+#include "BuildGraph.h"
+
+#include <string.h>
+#include <errno.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <limits>
+
+#include "Terminal.h"
+#include "Hash.h"
+#include "FileStat.h"
+
+using namespace DeltaMake;
+
+// ******************************************************************************** //
+
+/* ****************************************
+ * DeltaMake::CBuildGraph::GetKey
+ */
+std::string DeltaMake::CBuildGraph::GetKey(int argc, char* argv[]) {
+	CHash hash;
+	for (int i = 1; i < argc; ++i) {
+		hash.Update(argv[i]);
+		hash.Update("\n");
+	}
+
+	return CHash::ToString(hash.Digest());
+}
+
+/* ****************************************
+ * DeltaMake::CBuildGraph::IsUpToDate
+ */
+bool DeltaMake::CBuildGraph::IsUpToDate(const char path[], const std::string& key) {
+	std::string data;
+	{
+		const int fd = open(path, O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			return false;
+
+		struct stat stats;
+		if ((fstat(fd, &stats) != 0) || (stats.st_size < static_cast<off_t>(sizeof(SGraphHeader)))) {
+			close(fd);
+			return false;
+		}
+
+		data.resize(static_cast<size_t>(stats.st_size));
+		const ssize_t size = read(fd, &data[0], data.size());
+		close(fd);
+
+		if (size != static_cast<ssize_t>(data.size()))
+			return false;
+	}
+
+	SGraphHeader header;
+	memcpy(&header, data.data(), sizeof(header));
+	if ((memcmp(header.magic, DELTAMAKE_GRAPH_MAGIC, sizeof(header.magic)) != 0) || (header.format != DELTAMAKE_GRAPH_FORMAT))
+		return false;
+
+	if ((key.size() != sizeof(header.key)) || (memcmp(header.key, key.data(), sizeof(header.key)) != 0)) {
+		terminal->Log(LOG_DETAIL, "Build graph is of other arguments\n");
+		return false;
+	}
+
+	if (header.expires <= static_cast<int64_t>(time(nullptr))) {
+		terminal->Log(LOG_DETAIL, "Build graph is expired\n");
+		return false;
+	}
+
+	const uint64_t expected = sizeof(header) + static_cast<uint64_t>(header.nFiles) * sizeof(SGraphFile) + header.poolSize;
+	if ((expected != data.size()) || (header.poolSize == 0) || (data.back() != '\0'))
+		return false;
+
+	CHash hash;
+	hash.Update(data.data() + sizeof(header), data.size() - sizeof(header));
+	if (hash.Digest() != header.checksum)
+		return false;
+
+	std::vector<SGraphFile> files(header.nFiles);
+	memcpy(files.data(), data.data() + sizeof(header), files.size() * sizeof(SGraphFile));
+
+	// Paths are used in place
+	std::vector<const char*> paths;
+	paths.reserve(files.size());
+	for (size_t offset = sizeof(header) + files.size() * sizeof(SGraphFile); offset < data.size(); offset += strlen(&data[offset]) + 1)
+		paths.push_back(&data[offset]);
+
+	if (paths.size() != files.size())
+		return false;
+
+	std::vector<SFileStat> current;
+	CFileStat::GetAll(paths, current);
+
+	for (size_t i = 0; i < files.size(); ++i) {
+		const int64_t mtime = (current[i].bExists == true) ? current[i].mtimeNs : -1;
+		if ((files[i].mtimeNs != mtime) || (files[i].size != current[i].size)) {
+			terminal->Log(LOG_DETAIL, "\"%s\" is changed since the build graph\n", paths[i]);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CBuildGraph::Save
+ */
+bool DeltaMake::CBuildGraph::Save(const char path[], const std::string& key, std::vector<std::filesystem::path> paths, time_t expires) {
+	// A rebuilt DeltaMake may generate other tasks
+	std::error_code error;
+	const std::filesystem::path executable = std::filesystem::read_symlink("/proc/self/exe", error);
+	if (!error)
+		paths.push_back(executable);
+
+	std::sort(paths.begin(), paths.end());
+	paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+
+	std::vector<SFileStat> stats;
+	CFileStat::GetAll(paths, stats);
+
+	const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+	std::vector<SGraphFile> files(paths.size());
+	std::string pool;
+	for (size_t i = 0; i < paths.size(); ++i) {
+		if ((stats[i].bExists == true) && (stats[i].mtimeNs + DELTAMAKE_GRAPH_RACY_TIME > now)) {
+			terminal->Log(LOG_DETAIL, "\"%s\" is changed too recently for the build graph\n", paths[i].c_str());
+			Remove(path);
+			return false;
+		}
+
+		files[i].mtimeNs = (stats[i].bExists == true) ? stats[i].mtimeNs : -1;
+		files[i].size = stats[i].size;
+
+		pool += paths[i].native();
+		pool += '\0';
+	}
+
+	SGraphHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, DELTAMAKE_GRAPH_MAGIC, sizeof(header.magic));
+	header.format = DELTAMAKE_GRAPH_FORMAT;
+	header.nFiles = static_cast<uint32_t>(files.size());
+	header.expires = static_cast<int64_t>(std::min<time_t>(expires, std::numeric_limits<int64_t>::max()));
+	memcpy(header.key, key.data(), std::min(key.size(), sizeof(header.key)));
+	header.poolSize = pool.size();
+
+	std::string data;
+	data.reserve(sizeof(header) + files.size() * sizeof(SGraphFile) + pool.size());
+	data.append(reinterpret_cast<const char*>(&header), sizeof(header));
+	data.append(reinterpret_cast<const char*>(files.data()), files.size() * sizeof(SGraphFile));
+	data.append(pool);
+
+	CHash hash;
+	hash.Update(data.data() + sizeof(header), data.size() - sizeof(header));
+	header.checksum = hash.Digest();
+	memcpy(&data[0], &header, sizeof(header));
+
+	terminal->Log(LOG_DETAIL, "Build graph of %zu files\n", paths.size());
+
+	// Written to a temporary file first, a torn graph would be of no use
+	const std::string tmpPath = std::string(path) + ".tmp";
+	{
+		std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+		file.write(data.data(), static_cast<std::streamsize>(data.size()));
+
+		if (file.good() == false) {
+			terminal->Log(LOG_ERROR, "Can't write \"%s\"\n", tmpPath.c_str());
+			return false;
+		}
+	}
+
+	if (rename(tmpPath.c_str(), path) != 0) {
+		terminal->Log(LOG_ERROR, "Can't replace \"%s\": %s\n", path, strerror(errno));
+		unlink(tmpPath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CBuildGraph::Remove
+ */
+void DeltaMake::CBuildGraph::Remove(const char path[]) {
+	unlink(path);
+}
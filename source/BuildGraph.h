@@ -0,0 +1,82 @@
+/**
+ * \file	BuildGraph.h
+ * \brief	Inputs of the last build without tasks
+ * \date	14 oct 2026
+ * \author	Reklov
+ */
+#ifndef __DELTAMAKE_BUILD_GRAPH_H__
+#define __DELTAMAKE_BUILD_GRAPH_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "deltamake.h"
+
+
+#define DELTAMAKE_GRAPH_MAGIC			"DMGRAPH" // 8 bytes with the terminator
+#define DELTAMAKE_GRAPH_FORMAT			1
+#define DELTAMAKE_GRAPH_RACY_TIME		1000000000 // ns, a file changed so recently may change again with the same mtime
+
+// ******************************************************************************** //
+
+										//										//
+namespace DeltaMake {
+	/**
+	 * Header of the graph file, followed by the file table and the NUL terminated paths
+	 */
+	struct SGraphHeader {
+		char							magic[8];
+		uint32_t						format;
+		uint32_t						nFiles;
+		int64_t							expires; /* s since the epoch */
+		char							key[16]; /* `GetKey()` */
+		uint64_t						poolSize; /* Bytes */
+		uint64_t						checksum; /* Of everything after the header */
+	};
+
+	/**
+	 * Metadata of one file of the graph
+	 */
+	struct SGraphFile {
+		int64_t							mtimeNs; /* `-1` if missing */
+		uint64_t						size;
+	};
+
+	/**
+	 * Files the builds are generated from, with their metadata, saved when a build has no tasks
+	 *
+	 * While all of them are the same, the next build with the same arguments has no tasks too,
+	 * so it's skipped without loading any solution or diff. The file is read as is,
+	 * nothing is parsed before the stats
+	 */
+	class CBuildGraph final {
+		public:
+			/**
+			 * \returns Hash of the arguments, other ones may build something else
+			 */
+			static std::string			GetKey(int argc, char* argv[]);
+
+			/**
+			 * Stat all files of the graph in one batch
+			 *
+			 * \returns `true` if the graph exists, has the same key, and no file is changed
+			 */
+			static bool					IsUpToDate(const char path[], const std::string& key);
+
+			/**
+			 * \param paths Files and directories, missing ones must stay missing
+			 * \param expires Time when the builds may have tasks without any file change
+			 * \returns `false` if some file is changed too recently to be trusted, the graph is removed then
+			 */
+			static bool					Save(const char path[], const std::string& key, std::vector<std::filesystem::path> paths, time_t expires);
+
+			static void					Remove(const char path[]);
+	};
+}
+
+#endif /* !__DELTAMAKE_BUILD_GRAPH_H__ */
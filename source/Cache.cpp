@@ -0,0 +1,426 @@
+/**
+ * \file	Cache.cpp
+ * \brief	Content-addressed object cache
+ * \date	14 oct 2026
+ * \author	Reklov
+ */
+#include "Cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/fs.h>
+#endif
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#include "Terminal.h"
+#include "Hash.h"
+
+using namespace DeltaMake;
+
+// ******************************************************************************** //
+
+DeltaMake::CObjectCache g_objectCache;
+extern DeltaMake::CObjectCache* const DeltaMake::objectCache = &g_objectCache;
+
+// ******************************************************************************** //
+
+/* ****************************************
+ * DeltaMake::CObjectCache::Init
+ */
+bool DeltaMake::CObjectCache::Init(const char path[], uint64_t maxSize) {
+	m_bEnabled = false;
+	if (path == nullptr)
+		return true;
+
+	std::error_code error;
+	m_path = std::filesystem::absolute(path, error);
+	if (error) {
+		terminal->Log(LOG_WARNING, "Bad cache path \"%s\". Cache is disabled\n", path);
+		return false;
+	}
+
+	std::filesystem::create_directories(m_path / DELTAMAKE_CACHE_MANIFESTS, error);
+	if (error.value() == 0)
+		std::filesystem::create_directories(m_path / DELTAMAKE_CACHE_OBJECTS, error);
+
+	if (error) {
+		terminal->Log(LOG_WARNING, "Can't create cache \"%s\": %s. Cache is disabled\n", m_path.c_str(), error.message().c_str());
+		return false;
+	}
+
+	m_maxSize = maxSize;
+	m_bEnabled = true;
+	terminal->Log(LOG_DETAIL, "Object cache: \"%s\" (%llu MiB)\n", m_path.c_str(), static_cast<unsigned long long>(maxSize >> 20));
+
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CObjectCache::IsEnabled
+ */
+bool DeltaMake::CObjectCache::IsEnabled() const {
+	return m_bEnabled;
+}
+
+/* ****************************************
+ * DeltaMake::CObjectCache::GetCompilerId
+ */
+std::string DeltaMake::CObjectCache::GetCompilerId(const std::string& compiler) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto iterator = m_compilers.find(compiler);
+	if (iterator != m_compilers.end())
+		return iterator->second;
+
+	// Executable is the first word, e.g. `g++` of `g++ -m32`
+	const std::string name = compiler.substr(0, compiler.find(' '));
+
+	std::string path = name;
+	struct stat info;
+	bool bFound = (name.find('/') != std::string::npos) && (stat(name.c_str(), &info) == 0);
+
+	const char* env = getenv("PATH");
+	if ((bFound == false) && (name.find('/') == std::string::npos) && (env != nullptr)) {
+		std::stringstream dirs(env);
+		std::string dir;
+		while ((bFound == false) && (std::getline(dirs, dir, ':'))) {
+			path = ((dir.size() == 0) ? "." : dir) + "/" + name;
+			bFound = (stat(path.c_str(), &info) == 0);
+		}
+	}
+
+	CHash hash;
+	hash.Update(compiler);
+
+	if (bFound == true) {
+		const uint64_t size = static_cast<uint64_t>(info.st_size);
+		const uint64_t mtime = static_cast<uint64_t>(info.st_mtim.tv_sec) * 1000000000ull + static_cast<uint64_t>(info.st_mtim.tv_nsec);
+
+		hash.Update(path);
+		hash.Update(&size, sizeof(size));
+		hash.Update(&mtime, sizeof(mtime));
+	}
+	else
+		terminal->Log(LOG_WARNING, "Can't find compiler \"%s\" for the cache\n", name.c_str());
+
+	return m_compilers[compiler] = CHash::ToString(hash.Digest());
+}
+
+/* ****************************************
+ * DeltaMake::CObjectCache::Fetch
+ */
+bool DeltaMake::CObjectCache::Fetch(const std::string& key, const std::filesystem::path& outPath, std::vector<std::string>& rInputs) {
+	// Old object may be a clone of the cached one, so the compiler must write a new file
+	std::error_code error;
+	std::filesystem::remove(outPath, error);
+
+	if (m_bEnabled == false)
+		return false;
+
+	std::ifstream file(GetManifestPath(key));
+	if (file.good() == false) {
+		++m_nMisses;
+		return false;
+	}
+
+	Json::Value manifest;
+	Json::CharReaderBuilder builder;
+	if (Json::parseFromStream(builder, file, &manifest, nullptr) == false) {
+		++m_nMisses;
+		return false;
+	}
+
+	const Json::Value& entries = manifest["entries"];
+	if (entries.isArray() == false) {
+		++m_nMisses;
+		return false;
+	}
+
+	std::map<std::string, std::string> hashes; // Input -> content hash
+	for (Json::ArrayIndex i = entries.size(); i-- != 0;) { // Newest first
+		const Json::Value& inputs = entries[i]["inputs"];
+		const Json::Value& object = entries[i]["object"];
+		if ((inputs.isArray() == false) || (object.isString() == false))
+			continue;
+
+		bool bMatch = true;
+		for (Json::ArrayIndex j = 0; (j < inputs.size()) && (bMatch == true); ++j) {
+			const Json::Value& input = inputs[j];
+			if ((input.isArray() == false) || (input.size() != 2) || (input[0].isString() == false)) {
+				bMatch = false;
+				break;
+			}
+
+			const std::string path = input[0].asString();
+			auto iterator = hashes.find(path);
+			if (iterator == hashes.end()) {
+				uint64_t hash;
+				iterator = hashes.emplace(path, (CHash::HashFile(path.c_str(), hash) == true) ? CHash::ToString(hash) : "").first;
+			}
+
+			bMatch = (iterator->second.size() != 0) && (input[1] == iterator->second);
+		}
+
+		if (bMatch == false)
+			continue;
+
+		const std::filesystem::path objectPath = GetObjectPath(object.asString());
+		if (CloneFile(objectPath, outPath) == false)
+			continue; // Evicted
+
+		std::filesystem::last_write_time(objectPath, std::filesystem::file_time_type::clock::now(), error); // Recently used
+
+		rInputs.clear();
+		for (Json::ArrayIndex j = 0; j < inputs.size(); ++j)
+			rInputs.push_back(inputs[j][0].asString());
+
+		++m_nHits;
+		return true;
+	}
+
+	++m_nMisses;
+	return false;
+}
+
+/* ****************************************
+ * DeltaMake::CObjectCache::Store
+ */
+bool DeltaMake::CObjectCache::Store(const std::string& key, const std::filesystem::path& outPath, const std::vector<std::string>& inputs) {
+	if (m_bEnabled == false)
+		return false;
+
+	CHash objectHash;
+	objectHash.Update(key);
+
+	Json::Value entry(Json::objectValue);
+	Json::Value& entryInputs = entry["inputs"] = Json::Value(Json::arrayValue);
+	for (size_t i = 0; i < inputs.size(); ++i) {
+		uint64_t hash;
+		if (CHash::HashFile(inputs[i].c_str(), hash) == false)
+			return false; // Input is gone, so it's not the same object
+
+		Json::Value input(Json::arrayValue);
+		input.append(GetInputKey(inputs[i]));
+		input.append(CHash::ToString(hash));
+
+		objectHash.Update(input[0].asString());
+		objectHash.Update(input[1].asString());
+		entryInputs.append(input);
+	}
+
+	const std::string objectKey = CHash::ToString(objectHash.Digest());
+	entry["object"] = objectKey;
+
+	// Object
+	std::error_code error;
+	const std::filesystem::path objectPath = GetObjectPath(objectKey);
+	if (std::filesystem::exists(objectPath, error) == false) {
+		std::filesystem::create_directories(objectPath.parent_path(), error);
+
+		const std::filesystem::path tempPath = GetTempPath(objectPath);
+		if (CloneFile(outPath, tempPath) == false) {
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+
+		std::filesystem::rename(tempPath, objectPath, error);
+		if (error) {
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+	}
+
+	// Manifest
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	const std::filesystem::path manifestPath = GetManifestPath(key);
+
+	Json::Value manifest;
+	std::ifstream file(manifestPath);
+	Json::CharReaderBuilder builder;
+	if ((file.good() == false) || (Json::parseFromStream(builder, file, &manifest, nullptr) == false) || (manifest["entries"].isArray() == false))
+		manifest["entries"] = Json::Value(Json::arrayValue);
+
+	file.close();
+
+	Json::Value& entries = manifest["entries"];
+	for (Json::ArrayIndex i = 0; i < entries.size(); ++i) {
+		if (entries[i]["object"] == objectKey) {
+			++m_nStores;
+			return true; // Other build stored it
+		}
+	}
+
+	entries.append(entry);
+	while (entries.size() > DELTAMAKE_CACHE_MAX_ENTRIES) {
+		Json::Value removed;
+		entries.removeIndex(0, &removed);
+	}
+
+	std::filesystem::create_directories(manifestPath.parent_path(), error);
+
+	const std::filesystem::path tempPath = GetTempPath(manifestPath);
+	std::ofstream out(tempPath);
+	Json::FastWriter writer;
+	out << writer.write(manifest);
+	out.close();
+
+	if (out.fail() == true) {
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+
+	std::filesystem::rename(tempPath, manifestPath, error);
+	if (error) {
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+
+	++m_nStores;
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CObjectCache::Trim
+ */
+void DeltaMake::CObjectCache::Trim() {
+	if (m_bEnabled == false)
+		return;
+
+	struct SObject {
+		std::filesystem::path			path;
+		std::filesystem::file_time_type	time;
+		uint64_t						size;
+	};
+
+	std::vector<SObject> objects;
+	uint64_t totalSize = 0;
+
+	std::error_code error;
+	for (auto iterator = std::filesystem::recursive_directory_iterator(m_path / DELTAMAKE_CACHE_OBJECTS, error); iterator != std::filesystem::recursive_directory_iterator(); iterator.increment(error)) {
+		if (error)
+			break;
+
+		if (iterator->is_regular_file(error) == false)
+			continue;
+
+		SObject object;
+		object.path = iterator->path();
+		object.time = iterator->last_write_time(error);
+		object.size = iterator->file_size(error);
+		if (error)
+			continue;
+
+		totalSize += object.size;
+		objects.push_back(object);
+	}
+
+	if (totalSize <= m_maxSize)
+		return;
+
+	std::sort(objects.begin(), objects.end(), [](const SObject& a, const SObject& b) { return a.time < b.time; });
+
+	const uint64_t targetSize = static_cast<uint64_t>(m_maxSize * DELTAMAKE_CACHE_TRIM_RATIO);
+
+	size_t nEvicted = 0;
+	for (size_t i = 0; (i < objects.size()) && (totalSize > targetSize); ++i) {
+		if (std::filesystem::remove(objects[i].path, error) == false)
+			continue;
+
+		totalSize -= objects[i].size;
+		++nEvicted;
+	}
+
+	terminal->Log(LOG_DETAIL, "Cache: %zu objects are evicted\n", nEvicted);
+}
+
+/* ****************************************
+ * DeltaMake::CObjectCache::ShowStats
+ */
+void DeltaMake::CObjectCache::ShowStats() const {
+	if (m_bEnabled == false)
+		return;
+
+	const size_t nHits = m_nHits;
+	const size_t nMisses = m_nMisses;
+	const size_t nTotal = nHits + nMisses;
+
+	terminal->Log(
+		LOG_INFO,
+		"Cache: %zu hits, %zu misses (%.1f%%), %zu stored\n",
+		nHits,
+		nMisses,
+		(nTotal == 0) ? 0.0 : (100.0 * nHits / nTotal),
+		static_cast<size_t>(m_nStores)
+	);
+}
+
+/* ****************************************
+ * DeltaMake::CObjectCache::GetManifestPath
+ */
+std::filesystem::path DeltaMake::CObjectCache::GetManifestPath(const std::string& key) const {
+	return m_path / DELTAMAKE_CACHE_MANIFESTS / key.substr(0, 2) / key;
+}
+
+/* ****************************************
+ * DeltaMake::CObjectCache::GetObjectPath
+ */
+std::filesystem::path DeltaMake::CObjectCache::GetObjectPath(const std::string& key) const {
+	return m_path / DELTAMAKE_CACHE_OBJECTS / key.substr(0, 2) / key;
+}
+
+/* ****************************************
+ * DeltaMake::CObjectCache::GetTempPath
+ */
+std::filesystem::path DeltaMake::CObjectCache::GetTempPath(const std::filesystem::path& path) {
+	return path.string() + ".tmp." + std::to_string(getpid()) + "." + std::to_string(m_nTemp++);
+}
+
+/* ****************************************
+ * DeltaMake::CObjectCache::GetInputKey
+ */
+std::string DeltaMake::CObjectCache::GetInputKey(const std::string& path) {
+	std::error_code error;
+	const std::filesystem::path relative = std::filesystem::proximate(path, error);
+	if ((error) || (relative.empty() == true) || (*relative.begin() == ".."))
+		return path;
+
+	return relative.string(); // Other checkouts may share it
+}
+
+/* ****************************************
+ * DeltaMake::CObjectCache::CloneFile
+ */
+bool DeltaMake::CObjectCache::CloneFile(const std::filesystem::path& from, const std::filesystem::path& to) {
+#if defined(FICLONE)
+	const int fromFD = open(from.c_str(), O_RDONLY);
+	if (fromFD < 0)
+		return false;
+
+	const int toFD = open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (toFD < 0) {
+		close(fromFD);
+		return false;
+	}
+
+	const bool bCloned = (ioctl(toFD, FICLONE, fromFD) == 0);
+	close(toFD);
+	close(fromFD);
+
+	if (bCloned == true)
+		return true;
+#endif
+
+	std::error_code error;
+	return std::filesystem::copy_file(from, to, std::filesystem::copy_options::overwrite_existing, error);
+}
@@ -0,0 +1,116 @@
+/**
+ * \file	Cache.h
+ * \brief	Content-addressed object cache
+ * \date	14 oct 2026
+ * \author	Reklov
+ */
+#ifndef __DELTAMAKE_CACHE_H__
+#define __DELTAMAKE_CACHE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <filesystem>
+
+#include "deltamake.h"
+
+
+#define DELTAMAKE_CACHE_ENV				"DELTAMAKE_CACHE_DIR"
+#define DELTAMAKE_CACHE_DEFAULT_SIZE	5120 // MiB
+#define DELTAMAKE_CACHE_TRIM_RATIO		0.9 // Of max size left after eviction
+#define DELTAMAKE_CACHE_MAX_ENTRIES		16 // Input sets in one manifest
+
+#define DELTAMAKE_CACHE_MANIFESTS		"manifests"
+#define DELTAMAKE_CACHE_OBJECTS			"objects"
+
+// ******************************************************************************** //
+
+										//										//
+namespace DeltaMake {
+	/**
+	 * Shared object cache, looked up before spawning the compiler
+	 *
+	 * Direct mode: the key of the manifest is a hash of the compiler, the command
+	 * and the source content. Manifest keeps sets of implicit inputs (headers)
+	 * with their content hashes, every set points to the object
+	 *
+	 * \warning `Fetch()` and `Store()` are called from the worker threads
+	 */
+	class CObjectCache final {
+		public:
+			/**
+			 * \param path Cache directory, `nullptr` disables the cache
+			 * \param maxSize Bytes of objects to keep
+			 */
+			bool						Init(const char path[], uint64_t maxSize);
+
+			bool						IsEnabled() const;
+
+			/**
+			 * \returns Hash of compiler executable path, size and modification time
+			 */
+			std::string					GetCompilerId(const std::string& compiler);
+
+			/**
+			 * Place cached object to `outPath` (reflink or copy)
+			 *
+			 * \param key Manifest key
+			 * \param rInputs Implicit inputs of the object
+			 * \returns `false` on miss, `outPath` is removed anyway
+			 */
+			bool						Fetch(const std::string& key, const std::filesystem::path& outPath, std::vector<std::string>& rInputs);
+
+			/**
+			 * Save compiled object with its implicit inputs
+			 */
+			bool						Store(const std::string& key, const std::filesystem::path& outPath, const std::vector<std::string>& inputs);
+
+			/**
+			 * Evict least recently used objects over the size limit
+			 */
+			void						Trim();
+
+			void						ShowStats() const;
+
+		private:
+			std::filesystem::path		GetManifestPath(const std::string& key) const;
+			std::filesystem::path		GetObjectPath(const std::string& key) const;
+
+			/**
+			 * \returns Unique path next to `path`, so other builds never see a partial file
+			 */
+			std::filesystem::path		GetTempPath(const std::filesystem::path& path);
+
+			/**
+			 * \returns Input path relative to the current path if it's inside
+			 */
+			static std::string			GetInputKey(const std::string& path);
+
+			/**
+			 * Reflink if the file system can, copy otherwise
+			 */
+			static bool					CloneFile(const std::filesystem::path& from, const std::filesystem::path& to);
+
+			std::filesystem::path		m_path;
+			uint64_t					m_maxSize								= 0;
+			bool						m_bEnabled								= false;
+
+			std::mutex					m_mutex; /* Manifests read-modify-write */
+			std::atomic<size_t>			m_nTemp									= 0;
+
+			std::map<std::string, std::string> m_compilers; /* Compiler -> id */
+
+			std::atomic<size_t>			m_nHits									= 0;
+			std::atomic<size_t>			m_nMisses								= 0;
+			std::atomic<size_t>			m_nStores								= 0;
+	};
+
+	extern CObjectCache* const objectCache;
+}
+
+#endif /* !__DELTAMAKE_CACHE_H__ */
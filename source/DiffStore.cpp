@@ -0,0 +1,466 @@
+/**
+ * \file	DiffStore.cpp
+ * \brief	Binary differential file and its journal
+ * \date	14 oct 2026
+ * \author	Reklov
+ */
+#include "DiffStore.h"
+
+#include <string.h>
+#include <errno.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <fstream>
+#include <map>
+
+#include "Terminal.h"
+#include "Hash.h"
+
+using namespace DeltaMake;
+
+// ******************************************************************************** //
+
+/* ****************************************
+ * DeltaMake::CDiffStore::Load
+ */
+bool DeltaMake::CDiffStore::Load(const char path[], Json::Value& rDiff) {
+	const int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return false;
+
+	struct stat stats;
+	if ((fstat(fd, &stats) != 0) || (stats.st_size < static_cast<off_t>(sizeof(SDiffHeader)))) {
+		close(fd);
+		return false;
+	}
+
+	const size_t size = static_cast<size_t>(stats.st_size);
+	void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (data == MAP_FAILED)
+		return false;
+
+	const bool bDecoded = Decode(data, size, rDiff);
+	munmap(data, size);
+
+	if (bDecoded == false)
+		terminal->Log(LOG_WARNING, "Binary diff \"%s\" is damaged. Ignoring...\n", path);
+
+	return bDecoded;
+}
+
+/* ****************************************
+ * DeltaMake::CDiffStore::Save
+ */
+bool DeltaMake::CDiffStore::Save(const char path[], const Json::Value& diff) {
+	std::string data;
+	Encode(diff, data);
+
+	const std::string tmpPath = std::string(path) + ".tmp";
+	{
+		std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+		file.write(data.data(), static_cast<std::streamsize>(data.size()));
+
+		if (file.good() == false) {
+			terminal->Log(LOG_ERROR, "Can't write \"%s\"\n", tmpPath.c_str());
+			return false;
+		}
+	}
+
+	if (rename(tmpPath.c_str(), path) != 0) {
+		terminal->Log(LOG_ERROR, "Can't replace \"%s\": %s\n", path, strerror(errno));
+		unlink(tmpPath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CDiffStore::Encode
+ */
+void DeltaMake::CDiffStore::Encode(const Json::Value& value, std::string& rData) {
+	std::vector<SDiffNode> nodes;
+	std::vector<SDiffString> strings;
+	std::string pool;
+	std::map<std::string, uint32_t> indices; // Member names repeat in every entry
+
+	auto intern = [&strings, &pool, &indices](const std::string& str) {
+		auto iterator = indices.emplace(str, static_cast<uint32_t>(strings.size()));
+		if (iterator.second == true) {
+			strings.push_back({ static_cast<uint32_t>(pool.size()), static_cast<uint32_t>(str.size()) });
+			pool += str;
+		}
+
+		return iterator.first->second;
+	};
+
+	// Breadth first, so children of a node are next to each other
+	std::vector<const Json::Value*> queue = { &value };
+	nodes.push_back(SDiffNode());
+	nodes[0].key = UINT32_MAX;
+
+	for (size_t i = 0; i < queue.size(); ++i) {
+		const Json::Value& current = *queue[i];
+
+		SDiffNode node = nodes[i];
+		node.type = static_cast<uint8_t>(current.type());
+		memset(node.reserved, 0, sizeof(node.reserved));
+		node.value = 0;
+
+		switch (current.type()) {
+			case Json::intValue: {
+				const int64_t number = current.asInt64();
+				memcpy(&node.value, &number, sizeof(number));
+				break;
+			}
+			case Json::uintValue:
+				node.value = current.asUInt64();
+				break;
+			case Json::realValue: {
+				const double number = current.asDouble();
+				memcpy(&node.value, &number, sizeof(number));
+				break;
+			}
+			case Json::stringValue:
+				node.value = intern(current.asString());
+				break;
+			case Json::booleanValue:
+				node.value = (current.asBool() == true) ? 1 : 0;
+				break;
+			case Json::arrayValue:
+			case Json::objectValue: {
+				node.value = (static_cast<uint64_t>(current.size()) << 32) | static_cast<uint64_t>(queue.size());
+
+				const bool bObject = current.type() == Json::objectValue;
+				for (auto iterator = current.begin(); iterator != current.end(); ++iterator) {
+					SDiffNode child = SDiffNode();
+					child.key = (bObject == true) ? intern(iterator.name()) : UINT32_MAX;
+
+					queue.push_back(&(*iterator));
+					nodes.push_back(child);
+				}
+				break;
+			}
+			default:
+				break;
+		}
+
+		nodes[i] = node;
+	}
+
+	SDiffHeader header;
+	memcpy(header.magic, DELTAMAKE_DIFF_BINARY_MAGIC, sizeof(header.magic));
+	header.format = DELTAMAKE_DIFF_FORMAT;
+	header.nNodes = static_cast<uint32_t>(nodes.size());
+	header.nStrings = static_cast<uint32_t>(strings.size());
+	header.poolSize = static_cast<uint32_t>(pool.size());
+
+	rData.clear();
+	rData.reserve(sizeof(header) + nodes.size() * sizeof(SDiffNode) + strings.size() * sizeof(SDiffString) + pool.size());
+	rData.append(reinterpret_cast<const char*>(&header), sizeof(header));
+	rData.append(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(SDiffNode));
+	rData.append(reinterpret_cast<const char*>(strings.data()), strings.size() * sizeof(SDiffString));
+	rData.append(pool);
+
+	CHash hash;
+	hash.Update(rData.data() + sizeof(header), rData.size() - sizeof(header));
+	header.checksum = hash.Digest();
+	memcpy(&rData[0], &header, sizeof(header));
+}
+
+/* ****************************************
+ * DeltaMake::CDiffStore::Decode
+ */
+bool DeltaMake::CDiffStore::Decode(const void* data, size_t size, Json::Value& rValue) {
+	if (size < sizeof(SDiffHeader))
+		return false;
+
+	if (reinterpret_cast<uintptr_t>(data) % alignof(SDiffNode) != 0) { // Records inside the journal
+		std::vector<uint64_t> aligned((size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+		memcpy(aligned.data(), data, size);
+
+		return Decode(aligned.data(), size, rValue);
+	}
+
+	SDiffHeader header;
+	memcpy(&header, data, sizeof(header));
+	if ((memcmp(header.magic, DELTAMAKE_DIFF_BINARY_MAGIC, sizeof(header.magic)) != 0) || (header.format != DELTAMAKE_DIFF_FORMAT) || (header.nNodes == 0))
+		return false;
+
+	const uint64_t expected = sizeof(header) + static_cast<uint64_t>(header.nNodes) * sizeof(SDiffNode) + static_cast<uint64_t>(header.nStrings) * sizeof(SDiffString) + header.poolSize;
+	if (expected != size)
+		return false;
+
+	const char* bytes = static_cast<const char*>(data);
+
+	CHash hash;
+	hash.Update(bytes + sizeof(header), size - sizeof(header));
+	if (hash.Digest() != header.checksum)
+		return false;
+
+	// Node and string tables stay aligned after the 32 bytes header
+	const SDiffNode* nodes = reinterpret_cast<const SDiffNode*>(bytes + sizeof(header));
+	const SDiffString* strings = reinterpret_cast<const SDiffString*>(nodes + header.nNodes);
+	const char* pool = reinterpret_cast<const char*>(strings + header.nStrings);
+
+	for (uint32_t i = 0; i < header.nStrings; ++i) {
+		if (static_cast<uint64_t>(strings[i].offset) + strings[i].size > header.poolSize)
+			return false;
+	}
+
+	rValue = Json::Value();
+	return DecodeNode(header, nodes, strings, pool, 0, 0, rValue);
+}
+
+/* ****************************************
+ * DeltaMake::CDiffStore::GetBinaryPath
+ */
+std::filesystem::path DeltaMake::CDiffStore::GetBinaryPath(const std::filesystem::path& path) {
+	return std::filesystem::path(path).replace_extension(DELTAMAKE_DIFF_BINARY_EXT);
+}
+
+/* ****************************************
+ * DeltaMake::CDiffStore::GetJournalPath
+ */
+std::filesystem::path DeltaMake::CDiffStore::GetJournalPath(const std::filesystem::path& path) {
+	return std::filesystem::path(path).replace_extension(DELTAMAKE_DIFF_JOURNAL_EXT);
+}
+
+/* ****************************************
+ * DeltaMake::CDiffStore::DecodeNode
+ */
+bool DeltaMake::CDiffStore::DecodeNode(const SDiffHeader& header, const SDiffNode* nodes, const SDiffString* strings, const char* pool, uint32_t index, size_t depth, Json::Value& rValue) {
+	if (depth > DELTAMAKE_DIFF_MAX_DEPTH)
+		return false;
+
+	const SDiffNode& node = nodes[index];
+	switch (static_cast<Json::ValueType>(node.type)) {
+		case Json::nullValue:
+			rValue = Json::Value();
+			return true;
+		case Json::intValue: {
+			int64_t number;
+			memcpy(&number, &node.value, sizeof(number));
+			rValue = static_cast<Json::Int64>(number);
+			return true;
+		}
+		case Json::uintValue:
+			rValue = static_cast<Json::UInt64>(node.value);
+			return true;
+		case Json::realValue: {
+			double number;
+			memcpy(&number, &node.value, sizeof(number));
+			rValue = number;
+			return true;
+		}
+		case Json::stringValue: {
+			if (node.value >= header.nStrings)
+				return false;
+
+			const SDiffString& string = strings[node.value];
+			rValue = Json::Value(pool + string.offset, pool + string.offset + string.size);
+			return true;
+		}
+		case Json::booleanValue:
+			rValue = node.value != 0;
+			return true;
+		case Json::arrayValue:
+		case Json::objectValue:
+			break;
+		default:
+			return false;
+	}
+
+	const uint32_t first = static_cast<uint32_t>(node.value);
+	const uint32_t count = static_cast<uint32_t>(node.value >> 32);
+
+	// Children are always after the parent, so there are no loops
+	if ((first <= index) || (static_cast<uint64_t>(first) + count > header.nNodes))
+		return false;
+
+	const bool bObject = node.type == Json::objectValue;
+	rValue = Json::Value(bObject == true ? Json::objectValue : Json::arrayValue);
+
+	for (uint32_t i = first; i < first + count; ++i) {
+		Json::Value child;
+		if (DecodeNode(header, nodes, strings, pool, i, depth + 1, child) == false)
+			return false;
+
+		if (bObject == false) {
+			rValue.append(std::move(child));
+			continue;
+		}
+
+		if (nodes[i].key >= header.nStrings)
+			return false;
+
+		const SDiffString& key = strings[nodes[i].key];
+		rValue[Json::String(pool + key.offset, key.size)].swap(child);
+	}
+
+	return true;
+}
+
+// ******************************************************************************** //
+
+/* ****************************************
+ * DeltaMake::CDiffJournal::~CDiffJournal
+ */
+DeltaMake::CDiffJournal::~CDiffJournal() {
+	Close();
+}
+
+/* ****************************************
+ * DeltaMake::CDiffJournal::Open
+ */
+bool DeltaMake::CDiffJournal::Open(const char path[]) {
+	Close();
+
+	m_fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	if (m_fd < 0)
+		return false;
+
+	std::string content;
+	char buffer[65536];
+	ssize_t nRead;
+	while ((nRead = read(m_fd, buffer, sizeof(buffer))) > 0)
+		content.append(buffer, nRead);
+
+	// Records after a torn one would never be replayed
+	size_t end = 0;
+	ApplyRecords(content, nullptr, end);
+	if ((nRead < 0) || ((end != content.size()) && (ftruncate(m_fd, end) != 0))) {
+		Close();
+		return false;
+	}
+
+	if (end != content.size())
+		terminal->Log(LOG_DETAIL, "Diff journal \"%s\" is cut to %zu of %zu bytes\n", path, end, content.size());
+
+	if (end == 0) { // New or damaged journal
+		if (write(m_fd, DELTAMAKE_DIFF_JOURNAL_MAGIC, 8) != 8) {
+			Close();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CDiffJournal::Close
+ */
+void DeltaMake::CDiffJournal::Close() {
+	if (m_fd < 0)
+		return;
+
+	close(m_fd);
+	m_fd = -1;
+}
+
+/* ****************************************
+ * DeltaMake::CDiffJournal::IsOpen
+ */
+bool DeltaMake::CDiffJournal::IsOpen() const {
+	return m_fd >= 0;
+}
+
+/* ****************************************
+ * DeltaMake::CDiffJournal::Write
+ */
+bool DeltaMake::CDiffJournal::Write(const std::vector<Json::String>& keys, const Json::Value& value) {
+	if (m_fd < 0)
+		return false;
+
+	Json::Value record = Json::Value(Json::arrayValue);
+	Json::Value& path = record.append(Json::Value(Json::arrayValue));
+	for (size_t i = 0; i < keys.size(); ++i)
+		path.append(keys[i]);
+
+	record.append(value);
+
+	std::string payload;
+	CDiffStore::Encode(record, payload);
+
+	SDiffRecord header;
+	header.size = static_cast<uint32_t>(payload.size());
+	header.reserved = 0;
+
+	CHash hash;
+	hash.Update(payload);
+	header.checksum = hash.Digest();
+
+	payload.insert(0, reinterpret_cast<const char*>(&header), sizeof(header));
+
+	// A killed build may leave a part of the last record only
+	return write(m_fd, payload.data(), payload.size()) == static_cast<ssize_t>(payload.size());
+}
+
+/* ****************************************
+ * DeltaMake::CDiffJournal::Replay
+ */
+size_t DeltaMake::CDiffJournal::Replay(const char path[], Json::Value& rDiff) {
+	std::ifstream file(path, std::ios::binary);
+	if (file.good() == false)
+		return 0;
+
+	const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if ((content.size() < 8) || (memcmp(content.data(), DELTAMAKE_DIFF_JOURNAL_MAGIC, 8) != 0)) {
+		terminal->Log(LOG_WARNING, "Diff journal \"%s\" is damaged. Ignoring...\n", path);
+		return 0;
+	}
+
+	size_t end;
+	return ApplyRecords(content, &rDiff, end);
+}
+
+/* ****************************************
+ * DeltaMake::CDiffJournal::ApplyRecords
+ */
+size_t DeltaMake::CDiffJournal::ApplyRecords(const std::string& content, Json::Value* pDiff, size_t& rEnd) {
+	rEnd = 0;
+	if ((content.size() < 8) || (memcmp(content.data(), DELTAMAKE_DIFF_JOURNAL_MAGIC, 8) != 0))
+		return 0;
+
+	size_t nApplied = 0;
+	for (rEnd = 8; rEnd + sizeof(SDiffRecord) <= content.size();) {
+		SDiffRecord header;
+		memcpy(&header, content.data() + rEnd, sizeof(header));
+
+		const size_t offset = rEnd + sizeof(header);
+		if (header.size > content.size() - offset)
+			break; // Torn last record
+
+		CHash hash;
+		hash.Update(content.data() + offset, header.size);
+
+		Json::Value record;
+		if ((hash.Digest() != header.checksum) || (CDiffStore::Decode(content.data() + offset, header.size, record) == false) || (record.size() != 2) || (record[0].isArray() == false))
+			break;
+
+		rEnd = offset + header.size;
+		++nApplied;
+
+		if (pDiff == nullptr)
+			continue;
+
+		Json::Value* target = pDiff;
+		const Json::Value& keys = record[0];
+		for (Json::ArrayIndex i = 0; i < keys.size(); ++i) {
+			if (target->isObject() == false)
+				*target = Json::Value(Json::objectValue);
+
+			target = &(*target)[keys[i].asString()];
+		}
+
+		target->swap(record[1]);
+	}
+
+	return nApplied;
+}
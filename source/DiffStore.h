@@ -0,0 +1,152 @@
+/**
+ * \file	DiffStore.h
+ * \brief	Binary differential file and its journal
+ * \date	14 oct 2026
+ * \author	Reklov
+ */
+#ifndef __DELTAMAKE_DIFF_STORE_H__
+#define __DELTAMAKE_DIFF_STORE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <json/json.h>
+
+#include "deltamake.h"
+
+
+#define DELTAMAKE_DIFF_BINARY_EXT		".bin" // Replaces `.json` of the diff
+#define DELTAMAKE_DIFF_JOURNAL_EXT		".journal"
+#define DELTAMAKE_DIFF_BINARY_MAGIC		"DMDIFF\0" // 8 bytes with the terminator
+#define DELTAMAKE_DIFF_JOURNAL_MAGIC	"DMJRNL\0"
+#define DELTAMAKE_DIFF_FORMAT			1 // Layout version of both files
+#define DELTAMAKE_DIFF_MAX_DEPTH		64 // Of nested values, the diff has 5 levels
+
+// ******************************************************************************** //
+
+										//										//
+namespace DeltaMake {
+	/**
+	 * Header of the binary diff, followed by the node table, the string table and the string pool
+	 */
+	struct SDiffHeader {
+		char							magic[8];
+		uint32_t						format;
+		uint32_t						nNodes;
+		uint32_t						nStrings;
+		uint32_t						poolSize; /* Bytes */
+		uint64_t						checksum; /* Of everything after the header */
+	};
+
+	/**
+	 * Value of the diff tree, children of arrays and objects are next to each other
+	 */
+	struct SDiffNode {
+		uint8_t							type; /* `Json::ValueType` */
+		uint8_t							reserved[3];
+		uint32_t						key; /* String index of the member name, `UINT32_MAX` in arrays */
+		uint64_t						value; /* Number bits, string index, or first child and count (high 32 bits) */
+	};
+
+	/**
+	 * String of the pool
+	 */
+	struct SDiffString {
+		uint32_t						offset;
+		uint32_t						size;
+	};
+
+	/**
+	 * Journal record header, followed by the encoded `[keys, value]`
+	 */
+	struct SDiffRecord {
+		uint32_t						size; /* Bytes after the header */
+		uint32_t						reserved;
+		uint64_t						checksum; /* Of the bytes after the header, torn records are ignored */
+	};
+
+	/**
+	 * Diff as a fixed-layout node table plus a string pool (`--binary-diff`)
+	 *
+	 * Member names and strings are stored once, so the file is mapped and
+	 * turned into `Json::Value` without parsing any text
+	 */
+	class CDiffStore final {
+		public:
+			/**
+			 * \returns `false` if the file doesn't exist or is not a valid diff
+			 */
+			static bool					Load(const char path[], Json::Value& rDiff);
+
+			/**
+			 * Written to a temporary file first, so an interrupted save keeps the old diff
+			 */
+			static bool					Save(const char path[], const Json::Value& diff);
+
+			/**
+			 * \param rData Header, tables and pool
+			 */
+			static void					Encode(const Json::Value& value, std::string& rData);
+
+			/**
+			 * \returns `false` if the data is not a valid encoded value
+			 */
+			static bool					Decode(const void* data, size_t size, Json::Value& rValue);
+
+			/**
+			 * \param path Path of the JSON diff
+			 */
+			static std::filesystem::path GetBinaryPath(const std::filesystem::path& path);
+			static std::filesystem::path GetJournalPath(const std::filesystem::path& path);
+
+		private:
+			static bool					DecodeNode(const SDiffHeader& header, const SDiffNode* nodes, const SDiffString* strings, const char* pool, uint32_t index, size_t depth, Json::Value& rValue);
+	};
+
+	/**
+	 * Append-only log of the diff entries of the finished tasks
+	 *
+	 * Every record replaces one value of the diff, so an interrupted build
+	 * keeps the entries of its finished tasks, the next save removes the journal
+	 */
+	class CDiffJournal final {
+		public:
+										~CDiffJournal();
+
+			/**
+			 * Records are appended to the existing ones, a torn last record of a killed build is cut off first
+			 */
+			bool						Open(const char path[]);
+			void						Close();
+			bool						IsOpen() const;
+
+			/**
+			 * Record `value` of the member at `keys`, one `write()` per record
+			 */
+			bool						Write(const std::vector<Json::String>& keys, const Json::Value& value);
+
+			/**
+			 * Set the recorded values in the diff, in the order they were written
+			 *
+			 * \returns Number of applied records
+			 */
+			static size_t				Replay(const char path[], Json::Value& rDiff);
+
+		private:
+			/**
+			 * Set the values of the valid records in `pDiff`, if it's not `nullptr`
+			 *
+			 * \param rEnd Size of the journal up to the first invalid record, 0 if the header is invalid
+			 * \returns Number of valid records
+			 */
+			static size_t				ApplyRecords(const std::string& content, Json::Value* pDiff, size_t& rEnd);
+
+			int							m_fd									= -1;
+	};
+}
+
+#endif /* !__DELTAMAKE_DIFF_STORE_H__ */
@@ -0,0 +1,77 @@
+/**
+ * \file	FileStat.cpp
+ * \brief	Batched file metadata
+ * \date	14 oct 2026
+ * \author	Reklov
+ */
+#include "FileStat.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+using namespace DeltaMake;
+
+// ******************************************************************************** //
+
+/* ****************************************
+ * DeltaMake::CFileStat::Get
+ */
+bool DeltaMake::CFileStat::Get(const char path[], SFileStat& rStat) {
+	rStat = SFileStat();
+
+	// glibc emulates it with `fstatat()` on old kernels
+	struct statx stats;
+	if (statx(AT_FDCWD, path, AT_STATX_SYNC_AS_STAT, STATX_TYPE | STATX_MTIME | STATX_SIZE, &stats) != 0)
+		return false;
+
+	rStat.bExists = true;
+	rStat.bRegular = S_ISREG(stats.stx_mode) != 0;
+	rStat.mtime = static_cast<time_t>(stats.stx_mtime.tv_sec);
+	rStat.mtimeNs = static_cast<int64_t>(stats.stx_mtime.tv_sec) * 1000000000 + stats.stx_mtime.tv_nsec;
+	rStat.size = stats.stx_size;
+
+	return true;
+}
+
+/* ****************************************
+ * GetAll
+ */
+template<typename T>
+static void GetAll(const std::vector<T>& paths, std::vector<SFileStat>& rStats, const char* (*cstr)(const T&)) {
+	rStats.resize(paths.size());
+
+	std::atomic<size_t> next = 0;
+	auto routine = [&paths, &rStats, &next, cstr]() {
+		for (size_t i = next++; i < paths.size(); i = next++)
+			CFileStat::Get(cstr(paths[i]), rStats[i]);
+	};
+
+	const size_t nThreads = std::min<size_t>(std::max<size_t>(config->nCores, DELTAMAKE_STAT_MIN_THREADS), paths.size() / DELTAMAKE_STAT_BATCH);
+
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < nThreads; ++i)
+		threads.emplace_back(routine);
+
+	routine();
+
+	for (size_t i = 0; i < threads.size(); ++i)
+		threads[i].join();
+}
+
+/* ****************************************
+ * DeltaMake::CFileStat::GetAll
+ */
+void DeltaMake::CFileStat::GetAll(const std::vector<std::filesystem::path>& paths, std::vector<SFileStat>& rStats) {
+	::GetAll<std::filesystem::path>(paths, rStats, [](const std::filesystem::path& path) { return path.c_str(); });
+}
+
+/* ****************************************
+ * DeltaMake::CFileStat::GetAll
+ */
+void DeltaMake::CFileStat::GetAll(const std::vector<const char*>& paths, std::vector<SFileStat>& rStats) {
+	::GetAll<const char*>(paths, rStats, [](const char* const& path) { return path; });
+}
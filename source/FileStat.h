@@ -0,0 +1,58 @@
+/**
+ * \file	FileStat.h
+ * \brief	Batched file metadata
+ * \date	14 oct 2026
+ * \author	Reklov
+ */
+#ifndef __DELTAMAKE_FILE_STAT_H__
+#define __DELTAMAKE_FILE_STAT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <filesystem>
+#include <vector>
+
+#include "deltamake.h"
+
+
+#define DELTAMAKE_STAT_MIN_THREADS		8 // On NFS every `statx()` waits for the server, not for the CPU
+#define DELTAMAKE_STAT_BATCH			256 // Files per thread, less of them are not worth a thread
+
+// ******************************************************************************** //
+
+										//										//
+namespace DeltaMake {
+	/**
+	 * File metadata of one `statx()`
+	 */
+	struct SFileStat {
+		bool							bExists									= false;
+		bool							bRegular								= false; /* Not a directory or a device */
+		time_t							mtime									= 0; /* s */
+		int64_t							mtimeNs									= 0; /* ns since the epoch */
+		uint64_t						size									= 0; /* Bytes */
+	};
+
+	/**
+	 * `statx()` of files, one call per file
+	 */
+	class CFileStat final {
+		public:
+			/**
+			 * \returns `false` if the file doesn't exist or can't be accessed
+			 */
+			static bool					Get(const char path[], SFileStat& rStat);
+
+			/**
+			 * Metadata of all the files, on several threads if there are many of them
+			 *
+			 * \param rStats Same order as `paths`
+			 */
+			static void					GetAll(const std::vector<std::filesystem::path>& paths, std::vector<SFileStat>& rStats);
+			static void					GetAll(const std::vector<const char*>& paths, std::vector<SFileStat>& rStats);
+	};
+}
+
+#endif /* !__DELTAMAKE_FILE_STAT_H__ */
@@ -0,0 +1,192 @@
+/**
+ * \file	Hash.cpp
+ * \brief	Fast non-cryptographic hashing
+ * \date	14 oct 2026
+ * \author	Reklov
+ */
+#include "Hash.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace DeltaMake;
+
+// ******************************************************************************** //
+
+#define HASH_PRIME_1					0x9E3779B185EBCA87ull
+#define HASH_PRIME_2					0xC2B2AE3D27D4EB4Full
+#define HASH_PRIME_3					0x165667B19E3779F9ull
+#define HASH_PRIME_4					0x85EBCA77C2B2AE63ull
+#define HASH_PRIME_5					0x27D4EB2F165667C5ull
+
+#define HASH_FILE_BUFFER_SIZE			65536
+
+										//										//
+
+static inline uint64_t RotateLeft(uint64_t value, int bits) {
+	return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t Read64(const uint8_t* data) {
+	uint64_t value;
+	memcpy(&value, data, sizeof(value)); // Little-endian hosts only, as everything else here
+
+	return value;
+}
+
+static inline uint32_t Read32(const uint8_t* data) {
+	uint32_t value;
+	memcpy(&value, data, sizeof(value));
+
+	return value;
+}
+
+static inline uint64_t Round(uint64_t acc, uint64_t input) {
+	acc += input * HASH_PRIME_2;
+	acc = RotateLeft(acc, 31);
+
+	return acc * HASH_PRIME_1;
+}
+
+static inline uint64_t MergeRound(uint64_t acc, uint64_t value) {
+	acc ^= Round(0, value);
+
+	return acc * HASH_PRIME_1 + HASH_PRIME_4;
+}
+
+// ******************************************************************************** //
+
+/* ****************************************
+ * CHash::CHash
+ */
+CHash::CHash(uint64_t seed) : m_seed(seed) {
+	m_acc[0] = seed + HASH_PRIME_1 + HASH_PRIME_2;
+	m_acc[1] = seed + HASH_PRIME_2;
+	m_acc[2] = seed;
+	m_acc[3] = seed - HASH_PRIME_1;
+}
+
+/* ****************************************
+ * CHash::Update
+ */
+void CHash::Update(const void* data, size_t size) {
+	const uint8_t* input = static_cast<const uint8_t*>(data);
+	m_totalSize += size;
+
+	// Fill the stripe left from the last call
+	if (m_bufferSize != 0) {
+		const size_t n = ((sizeof(m_buffer) - m_bufferSize) < size) ? (sizeof(m_buffer) - m_bufferSize) : size;
+		memcpy(m_buffer + m_bufferSize, input, n);
+		m_bufferSize += n;
+		input += n;
+		size -= n;
+
+		if (m_bufferSize != sizeof(m_buffer))
+			return;
+
+		for (size_t i = 0; i < 4; ++i)
+			m_acc[i] = Round(m_acc[i], Read64(m_buffer + i * 8));
+
+		m_bufferSize = 0;
+	}
+
+	while (size >= sizeof(m_buffer)) {
+		for (size_t i = 0; i < 4; ++i)
+			m_acc[i] = Round(m_acc[i], Read64(input + i * 8));
+
+		input += sizeof(m_buffer);
+		size -= sizeof(m_buffer);
+	}
+
+	memcpy(m_buffer, input, size);
+	m_bufferSize = size;
+}
+
+/* ****************************************
+ * CHash::Update
+ */
+void CHash::Update(const std::string& str) {
+	Update(str.data(), str.size());
+}
+
+/* ****************************************
+ * CHash::Digest
+ */
+uint64_t CHash::Digest() const {
+	uint64_t hash;
+
+	if (m_totalSize >= sizeof(m_buffer)) {
+		hash = RotateLeft(m_acc[0], 1) + RotateLeft(m_acc[1], 7) + RotateLeft(m_acc[2], 12) + RotateLeft(m_acc[3], 18);
+		for (size_t i = 0; i < 4; ++i)
+			hash = MergeRound(hash, m_acc[i]);
+	}
+	else
+		hash = m_seed + HASH_PRIME_5;
+
+	hash += m_totalSize;
+
+	const uint8_t* input = m_buffer;
+	size_t size = m_bufferSize;
+
+	for (; size >= 8; size -= 8, input += 8) {
+		hash ^= Round(0, Read64(input));
+		hash = RotateLeft(hash, 27) * HASH_PRIME_1 + HASH_PRIME_4;
+	}
+
+	if (size >= 4) {
+		hash ^= static_cast<uint64_t>(Read32(input)) * HASH_PRIME_1;
+		hash = RotateLeft(hash, 23) * HASH_PRIME_2 + HASH_PRIME_3;
+		input += 4;
+		size -= 4;
+	}
+
+	for (; size != 0; --size, ++input) {
+		hash ^= (*input) * HASH_PRIME_5;
+		hash = RotateLeft(hash, 11) * HASH_PRIME_1;
+	}
+
+	// Avalanche
+	hash ^= hash >> 33;
+	hash *= HASH_PRIME_2;
+	hash ^= hash >> 29;
+	hash *= HASH_PRIME_3;
+	hash ^= hash >> 32;
+
+	return hash;
+}
+
+/* ****************************************
+ * CHash::ToString
+ */
+std::string CHash::ToString(uint64_t hash) {
+	char buffer[17];
+	snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(hash));
+
+	return buffer;
+}
+
+/* ****************************************
+ * CHash::HashFile
+ */
+bool CHash::HashFile(const char path[], uint64_t& rHash) {
+	FILE* file = fopen(path, "rb");
+	if (file == NULL)
+		return false;
+
+	CHash hash;
+	uint8_t buffer[HASH_FILE_BUFFER_SIZE];
+
+	size_t nRead;
+	while ((nRead = fread(buffer, 1, sizeof(buffer), file)) != 0)
+		hash.Update(buffer, nRead);
+
+	const bool bError = (ferror(file) != 0);
+	fclose(file);
+
+	if (bError == true)
+		return false;
+
+	rHash = hash.Digest();
+
+	return true;
+}
@@ -0,0 +1,56 @@
+/**
+ * \file	Hash.h
+ * \brief	Fast non-cryptographic hashing
+ * \date	14 oct 2026
+ * \author	Reklov
+ */
+#ifndef __DELTAMAKE_HASH_H__
+#define __DELTAMAKE_HASH_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+// ******************************************************************************** //
+
+										//										//
+namespace DeltaMake {
+	/**
+	 * Streaming XXH64
+	 */
+	class CHash final {
+		public:
+										CHash(uint64_t seed = 0);
+
+			void						Update(const void* data, size_t size);
+			void						Update(const std::string& str);
+
+			/**
+			 * \returns Hash of all data so far (the state is not changed)
+			 */
+			uint64_t					Digest() const;
+
+			/**
+			 * \returns 16 hex digits
+			 */
+			static std::string			ToString(uint64_t hash);
+
+			/**
+			 * Hash whole file content
+			 *
+			 * \returns `false` if file can't be read
+			 */
+			static bool					HashFile(const char path[], uint64_t& rHash);
+
+		private:
+			uint64_t					m_acc[4];
+			uint64_t					m_seed;
+			uint64_t					m_totalSize								= 0;
+
+			uint8_t						m_buffer[32]; /* Not full stripe */
+			size_t						m_bufferSize							= 0;
+	};
+}
+
+#endif /* !__DELTAMAKE_HASH_H__ */
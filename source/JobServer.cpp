@@ -0,0 +1,226 @@
+/**
+ * \file	JobServer.cpp
+ * \brief	GNU make jobserver
+ * \date	14 oct 2026
+ * \author	Reklov
+ */
+#include "JobServer.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+
+#include "Terminal.h"
+
+using namespace DeltaMake;
+
+// ******************************************************************************** //
+
+DeltaMake::CJobServer g_jobServer;
+extern DeltaMake::CJobServer* const DeltaMake::jobServer = &g_jobServer;
+
+// ******************************************************************************** //
+
+/* ****************************************
+ * DeltaMake::CJobServer::~CJobServer
+ */
+DeltaMake::CJobServer::~CJobServer() {
+	if ((m_tokenFD >= 0) && (m_tokenFD != m_readFD))
+		close(m_tokenFD);
+
+	if (m_bOwnFDs == false)
+		return;
+
+	if (m_readFD >= 0)
+		close(m_readFD);
+
+	if ((m_writeFD >= 0) && (m_writeFD != m_readFD))
+		close(m_writeFD);
+}
+
+/* ****************************************
+ * DeltaMake::CJobServer::Init
+ */
+void DeltaMake::CJobServer::Init(size_t nJobs) {
+	const char* makeFlags = getenv("MAKEFLAGS");
+	if ((makeFlags != nullptr) && (InitClient(makeFlags) == true)) {
+		terminal->Log(LOG_DETAIL, "Jobserver of the parent is used\n");
+		InitTokenFD();
+		return;
+	}
+
+	if (InitServer(nJobs) == true) {
+		terminal->Log(LOG_DETAIL, "Jobserver: %zu jobs\n", nJobs);
+		InitTokenFD();
+	}
+}
+
+/* ****************************************
+ * DeltaMake::CJobServer::Acquire
+ */
+bool DeltaMake::CJobServer::Acquire(const std::atomic<bool>& bCancel) {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_bImplicit == false) {
+			m_bImplicit = true;
+			return true;
+		}
+	}
+
+	if (m_readFD < 0)
+		return true; // No jobserver, no limits
+
+	pollfd pfd;
+	pfd.fd = m_tokenFD;
+	pfd.events = POLLIN;
+
+	while (bCancel == false) {
+		const int ready = poll(&pfd, 1, DELTAMAKE_JOBSERVER_POLL_DELAY);
+		if ((ready < 0) && (errno != EINTR))
+			return true; // Broken jobserver must not stop the build
+
+		if (ready <= 0)
+			continue;
+
+		// Other process may be faster, then it's polled again and `bCancel` is checked
+		char token;
+		const ssize_t nRead = read(m_tokenFD, &token, 1);
+		if (nRead == 1) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_tokens.push_back(token);
+			return true;
+		}
+
+		if ((nRead == 0) || ((errno != EINTR) && (errno != EAGAIN)))
+			return true;
+	}
+
+	return false;
+}
+
+/* ****************************************
+ * DeltaMake::CJobServer::Release
+ */
+void DeltaMake::CJobServer::Release() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_tokens.size() == 0) {
+		m_bImplicit = false;
+		return;
+	}
+
+	const char token = m_tokens.back();
+	m_tokens.pop_back();
+
+	ssize_t nWritten;
+	do {
+		nWritten = write(m_writeFD, &token, 1);
+	} while ((nWritten < 0) && (errno == EINTR));
+}
+
+/* ****************************************
+ * DeltaMake::CJobServer::InitClient
+ */
+bool DeltaMake::CJobServer::InitClient(const char makeFlags[]) {
+	const char* auth = strstr(makeFlags, "--jobserver-auth=");
+	if (auth != nullptr)
+		auth += strlen("--jobserver-auth=");
+	else {
+		auth = strstr(makeFlags, "--jobserver-fds="); // Before make 4.2
+		if (auth == nullptr)
+			return false;
+
+		auth += strlen("--jobserver-fds=");
+	}
+
+	const std::string value(auth, strcspn(auth, " \t"));
+
+	if (value.compare(0, 5, "fifo:") == 0) { // make 4.4
+		const int fd = open(value.c_str() + 5, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+		if (fd < 0) {
+			terminal->Log(LOG_WARNING, "Can't open jobserver \"%s\"\n", value.c_str() + 5);
+			return false;
+		}
+
+		m_readFD = fd;
+		m_writeFD = fd;
+		m_bOwnFDs = true;
+
+		return true;
+	}
+
+	int readFD;
+	int writeFD;
+	if (sscanf(value.c_str(), "%d,%d", &readFD, &writeFD) != 2)
+		return false;
+
+	// Parent make doesn't pass them to commands without `+`
+	if ((fcntl(readFD, F_GETFD) < 0) || (fcntl(writeFD, F_GETFD) < 0)) {
+		terminal->Log(LOG_WARNING, "Jobserver of the parent is not available, mark the rule with `+`\n");
+		return false;
+	}
+
+	m_readFD = readFD;
+	m_writeFD = writeFD;
+
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CJobServer::InitServer
+ */
+bool DeltaMake::CJobServer::InitServer(size_t nJobs) {
+	int fds[2];
+	if (pipe(fds) != 0) // Without `O_CLOEXEC`, the children need them
+		return false;
+
+	// The implicit token is not in the pipe
+	const std::string tokens(nJobs - 1, DELTAMAKE_JOBSERVER_TOKEN);
+	if ((tokens.size() != 0) && (write(fds[1], tokens.data(), tokens.size()) != static_cast<ssize_t>(tokens.size()))) {
+		close(fds[0]);
+		close(fds[1]);
+		return false;
+	}
+
+	m_readFD = fds[0];
+	m_writeFD = fds[1];
+	m_bOwnFDs = true;
+
+	// Children (`make` of `pre`/`post` or commands) take tokens there too
+	std::string makeFlags = "-j" + std::to_string(nJobs) + " --jobserver-auth=" + std::to_string(m_readFD) + "," + std::to_string(m_writeFD);
+
+	const char* oldFlags = getenv("MAKEFLAGS");
+	if ((oldFlags != nullptr) && (oldFlags[0] != '\0'))
+		makeFlags = std::string(oldFlags) + " " + makeFlags;
+
+	setenv("MAKEFLAGS", makeFlags.c_str(), 1);
+
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CJobServer::InitTokenFD
+ */
+void DeltaMake::CJobServer::InitTokenFD() {
+	m_tokenFD = m_readFD;
+
+	// The fifo is opened non-blocking, it is only ours
+	const int flags = fcntl(m_readFD, F_GETFL);
+	if ((flags >= 0) && ((flags & O_NONBLOCK) != 0))
+		return;
+
+	// `dup()` would share `O_NONBLOCK` with `make` and the children, a new open of the pipe doesn't
+	const std::string path = "/proc/self/fd/" + std::to_string(m_readFD);
+	const int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+	if (fd >= 0) {
+		m_tokenFD = fd;
+		return;
+	}
+
+	terminal->Log(LOG_DETAIL, "Can't open \"%s\", a token is waited for without cancel checks\n", path.c_str());
+}
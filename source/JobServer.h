@@ -0,0 +1,82 @@
+/**
+ * \file	JobServer.h
+ * \brief	GNU make jobserver
+ * \date	14 oct 2026
+ * \author	Reklov
+ */
+#ifndef __DELTAMAKE_JOBSERVER_H__
+#define __DELTAMAKE_JOBSERVER_H__
+
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+
+#include "deltamake.h"
+
+
+#define DELTAMAKE_JOBSERVER_TOKEN		'+'
+#define DELTAMAKE_JOBSERVER_POLL_DELAY	100 // ms between cancel checks
+
+// ******************************************************************************** //
+
+										//										//
+namespace DeltaMake {
+	/**
+	 * Global limit of processes shared with `make` and other jobserver aware tools
+	 *
+	 * Every process needs a token, except the one that uses the implicit token of `deltamake` itself
+	 *
+	 * \warning `Acquire()` and `Release()` are called from the worker threads
+	 */
+	class CJobServer final {
+		public:
+										~CJobServer();
+
+			/**
+			 * Use the jobserver of the parent from `MAKEFLAGS`, or create own one
+			 * and export it to the children
+			 *
+			 * \param nJobs Size of own jobserver
+			 */
+			void						Init(size_t nJobs);
+
+			/**
+			 * Wait for a token
+			 *
+			 * \param bCancel Stop waiting when set
+			 * \returns `false` if cancelled
+			 */
+			bool						Acquire(const std::atomic<bool>& bCancel);
+
+			void						Release();
+
+		private:
+			/**
+			 * Parse `--jobserver-auth=R,W`, `--jobserver-auth=fifo:PATH` or `--jobserver-fds=R,W`
+			 */
+			bool						InitClient(const char makeFlags[]);
+
+			bool						InitServer(size_t nJobs);
+
+			/**
+			 * Open a non-blocking read end of the pipe, without changing `m_readFD` of the others
+			 */
+			void						InitTokenFD();
+
+			int							m_readFD								= -1;
+			int							m_writeFD								= -1;
+			bool						m_bOwnFDs								= false; /* Close them at the end */
+			int							m_tokenFD								= -1; /* Non-blocking, tokens are read from it */
+
+			std::mutex					m_mutex;
+			bool						m_bImplicit								= false; /* Implicit token is taken */
+			std::vector<char>			m_tokens; /* Taken tokens to give back */
+	};
+
+	extern CJobServer* const jobServer;
+}
+
+#endif /* !__DELTAMAKE_JOBSERVER_H__ */
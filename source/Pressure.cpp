@@ -0,0 +1,164 @@
+/**
+ * \file	Pressure.cpp
+ * \brief	CPU and memory pressure of the host
+ * \date	14 oct 2026
+ * \author	Reklov
+ */
+#include "Pressure.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+
+using namespace DeltaMake;
+
+// ******************************************************************************** //
+
+/* ****************************************
+ * DeltaMake::CPressureMonitor::Init
+ */
+bool DeltaMake::CPressureMonitor::Init() {
+	m_lastTime = std::chrono::steady_clock::now();
+
+	m_bPsi = (ReadPsi(DELTAMAKE_PSI_CPU_PATH, m_cpuTotal) == true) && (ReadPsi(DELTAMAKE_PSI_MEMORY_PATH, m_memoryTotal) == true);
+	if (m_bPsi == true)
+		return true;
+
+	size_t runnable;
+	return ReadLoad(runnable);
+}
+
+/* ****************************************
+ * DeltaMake::CPressureMonitor::Sample
+ */
+bool DeltaMake::CPressureMonitor::Sample(SPressure& rPressure) {
+	const auto now = std::chrono::steady_clock::now();
+	const uint64_t elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - m_lastTime).count();
+	if (elapsed == 0)
+		return false;
+
+	rPressure = SPressure();
+
+	if (m_bPsi == false) {
+		size_t runnable;
+		if (ReadLoad(runnable) == false)
+			return false;
+
+		// Runnable tasks above the cores wait for one
+		m_lastTime = now;
+		rPressure.cpu = GetLoadShare(runnable, config->nCores);
+		return true;
+	}
+
+	uint64_t cpuTotal;
+	uint64_t memoryTotal;
+	if ((ReadPsi(DELTAMAKE_PSI_CPU_PATH, cpuTotal) == false) || (ReadPsi(DELTAMAKE_PSI_MEMORY_PATH, memoryTotal) == false))
+		return false;
+
+	rPressure.cpu = GetStallShare(cpuTotal, m_cpuTotal, elapsed);
+	rPressure.memory = GetStallShare(memoryTotal, m_memoryTotal, elapsed);
+
+	m_cpuTotal = cpuTotal;
+	m_memoryTotal = memoryTotal;
+	m_lastTime = now;
+
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CPressureMonitor::IsPsi
+ */
+bool DeltaMake::CPressureMonitor::IsPsi() const {
+	return m_bPsi;
+}
+
+/* ****************************************
+ * DeltaMake::CPressureMonitor::ParsePsi
+ */
+bool DeltaMake::CPressureMonitor::ParsePsi(const char text[], uint64_t& rTotal) {
+	// some avg10=0.00 avg60=0.00 avg300=0.00 total=0
+	unsigned long long total = 0;
+	if (sscanf(text, "some avg10=%*f avg60=%*f avg300=%*f total=%llu", &total) != 1)
+		return false;
+
+	rTotal = total;
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CPressureMonitor::ParseLoad
+ */
+bool DeltaMake::CPressureMonitor::ParseLoad(const char text[], size_t& rRunnable) {
+	// 0.50 0.40 0.30 2/345 6789, the runnable ones include the reading thread
+	size_t runnable = 0;
+	if (sscanf(text, "%*f %*f %*f %zu/", &runnable) != 1)
+		return false;
+
+	rRunnable = (runnable != 0) ? runnable - 1 : 0;
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CPressureMonitor::GetStallShare
+ */
+double DeltaMake::CPressureMonitor::GetStallShare(uint64_t total, uint64_t lastTotal, uint64_t elapsed) {
+	if (elapsed == 0)
+		return 0.0;
+
+	return std::min(1.0, static_cast<double>(total - std::min(total, lastTotal)) / elapsed);
+}
+
+/* ****************************************
+ * DeltaMake::CPressureMonitor::GetLoadShare
+ */
+double DeltaMake::CPressureMonitor::GetLoadShare(size_t runnable, size_t nCores) {
+	// Runnable tasks above the cores wait for one
+	return (runnable > nCores) ? static_cast<double>(runnable - nCores) / runnable : 0.0;
+}
+
+/* ****************************************
+ * DeltaMake::CPressureMonitor::GetWorkers
+ */
+size_t DeltaMake::CPressureMonitor::GetWorkers(const SPressure& pressure, size_t active, size_t nMin, size_t nMax, bool bStarved) {
+	size_t next = active;
+	if (pressure.memory > DELTAMAKE_ADAPTIVE_MEMORY_HIGH) // Swapping is worse than waiting
+		next = active / 2;
+	else if (pressure.cpu > DELTAMAKE_ADAPTIVE_CPU_HIGH)
+		next = active - std::min(active, active / 4 + 1);
+	else if ((pressure.cpu < DELTAMAKE_ADAPTIVE_CPU_LOW) && (bStarved == true))
+		next = active + 1; // Only if more of them would be busy
+
+	next = std::min(std::max(next, std::min(nMin, nMax)), nMax);
+	return std::max<size_t>(next, 1);
+}
+
+/* ****************************************
+ * DeltaMake::CPressureMonitor::ReadText
+ */
+bool DeltaMake::CPressureMonitor::ReadText(const char path[], char* buffer, size_t size) {
+	FILE* file = fopen(path, "r");
+	if (file == nullptr)
+		return false;
+
+	const size_t length = fread(buffer, 1, size - 1, file);
+	fclose(file);
+
+	buffer[length] = '\0';
+	return length != 0;
+}
+
+/* ****************************************
+ * DeltaMake::CPressureMonitor::ReadPsi
+ */
+bool DeltaMake::CPressureMonitor::ReadPsi(const char path[], uint64_t& rTotal) {
+	char text[256];
+	return (ReadText(path, text, sizeof(text)) == true) && (ParsePsi(text, rTotal) == true);
+}
+
+/* ****************************************
+ * DeltaMake::CPressureMonitor::ReadLoad
+ */
+bool DeltaMake::CPressureMonitor::ReadLoad(size_t& rRunnable) {
+	char text[128];
+	return (ReadText(DELTAMAKE_LOADAVG_PATH, text, sizeof(text)) == true) && (ParseLoad(text, rRunnable) == true);
+}
@@ -0,0 +1,104 @@
+/**
+ * \file	Pressure.h
+ * \brief	CPU and memory pressure of the host
+ * \date	14 oct 2026
+ * \author	Reklov
+ */
+#ifndef __DELTAMAKE_PRESSURE_H__
+#define __DELTAMAKE_PRESSURE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+
+#include "deltamake.h"
+
+
+#define DELTAMAKE_PSI_CPU_PATH			"/proc/pressure/cpu"
+#define DELTAMAKE_PSI_MEMORY_PATH		"/proc/pressure/memory"
+#define DELTAMAKE_LOADAVG_PATH			"/proc/loadavg" // Before Linux 4.20, or without `CONFIG_PSI`
+
+// ******************************************************************************** //
+
+										//										//
+namespace DeltaMake {
+	/**
+	 * Pressure since the previous sample
+	 */
+	struct SPressure {
+		double							cpu										= 0.0; /* Share of the time some task waited for a CPU */
+		double							memory									= 0.0; /* Share of the time some task waited for memory */
+	};
+
+	/**
+	 * Pressure stall information (PSI) of the whole host, or the run queue of `loadavg` without it
+	 *
+	 * Stall totals are sampled, so the shares are of the last period, not the 10 s averages of the kernel
+	 */
+	class CPressureMonitor final {
+		public:
+			/**
+			 * First sample
+			 *
+			 * \returns `false` if neither PSI nor `loadavg` can be read
+			 */
+			bool						Init();
+
+			/**
+			 * \returns `false` if the sample can't be read
+			 */
+			bool						Sample(SPressure& rPressure);
+
+			/**
+			 * \returns `true` if PSI is used, `false` for `loadavg`
+			 */
+			bool						IsPsi() const;
+
+			/**
+			 * \param text Content of a `/proc/pressure/` file
+			 * \param rTotal `total` of the `some` line, µs
+			 */
+			static bool					ParsePsi(const char text[], uint64_t& rTotal);
+
+			/**
+			 * \param text Content of `/proc/loadavg`
+			 * \param rRunnable Running and runnable tasks of the host, without the reading one
+			 */
+			static bool					ParseLoad(const char text[], size_t& rRunnable);
+
+			/**
+			 * \returns Share of the stall time between two totals in `elapsed` µs
+			 */
+			static double				GetStallShare(uint64_t total, uint64_t lastTotal, uint64_t elapsed);
+
+			/**
+			 * \returns Share of the runnable tasks waiting for one of `nCores`
+			 */
+			static double				GetLoadShare(size_t runnable, size_t nCores);
+
+			/**
+			 * Worker count of `--adaptive` after a sample
+			 *
+			 * Between `DELTAMAKE_ADAPTIVE_CPU_LOW` and `DELTAMAKE_ADAPTIVE_CPU_HIGH` it's kept, so it doesn't swing
+			 *
+			 * \param active Workers taking tasks
+			 * \param nMin Minimum of `--adaptive`
+			 * \param nMax Workers there are
+			 * \param bStarved `true` if tasks are ready while all active workers are busy
+			 */
+			static size_t				GetWorkers(const SPressure& pressure, size_t active, size_t nMin, size_t nMax, bool bStarved);
+
+		private:
+			static bool					ReadPsi(const char path[], uint64_t& rTotal);
+			static bool					ReadLoad(size_t& rRunnable);
+			static bool					ReadText(const char path[], char* buffer, size_t size);
+
+			bool						m_bPsi									= false;
+			uint64_t					m_cpuTotal								= 0; /* µs */
+			uint64_t					m_memoryTotal							= 0;
+			std::chrono::steady_clock::time_point m_lastTime;
+	};
+}
+
+#endif /* !__DELTAMAKE_PRESSURE_H__ */
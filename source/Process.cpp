@@ -0,0 +1,473 @@
+/**
+ * \file	Process.cpp
+ * \brief	System process with captured output
+ * \date	14 oct 2026
+ * \author	Reklov
+ */
+#include "Process.h"
+
+#if defined(__linux__) // TODO: Win impl
+
+#include <errno.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <paths.h>
+#include <spawn.h>
+#include <wait.h>
+#include <sys/resource.h>
+
+#include "deltamake.h"
+
+using namespace DeltaMake;
+
+// ******************************************************************************** //
+
+#define PROCESS_POLL_OUT				0
+#define PROCESS_POLL_ERR				1
+
+#define PROCESS_CLOSE_PIPE(pipe) \
+	{ close(pipe); pipe = 0; }
+
+#define PROCESS_SHELL_CHARACTERS		"|&;<>()$`*?[]{}~#!\n"
+
+
+extern char** environ; // For POSIX.1
+
+// ******************************************************************************** //
+
+/* ****************************************
+ * DeltaMake::CProcessSlots::Init
+ */
+void DeltaMake::CProcessSlots::Init(size_t nSlots) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_nSlots = nSlots;
+}
+
+/* ****************************************
+ * DeltaMake::CProcessSlots::Acquire
+ */
+void DeltaMake::CProcessSlots::Acquire() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_released.wait(lock, [this]() { return (m_nSlots == 0) || (m_nUsed < m_nSlots); });
+
+	++m_nUsed;
+}
+
+/* ****************************************
+ * DeltaMake::CProcessSlots::Release
+ */
+void DeltaMake::CProcessSlots::Release() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		--m_nUsed;
+	}
+
+	m_released.notify_one();
+}
+
+// ******************************************************************************** //
+
+/* ****************************************
+ * DeltaMake::CProcess::CProcess
+ */
+DeltaMake::CProcess::CProcess() {
+}
+
+/* ****************************************
+ * DeltaMake::CProcess::~CProcess
+ */
+DeltaMake::CProcess::~CProcess() {
+}
+
+/* ****************************************
+ * DeltaMake::CProcess::Clear
+ */
+bool DeltaMake::CProcess::Clear() {
+	pid_t pid = 0;
+
+	if (m_pid > 0) {
+		rusage usage;
+		do {
+			pid = wait4(m_pid, &m_status, 0, &usage); // `waitpid()` with the resources
+		} while (pid == -1 && errno == EINTR);
+		
+		if (pid != -1)
+			m_maxRSS = static_cast<size_t>(usage.ru_maxrss);
+
+		m_pid = 0;
+	}
+
+	for (size_t i = 0; i < 2; ++i) {
+		if (m_outPipe[i] != 0)
+			close(m_outPipe[i]);
+
+		m_outPipe[i] = 0;
+	}
+	
+
+	for (size_t i = 0; i < 2; ++i) {
+		if (m_errPipe[i] != 0)
+			close(m_errPipe[i]);
+
+		m_errPipe[i] = 0;
+	}
+
+	return pid != -1;
+}
+
+/* ****************************************
+ * DeltaMake::CProcess::CheckPollFD
+ */
+bool DeltaMake::CProcess::CheckPollFD(size_t index) {
+	if (m_pfd[index].revents == 0)
+		return true;
+
+	if ((m_pfd[index].revents & (POLLIN | POLLHUP | POLLERR)) == 0) // POLLNVAL
+		return false;
+
+	// Yes, I can turn it into hackery
+	// `((index == 0) ? &m_rOutBuffer : &m_rErrBuffer)->append(buffer, nCh);`
+	// But it's to hard to read later
+	std::string& rBuffer = (index == PROCESS_POLL_OUT) ? m_outBuffer : m_errBuffer;
+
+	ssize_t nCh;
+	if (m_spills[index].size == 0) { // Right into the buffer
+		const size_t size = rBuffer.size();
+		rBuffer.resize(size + DELTAMAKE_POLL_BUFFER_SIZE);
+
+		nCh = read(m_pfd[index].fd, &rBuffer[size], DELTAMAKE_POLL_BUFFER_SIZE);
+		rBuffer.resize(size + ((nCh > 0) ? nCh : 0));
+
+		if (rBuffer.size() > DELTAMAKE_MAX_OUTPUT_SIZE) { // Cut after the last full line, if it's not too short
+			const size_t line = rBuffer.rfind('\n', DELTAMAKE_MAX_OUTPUT_SIZE - 1);
+			const size_t cut = ((line != std::string::npos) && (line >= DELTAMAKE_MAX_OUTPUT_SIZE / 2)) ? (line + 1) : DELTAMAKE_MAX_OUTPUT_SIZE;
+
+			const std::string rest = rBuffer.substr(cut);
+			rBuffer.resize(cut);
+			Spill(index, rest.data(), rest.size());
+		}
+	}
+	else {
+		char buffer[DELTAMAKE_POLL_BUFFER_SIZE];
+		nCh = read(m_pfd[index].fd, buffer, sizeof(buffer));
+		if (nCh > 0)
+			Spill(index, buffer, nCh);
+	}
+
+	if (nCh < 0) {
+		if ((errno == EINTR) || (errno == EAGAIN))
+			return true;
+
+		m_errBuffer += "read() failed\n";
+
+		return false;
+	}
+
+	return nCh != 0; // EOF
+}
+
+/* ****************************************
+ * DeltaMake::CProcess::Spill
+ */
+void DeltaMake::CProcess::Spill(size_t index, const char data[], size_t size) {
+	SSpill& rSpill = m_spills[index];
+	if (rSpill.size == 0) {
+		char path[] = P_tmpdir "/deltamake-XXXXXX.log";
+		rSpill.fd = mkostemps(path, 4, O_CLOEXEC);
+		if (rSpill.fd >= 0)
+			rSpill.path = path;
+
+		const std::string& rBuffer = (index == PROCESS_POLL_OUT) ? m_outBuffer : m_errBuffer;
+		if ((rSpill.fd >= 0) && (write(rSpill.fd, rBuffer.data(), rBuffer.size()) != static_cast<ssize_t>(rBuffer.size()))) {
+			close(rSpill.fd);
+			rSpill.fd = -1;
+		}
+	}
+
+	rSpill.size += size;
+
+	// Nothing to do if it's not written, the output is just truncated
+	if ((rSpill.fd >= 0) && (write(rSpill.fd, data, size) != static_cast<ssize_t>(size))) {
+		close(rSpill.fd);
+		rSpill.fd = -1;
+	}
+}
+
+/* ****************************************
+ * DeltaMake::CProcess::CloseSpill
+ */
+void DeltaMake::CProcess::CloseSpill(size_t index) {
+	SSpill& rSpill = m_spills[index];
+	if (rSpill.fd >= 0) {
+		close(rSpill.fd);
+		rSpill.fd = -1;
+	}
+	else if (rSpill.path.size() != 0) { // Not the whole output
+		unlink(rSpill.path.c_str());
+		rSpill.path.clear();
+	}
+}
+
+/* ****************************************
+ * DeltaMake::CProcess::Exec
+ */
+bool DeltaMake::CProcess::Exec(const char command[], int& rReturnStatus) {
+	const char* args[] = { "sh", "-c", command, NULL };
+
+	return Spawn(_PATH_BSHELL, const_cast<char* const*>(args), false, rReturnStatus);
+}
+
+/* ****************************************
+ * DeltaMake::CProcess::Exec
+ */
+bool DeltaMake::CProcess::Exec(const std::vector<std::string>& args, int& rReturnStatus) {
+	if (args.size() == 0) {
+		m_errBuffer = "Empty command";
+		return false;
+	}
+
+	std::vector<char*> argv(args.size() + 1, nullptr);
+	for (size_t i = 0; i < args.size(); ++i)
+		argv[i] = const_cast<char*>(args[i].c_str());
+
+	return Spawn(argv[0], argv.data(), true, rReturnStatus);
+}
+
+/* ****************************************
+ * DeltaMake::CProcess::SplitCommand
+ */
+bool DeltaMake::CProcess::SplitCommand(const std::string& command, std::vector<std::string>& rArgs) {
+	rArgs.clear();
+
+	std::string arg;
+	bool bArg = false; // `""` is an argument too
+	for (size_t i = 0; i < command.size(); ++i) {
+		const char ch = command[i];
+
+		if ((ch == ' ') || (ch == '\t')) {
+			if (bArg == true)
+				rArgs.push_back(arg);
+
+			arg.clear();
+			bArg = false;
+			continue;
+		}
+
+		bArg = true;
+
+		if (ch == '\'') {
+			const size_t end = command.find('\'', i + 1);
+			if (end == std::string::npos)
+				return false;
+
+			arg.append(command, i + 1, end - i - 1);
+			i = end;
+		}
+		else if (ch == '"') {
+			for (++i; (i < command.size()) && (command[i] != '"'); ++i) {
+				if ((command[i] == '$') || (command[i] == '`'))
+					return false; // Expansion
+
+				if ((command[i] == '\\') && (i + 1 < command.size()) && (strchr("\\\"", command[i + 1]) != nullptr))
+					++i;
+
+				arg += command[i];
+			}
+
+			if (i == command.size())
+				return false;
+		}
+		else if (ch == '\\') {
+			if ((i + 1 == command.size()) || (command[i + 1] == '\n'))
+				return false;
+
+			arg += command[++i];
+		}
+		else if (strchr(PROCESS_SHELL_CHARACTERS, ch) != nullptr)
+			return false;
+		else if ((ch == '=') && (rArgs.size() == 0))
+			return false; // `VAR=value command`
+		else
+			arg += ch;
+	}
+
+	if (bArg == true)
+		rArgs.push_back(arg);
+
+	return rArgs.size() != 0;
+}
+
+/* ****************************************
+ * DeltaMake::CProcess::SetOutPath
+ */
+void DeltaMake::CProcess::SetOutPath(const std::string& path) {
+	m_outPath = path;
+}
+
+/* ****************************************
+ * DeltaMake::CProcess::Spawn
+ */
+bool DeltaMake::CProcess::Spawn(const char file[], char* const argv[], bool bSearchPath, int& rReturnStatus) {
+	m_outBuffer.clear();
+	m_errBuffer.clear();
+	for (size_t i = 0; i < 2; ++i)
+		m_spills[i] = { -1, "", 0 };
+
+	m_maxRSS = 0;
+
+	// `O_CLOEXEC`, so processes of other workers don't hold them and `poll()` gets the end in time
+	if (pipe2(m_outPipe, O_CLOEXEC) < 0){
+		m_errBuffer = "pipe(m_outPipe) failed";
+
+		return false;
+	}
+	
+	if (pipe2(m_errPipe, O_CLOEXEC) < 0) {
+		Clear();
+		m_errBuffer = "pipe(m_errPipe) failed";
+
+		return false;
+	}
+
+	// Redirect child's `stdout` and `stderr` to the pipes, `dup2()` drops `O_CLOEXEC`
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+	if (m_outPath.size() != 0) // The pipe is closed at once then
+		posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, m_outPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	else
+		posix_spawn_file_actions_adddup2(&actions, m_outPipe[1], STDOUT_FILENO);
+	posix_spawn_file_actions_adddup2(&actions, m_errPipe[1], STDERR_FILENO);
+
+	// Own process group, so SIGINT of the terminal is not for it, we'll decide
+	posix_spawnattr_t attributes;
+	posix_spawnattr_init(&attributes);
+	posix_spawnattr_setpgroup(&attributes, 0);
+
+	sigset_t mask;
+	sigemptyset(&mask);
+	posix_spawnattr_setsigmask(&attributes, &mask);
+
+	sigset_t defaults;
+	sigemptyset(&defaults);
+	sigaddset(&defaults, SIGPIPE);
+	posix_spawnattr_setsigdefault(&attributes, &defaults);
+
+	posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+	// `vfork()`-like, no page tables copy of our fat process
+	pid_t pid = -1;
+	const int error = (bSearchPath == true) ?
+		posix_spawnp(&pid, file, &actions, &attributes, argv, environ) :
+		posix_spawn(&pid, file, &actions, &attributes, argv, environ);
+
+	posix_spawnattr_destroy(&attributes);
+	posix_spawn_file_actions_destroy(&actions);
+
+	if (error != 0) { // Like the shell does
+		Clear();
+		m_errBuffer += std::string(file) + ": " + strerror(error) + "\n";
+		rReturnStatus = 127;
+
+		return true;
+	}
+
+	m_pid = pid;
+
+	// Parent
+	PROCESS_CLOSE_PIPE(m_outPipe[1]);
+	PROCESS_CLOSE_PIPE(m_errPipe[1]);
+	
+	// Events for `poll()`
+	m_pfd[0].fd = m_outPipe[0]; // Process' `stdout`
+	m_pfd[0].events = POLLIN; // Read condition
+
+	m_pfd[1].fd = m_errPipe[0]; // Process' `stderr`
+	m_pfd[1].events = POLLIN; // Read condition
+
+	// Until both are closed, `stderr` may have more after `stdout`
+	while ((m_pfd[PROCESS_POLL_OUT].fd >= 0) || (m_pfd[PROCESS_POLL_ERR].fd >= 0)) {
+		const int ready = poll(m_pfd, 2, -1); // Waiting for event with infinite timeout, negative FDs are ignored
+		if ((ready < 0) && (errno != EINTR)) { // Smh bad happened
+			m_errBuffer += "poll() failed\n";
+			Clear();
+
+			for (size_t i = 0; i < 2; ++i)
+				CloseSpill(i);
+
+			return false;
+		}
+
+		for (size_t i = 0; i < 2; ++i) {
+			if ((m_pfd[i].fd >= 0) && (CheckPollFD(i) == false))
+				m_pfd[i].fd = -1;
+		}
+	}
+
+	Clear();
+
+	for (size_t i = 0; i < 2; ++i) {
+		if (m_spills[i].size == 0)
+			continue;
+
+		std::string& rBuffer = (i == PROCESS_POLL_OUT) ? m_outBuffer : m_errBuffer;
+		rBuffer += "\n... " + std::to_string(m_spills[i].size) + " bytes more";
+		if (m_spills[i].fd >= 0)
+			rBuffer += ", see \"" + m_spills[i].path + "\"";
+
+		rBuffer += "\n";
+		CloseSpill(i);
+	}
+
+	if (WIFEXITED(m_status) == 0) { // And here's why
+		m_errBuffer = "WIFEXITED() is zero";
+		
+		return false;
+	}
+
+	rReturnStatus = WEXITSTATUS(m_status);
+
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CProcess::Kill
+ */
+bool DeltaMake::CProcess::Kill() {
+	const pid_t pid = m_pid;
+	if (pid <= 0) // Not started or already reaped, `kill(0)` and `kill(-1)` are not for us
+		return false;
+
+	return kill(-pid, SIGKILL) != -1; // With the children of the shell
+}
+
+/* ****************************************
+ * DeltaMake::CProcess::GetOutBuffer
+ */
+const std::string& DeltaMake::CProcess::GetOutBuffer() const {
+	return m_outBuffer;
+}
+
+/* ****************************************
+ * DeltaMake::CProcess::GetErrBuffer
+ */
+const std::string& DeltaMake::CProcess::GetErrBuffer() const {
+	return m_errBuffer;
+}
+
+/* ****************************************
+ * DeltaMake::CProcess::GetOutputSize
+ */
+size_t DeltaMake::CProcess::GetOutputSize() const {
+	return m_outBuffer.size() + m_errBuffer.size() + m_spills[0].size + m_spills[1].size;
+}
+
+/* ****************************************
+ * DeltaMake::CProcess::GetMaxRSS
+ */
+size_t DeltaMake::CProcess::GetMaxRSS() const {
+	return m_maxRSS;
+}
+
+#endif
@@ -0,0 +1,144 @@
+/**
+ * \file	Process.h
+ * \brief	System process with captured output
+ * \date	14 oct 2026
+ * \author	Reklov
+ */
+#ifndef __DELTAMAKE_PROCESS_H__
+#define __DELTAMAKE_PROCESS_H__
+
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+#if defined(__linux__) // TODO: Win impl
+#include <poll.h>
+#include <sys/types.h>
+#endif
+
+// ******************************************************************************** //
+
+#if defined(__linux__) // TODO: Win impl
+
+										//										//
+namespace DeltaMake {
+	/**
+	 * Limit of processes executed at once
+	 */
+	class CProcessSlots final {
+		public:
+			/**
+			 * \param nSlots `0` for no limit
+			 */
+			void						Init(size_t nSlots);
+
+			void						Acquire();
+			void						Release();
+
+		private:
+			std::mutex					m_mutex;
+			std::condition_variable		m_released;
+
+			size_t						m_nSlots								= 0;
+			size_t						m_nUsed									= 0;
+	};
+
+	/**
+	 * Wrapper for system process and output streams
+	 */
+	class CProcess final {
+		public:
+										CProcess();
+										~CProcess();
+
+			/**
+			 * Execute the command with `/bin/sh -c`
+			 */
+			bool						Exec(const char command[], int& rReturnStatus);
+
+			/**
+			 * Execute the program directly, without the shell, `args[0]` is searched in `PATH`
+			 *
+			 * \returns `rReturnStatus` is `127` if the program can't be executed
+			 */
+			bool						Exec(const std::vector<std::string>& args, int& rReturnStatus);
+
+			/**
+			 * Split the command into arguments like the shell does, but without any expansions
+			 *
+			 * \returns `false` if the command needs the shell: redirections, pipes, variables, globs...
+			 */
+			static bool					SplitCommand(const std::string& command, std::vector<std::string>& rArgs);
+
+			/**
+			 * `stdout` of the next processes goes to the file, like `> path` without the shell
+			 *
+			 * \param path Empty to capture it again
+			 */
+			void						SetOutPath(const std::string& path);
+
+			bool						Kill();
+
+			/**
+			 * At most `DELTAMAKE_MAX_OUTPUT_SIZE` bytes of the output, then the line with the file that has all of it
+			 */
+			const std::string&			GetOutBuffer() const;
+			const std::string&			GetErrBuffer() const;
+
+			/**
+			 * \returns Bytes written to `stdout` and `stderr`, not only captured
+			 */
+			size_t						GetOutputSize() const;
+
+			/**
+			 * \returns Peak RSS of the last process in KiB
+			 */
+			size_t						GetMaxRSS() const;
+
+		private:
+			/**
+			 * Output after `DELTAMAKE_MAX_OUTPUT_SIZE`
+			 */
+			struct SSpill {
+				int						fd; /* Whole output, opened at the limit */
+				std::string				path;
+				size_t					size; /* Bytes after the limit */
+			};
+
+			bool						Spawn(const char file[], char* const argv[], bool bSearchPath, int& rReturnStatus);
+
+			bool						Clear();
+
+			/**
+			 * \returns `false` if the pipe is closed
+			 */
+			bool						CheckPollFD(size_t index);
+
+			/**
+			 * Write the output to the spill file, the buffer has all before it
+			 */
+			void						Spill(size_t index, const char data[], size_t size);
+			void						CloseSpill(size_t index);
+
+			std::string					m_outPath; /* Of `SetOutPath()`, `stdout` is captured if empty */
+			std::string					m_outBuffer; /* Capacity is kept between `Exec()` calls */
+			std::string					m_errBuffer;
+			SSpill						m_spills[2]								= { { -1, "", 0 }, { -1, "", 0 } }; // { `stdout`, `stderr` }
+
+			int							m_outPipe[2]							= {};
+			int							m_errPipe[2]							= {};
+
+			std::atomic<pid_t>			m_pid									= -1; /* `Kill()` is called from the other thread */
+			pollfd						m_pfd[2]								= {}; // { `stdout`, `stderr` }
+			int							m_status								= -1;
+			size_t						m_maxRSS								= 0; /* KiB */
+	};
+}
+
+#endif
+
+#endif /* !__DELTAMAKE_PROCESS_H__ */
@@ -0,0 +1,813 @@
+/**
+ * \file	Remote.cpp
+ * \brief	Remote execution of compile tasks on build nodes
+ * \date	14 oct 2026
+ * \author	Reklov
+ */
+#include "Remote.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <ctype.h>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <fstream>
+#include <iterator>
+#include <filesystem>
+
+#include "Terminal.h"
+#include "Process.h"
+
+using namespace DeltaMake;
+
+// ******************************************************************************** //
+
+/**
+ * Response status of the build node
+ */
+enum ERemoteStatus : uint32_t {
+	EXECUTED, /* Return value is valid */
+	REJECTED, /* Execute it somewhere else */
+};
+
+/**
+ * Non-blocking socket with length-prefixed messages
+ */
+class CConnection final {
+	public:
+										CConnection(int fd, const std::atomic<bool>* bCancel);
+										~CConnection();
+
+		bool							Send(const void* data, size_t size);
+		bool							SendU32(uint32_t value);
+		bool							SendString(const std::string& str);
+
+		bool							Recv(void* data, size_t size);
+		bool							RecvU32(uint32_t& rValue);
+
+		/**
+		 * \param maxSize Longer strings are an error
+		 */
+		bool							RecvString(std::string& rStr, size_t maxSize = DELTAMAKE_REMOTE_MAX_MESSAGE);
+
+		/**
+		 * \param timeout ms without any data
+		 */
+		void							SetTimeout(int timeout);
+
+	private:
+		/**
+		 * \returns `false` on timeout, cancel or error
+		 */
+		bool							Wait(short events);
+
+		const int						m_fd;
+		const std::atomic<bool>*		m_bCancel;
+		int								m_timeout								= DELTAMAKE_REMOTE_TIMEOUT;
+};
+
+/**
+ * Listening socket and the rules of the build node
+ */
+struct SRemoteServer {
+	int									listenFD;
+	CProcessSlots						slots;
+	std::string							token;
+	std::set<std::string>				compilers; /* Allowed `argv[0]` */
+};
+
+/**
+ * \returns Connected non-blocking socket or `-1`
+ */
+static int								Connect(const std::string& host, const std::string& port);
+
+/**
+ * Accept and serve the clients, one at a time
+ */
+static void								ServeJobs(SRemoteServer* server);
+
+/**
+ * Execute one job of the client
+ */
+static void								ServeJob(int fd, SRemoteServer* server);
+
+/**
+ * \returns `false` if the compiler is not allowed or an option is not one of `IsAllowedOption()`
+ */
+static bool								IsAllowedCompile(const std::vector<std::string>& args, const std::set<std::string>& compilers);
+
+/**
+ * \returns `true` for the options that change the code of a preprocessed source only, without paths to read or write
+ */
+static bool								IsAllowedOption(const std::string& arg);
+
+/**
+ * \returns `true` if the option value is a name, a number or a list of them
+ */
+static bool								IsPlainValue(const char value[]);
+
+/**
+ * Compare without an early exit, so the time doesn't tell how much of the token is right
+ */
+static bool								IsSameToken(const std::string& a, const std::string& b);
+
+// ******************************************************************************** //
+
+DeltaMake::CRemoteExecutor g_remoteExecutor;
+extern DeltaMake::CRemoteExecutor* const DeltaMake::remoteExecutor = &g_remoteExecutor;
+
+// ******************************************************************************** //
+
+/* ****************************************
+ * DeltaMake::CRemoteExecutor::Init
+ */
+bool DeltaMake::CRemoteExecutor::Init(const char hosts[]) {
+	m_hosts.clear();
+	if (hosts == nullptr)
+		return true;
+
+	const char* token = getenv(DELTAMAKE_REMOTE_TOKEN_ENV);
+	if ((token == nullptr) || (token[0] == '\0')) {
+		terminal->Log(LOG_WARNING, "Build nodes are not used, " DELTAMAKE_REMOTE_TOKEN_ENV " is not set\n");
+		return false;
+	}
+
+	m_token = token;
+
+	const std::string list = hosts;
+	size_t begin = 0;
+	while (begin < list.size()) {
+		size_t end = list.find_first_of(", ", begin);
+		if (end == std::string::npos)
+			end = list.size();
+
+		std::string name = list.substr(begin, end - begin);
+		begin = end + 1;
+
+		if (name.size() == 0)
+			continue;
+
+		SHost host;
+		host.port = DELTAMAKE_REMOTE_PORT;
+		host.nSlots = DELTAMAKE_REMOTE_SLOTS;
+		host.nRunning = 0;
+		host.bDown = false;
+
+		const size_t slash = name.find('/');
+		if (slash != std::string::npos) {
+			const long long nSlots = atoll(name.c_str() + slash + 1);
+			host.nSlots = (nSlots > 0) ? static_cast<size_t>(nSlots) : 1;
+			name.resize(slash);
+		}
+
+		const size_t colon = name.rfind(':');
+		if ((colon != std::string::npos) && (name.find(':') == colon)) { // Not IPv6
+			host.port = name.substr(colon + 1);
+			name.resize(colon);
+		}
+
+		host.name = name;
+		m_hosts.push_back(host);
+
+		terminal->Log(LOG_DETAIL, "Build node: %s:%s (%zu slots)\n", host.name.c_str(), host.port.c_str(), host.nSlots);
+	}
+
+	return m_hosts.size() != 0;
+}
+
+/* ****************************************
+ * DeltaMake::CRemoteExecutor::IsEnabled
+ */
+bool DeltaMake::CRemoteExecutor::IsEnabled() const {
+	return m_hosts.size() != 0;
+}
+
+/* ****************************************
+ * DeltaMake::CRemoteExecutor::GetCapacity
+ */
+size_t DeltaMake::CRemoteExecutor::GetCapacity() const {
+	size_t nSlots = 0;
+	for (size_t i = 0; i < m_hosts.size(); ++i)
+		nSlots += m_hosts[i].nSlots;
+
+	return nSlots;
+}
+
+/* ****************************************
+ * DeltaMake::CRemoteExecutor::Execute
+ */
+bool DeltaMake::CRemoteExecutor::Execute(const SRemoteJob& job, SRemoteResult& rResult, const std::atomic<bool>& bCancel) {
+	while (bCancel == false) {
+		SHost* host = AcquireHost();
+		if (host == nullptr)
+			break;
+
+		const int fd = Connect(host->name, host->port);
+		if (fd < 0) {
+			ReleaseHost(host, true);
+			continue; // Next one
+		}
+
+		CConnection connection(fd, &bCancel);
+
+		bool bOk = connection.SendU32(DELTAMAKE_REMOTE_MAGIC);
+		bOk = bOk && connection.SendString(m_token);
+		bOk = bOk && connection.SendString(job.compile);
+		bOk = bOk && connection.SendString(job.extension);
+		bOk = bOk && connection.SendString(job.source);
+
+		uint32_t magic = 0;
+		uint32_t status = REJECTED;
+		uint32_t returnValue = 0;
+		bOk = bOk && connection.RecvU32(magic) && (magic == DELTAMAKE_REMOTE_MAGIC);
+		bOk = bOk && connection.RecvU32(status);
+		bOk = bOk && connection.RecvU32(returnValue);
+		bOk = bOk && connection.RecvString(rResult.object);
+		bOk = bOk && connection.RecvString(rResult.out);
+		bOk = bOk && connection.RecvString(rResult.err);
+
+		ReleaseHost(host, (bOk == false) && (bCancel == false));
+
+		if (bOk == false)
+			continue; // Next one
+
+		if (status != EXECUTED)
+			break;
+
+		rResult.returnValue = static_cast<int>(returnValue);
+		++m_nRemote;
+
+		return true;
+	}
+
+	++m_nLocal;
+
+	return false;
+}
+
+/* ****************************************
+ * DeltaMake::CRemoteExecutor::ShowStats
+ */
+void DeltaMake::CRemoteExecutor::ShowStats() const {
+	if (IsEnabled() == false)
+		return;
+
+	size_t nDown = 0;
+	for (size_t i = 0; i < m_hosts.size(); ++i) {
+		if (m_hosts[i].bDown == true) {
+			terminal->Log(LOG_WARNING, "Build node %s:%s is unreachable\n", m_hosts[i].name.c_str(), m_hosts[i].port.c_str());
+			++nDown;
+		}
+	}
+
+	terminal->Log(
+		(nDown == 0) ? LOG_INFO : LOG_WARNING,
+		"Remote: %zu jobs on build nodes, %zu executed locally, %zu of %zu nodes are down\n",
+		static_cast<size_t>(m_nRemote),
+		static_cast<size_t>(m_nLocal),
+		nDown,
+		m_hosts.size()
+	);
+}
+
+/* ****************************************
+ * DeltaMake::CRemoteExecutor::AcquireHost
+ */
+DeltaMake::CRemoteExecutor::SHost* DeltaMake::CRemoteExecutor::AcquireHost() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	SHost* best = nullptr;
+	double bestLoad = 1.0;
+	for (size_t i = 0; i < m_hosts.size(); ++i) {
+		SHost& host = m_hosts[i];
+		if (host.bDown == true)
+			continue;
+
+		const double load = static_cast<double>(host.nRunning) / host.nSlots;
+		if (load < bestLoad) {
+			best = &host;
+			bestLoad = load;
+		}
+	}
+
+	if (best != nullptr)
+		++best->nRunning;
+
+	return best;
+}
+
+/* ****************************************
+ * DeltaMake::CRemoteExecutor::ReleaseHost
+ */
+void DeltaMake::CRemoteExecutor::ReleaseHost(SHost* host, bool bDown) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	--host->nRunning;
+	if (bDown == true)
+		host->bDown = true; // Shown by `ShowStats()`, the status is drawn now
+}
+
+// ******************************************************************************** //
+
+/* ****************************************
+ * DeltaMake::RunRemoteServer
+ */
+int DeltaMake::RunRemoteServer(const char address[], size_t nSlots, const char compilers[]) {
+	SRemoteServer server;
+
+	const char* token = getenv(DELTAMAKE_REMOTE_TOKEN_ENV);
+	if ((token == nullptr) || (token[0] == '\0')) {
+		terminal->Log(LOG_ERROR, "Set " DELTAMAKE_REMOTE_TOKEN_ENV " to the token of the clients\n");
+		return EXIT_FAILURE;
+	}
+
+	server.token = token;
+
+	const std::string list = (compilers != nullptr) ? compilers : DELTAMAKE_REMOTE_COMPILERS;
+	size_t begin = 0;
+	while (begin < list.size()) {
+		size_t end = list.find_first_of(", ", begin);
+		if (end == std::string::npos)
+			end = list.size();
+
+		if (end != begin)
+			server.compilers.insert(list.substr(begin, end - begin));
+
+		begin = end + 1;
+	}
+
+	// `port`, `host:port` or `[IPv6]:port`
+	std::string host = DELTAMAKE_REMOTE_ADDRESS;
+	std::string port = address;
+	const size_t colon = port.rfind(':');
+	if (colon != std::string::npos) {
+		host = port.substr(0, colon);
+		port = port.substr(colon + 1);
+
+		if ((host.size() >= 2) && (host.front() == '[') && (host.back() == ']'))
+			host = host.substr(1, host.size() - 2);
+	}
+
+	addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_PASSIVE;
+
+	addrinfo* addresses = nullptr;
+	if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0) {
+		terminal->Log(LOG_ERROR, "Bad address \"%s\"\n", address);
+		return EXIT_FAILURE;
+	}
+
+	int listenFD = -1;
+	for (addrinfo* it = addresses; (it != nullptr) && (listenFD < 0); it = it->ai_next) {
+		listenFD = socket(it->ai_family, it->ai_socktype | SOCK_CLOEXEC, it->ai_protocol);
+		if (listenFD < 0)
+			continue;
+
+		const int on = 1;
+		setsockopt(listenFD, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+		if ((bind(listenFD, it->ai_addr, it->ai_addrlen) != 0) || (listen(listenFD, SOMAXCONN) != 0)) {
+			close(listenFD);
+			listenFD = -1;
+		}
+	}
+
+	freeaddrinfo(addresses);
+
+	if (listenFD < 0) {
+		terminal->Log(LOG_ERROR, "Can't listen %s:%s: %s\n", host.c_str(), port.c_str(), strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	server.listenFD = listenFD;
+	server.slots.Init(nSlots);
+
+	terminal->Log(LOG_INFO, "Build node is listening %s:%s with %zu slots\n", host.c_str(), port.c_str(), nSlots);
+	for (const std::string& compiler : server.compilers)
+		terminal->Log(LOG_DETAIL, "Allowed compiler: %s\n", compiler.c_str());
+
+	// Fixed number of connections, so clients can't exhaust the threads
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < nSlots + DELTAMAKE_REMOTE_SPARE_CONNECTIONS; ++i)
+		threads.emplace_back(ServeJobs, &server);
+
+	ServeJobs(&server);
+
+	for (size_t i = 0; i < threads.size(); ++i)
+		threads[i].join();
+
+	close(listenFD);
+
+	return EXIT_FAILURE;
+}
+
+/* ****************************************
+ * ServeJobs
+ */
+static void ServeJobs(SRemoteServer* server) {
+	while (true) {
+		const int fd = accept4(server->listenFD, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0) {
+			if ((errno == EINTR) || (errno == ECONNABORTED))
+				continue;
+
+			terminal->Log(LOG_ERROR, "accept() failed: %s\n", strerror(errno));
+			break;
+		}
+
+		ServeJob(fd, server);
+	}
+}
+
+/* ****************************************
+ * ServeJob
+ */
+static void ServeJob(int fd, SRemoteServer* server) {
+	CConnection connection(fd, nullptr);
+
+	// Nothing big is received before the token
+	connection.SetTimeout(DELTAMAKE_REMOTE_AUTH_TIMEOUT);
+
+	uint32_t magic = 0;
+	std::string token;
+	bool bOk = connection.RecvU32(magic) && (magic == DELTAMAKE_REMOTE_MAGIC);
+	bOk = bOk && connection.RecvString(token, DELTAMAKE_REMOTE_MAX_TOKEN);
+
+	if (bOk == false)
+		return;
+
+	if (IsSameToken(token, server->token) == false) {
+		terminal->Log(LOG_WARNING, "Client with a wrong token is rejected\n");
+		return;
+	}
+
+	connection.SetTimeout(DELTAMAKE_REMOTE_TIMEOUT);
+
+	SRemoteJob job;
+	bOk = connection.RecvString(job.compile);
+	bOk = bOk && connection.RecvString(job.extension);
+	bOk = bOk && connection.RecvString(job.source);
+
+	if (bOk == false)
+		return;
+
+	// Executed without the shell, so only the allowed compiler with the checked options
+	std::vector<std::string> args;
+	bool bValid = (CProcess::SplitCommand(job.compile, args) == true) && ((job.extension == "i") || (job.extension == "ii"));
+	if ((bValid == true) && (IsAllowedCompile(args, server->compilers) == false)) {
+		terminal->Log(LOG_WARNING, "Rejected: %s\n", job.compile.c_str());
+		bValid = false;
+	}
+
+	SRemoteResult result;
+	result.returnValue = -1;
+	uint32_t status = REJECTED;
+
+	char dir[] = P_tmpdir "/deltamake-XXXXXX";
+	if ((bValid == true) && (mkdtemp(dir) != nullptr)) {
+		const std::string inPath = std::string(dir) + "/in." + job.extension;
+		const std::string outPath = std::string(dir) + "/out.o";
+
+		std::ofstream in(inPath, std::ios::binary);
+		in.write(job.source.data(), job.source.size());
+		in.close();
+
+		if (in.fail() == false) {
+			args.insert(args.end(), { "-c", inPath, "-o", outPath });
+
+			CProcess process;
+			server->slots.Acquire();
+			const bool bExecuted = process.Exec(args, result.returnValue);
+			server->slots.Release();
+
+			if ((bExecuted == true) && (result.returnValue != 127)) { // Else no compiler on this node
+				status = EXECUTED;
+				result.out = process.GetOutBuffer();
+				result.err = process.GetErrBuffer();
+
+				if (result.returnValue == 0) {
+					std::ifstream out(outPath, std::ios::binary);
+					result.object.assign(std::istreambuf_iterator<char>(out), std::istreambuf_iterator<char>());
+				}
+			}
+
+			terminal->Log(LOG_DETAIL, "%s: %i\n", job.compile.c_str(), result.returnValue);
+		}
+
+		std::error_code error;
+		std::filesystem::remove_all(dir, error);
+	}
+
+	bOk = connection.SendU32(DELTAMAKE_REMOTE_MAGIC);
+	bOk = bOk && connection.SendU32(status);
+	bOk = bOk && connection.SendU32(static_cast<uint32_t>(result.returnValue));
+	bOk = bOk && connection.SendString(result.object);
+	bOk = bOk && connection.SendString(result.out);
+	bOk = bOk && connection.SendString(result.err);
+}
+
+/* ****************************************
+ * IsAllowedCompile
+ */
+static bool IsAllowedCompile(const std::vector<std::string>& args, const std::set<std::string>& compilers) {
+	if ((args.size() == 0) || (compilers.count(args[0]) == 0))
+		return false;
+
+	for (size_t i = 1; i < args.size(); ++i) {
+		const std::string& arg = args[i];
+		if ((arg == "-target") || (arg == "-arch")) { // Value in the next argument
+			if ((i + 1 == args.size()) || (IsPlainValue(args[i + 1].c_str()) == false))
+				return false;
+
+			++i;
+			continue;
+		}
+
+		if (IsAllowedOption(arg) == false)
+			return false; // Inputs and outputs are set by the build node
+	}
+
+	return true;
+}
+
+/* ****************************************
+ * IsAllowedOption
+ */
+static bool IsAllowedOption(const std::string& arg) {
+	static const std::set<std::string> exact = {
+		"-O", "-O0", "-O1", "-O2", "-O3", "-Os", "-Oz", "-Og", "-Ofast",
+		"-g", "-g0", "-g1", "-g2", "-g3", "-ggdb", "-ggdb0", "-ggdb1", "-ggdb2", "-ggdb3", "-gdwarf", "-gdwarf-4", "-gdwarf-5", "-gline-tables-only", "-gno-column-info",
+		"-w", "-pedantic", "-pedantic-errors", "-ansi", "-pthread", "-pipe"
+	};
+
+	// Of preprocessed code only, they don't read or write files
+	static const std::set<std::string> flags = {
+		"PIC", "pic", "PIE", "pie", "exceptions", "rtti", "threadsafe-statics", "strict-aliasing", "strict-overflow", "strict-enums",
+		"omit-frame-pointer", "stack-protector", "stack-protector-strong", "stack-protector-all", "stack-clash-protection", "cf-protection",
+		"inline-functions", "unroll-loops", "tree-vectorize", "vectorize", "slp-vectorize", "fast-math", "finite-math-only", "math-errno",
+		"function-sections", "data-sections", "common", "signed-char", "unsigned-char", "wrapv", "trapv", "builtin", "plt", "semantic-interposition",
+		"asynchronous-unwind-tables", "unwind-tables", "visibility-inlines-hidden", "permissive", "char8_t", "coroutines", "ms-extensions", "openmp",
+		"lto", "diagnostics-color", "color-diagnostics", "diagnostics-show-option", "show-column", "caret-diagnostics", "ident", "working-directory"
+	};
+
+	static const std::set<std::string> flagsWithValue = {
+		"visibility", "lto", "diagnostics-color", "message-length", "max-errors", "template-depth", "constexpr-depth", "constexpr-steps",
+		"sanitize", "sanitize-recover", "cf-protection", "stack-protector-guard", "abi-version"
+	};
+
+	static const std::set<std::string> prefixMaps = { "debug-prefix-map", "macro-prefix-map", "file-prefix-map" }; // Only renames in the object
+
+	if (exact.count(arg) != 0)
+		return true;
+
+	if (arg.compare(0, 5, "-std=") == 0)
+		return IsPlainValue(arg.c_str() + 5);
+
+	if (arg.compare(0, 9, "--target=") == 0)
+		return IsPlainValue(arg.c_str() + 9);
+
+	if ((arg.compare(0, 2, "-D") == 0) || (arg.compare(0, 2, "-U") == 0)) // Nothing is expanded in preprocessed code
+		return arg.size() > 2;
+
+	if ((arg.compare(0, 2, "-m") == 0) || (arg.compare(0, 2, "-W") == 0)) // Not `-Wa,` and the other options of the tools with a comma
+		return (arg.size() > 2) && (arg.find(',') == std::string::npos) && (IsPlainValue(arg.c_str() + 2) == true);
+
+	if (arg.compare(0, 2, "-f") != 0)
+		return false;
+
+	std::string name = arg.substr(2);
+	if (name.compare(0, 3, "no-") == 0)
+		name.erase(0, 3);
+
+	const size_t equal = name.find('=');
+	if (equal == std::string::npos)
+		return flags.count(name) != 0;
+
+	const std::string value = name.substr(equal + 1);
+	name.erase(equal);
+
+	if (prefixMaps.count(name) != 0)
+		return true;
+
+	return (flagsWithValue.count(name) != 0) && (IsPlainValue(value.c_str()) == true);
+}
+
+/* ****************************************
+ * IsPlainValue
+ */
+static bool IsPlainValue(const char value[]) {
+	if (value[0] == '\0')
+		return false;
+
+	for (const char* c = value; *c != '\0'; ++c) {
+		if ((isalnum(static_cast<unsigned char>(*c)) == 0) && (strchr("_-+.,=", *c) == nullptr))
+			return false; // No paths
+	}
+
+	return true;
+}
+
+/* ****************************************
+ * IsSameToken
+ */
+static bool IsSameToken(const std::string& a, const std::string& b) {
+	unsigned char diff = (a.size() == b.size()) ? 0 : 1;
+	for (size_t i = 0; i < std::max(a.size(), b.size()); ++i)
+		diff |= static_cast<unsigned char>(((i < a.size()) ? a[i] : 0) ^ ((i < b.size()) ? b[i] : 0));
+
+	return diff == 0;
+}
+
+/* ****************************************
+ * Connect
+ */
+static int Connect(const std::string& host, const std::string& port) {
+	addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	addrinfo* addresses = nullptr;
+	if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0)
+		return -1;
+
+	int fd = -1;
+	for (addrinfo* address = addresses; (address != nullptr) && (fd < 0); address = address->ai_next) {
+		fd = socket(address->ai_family, address->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, address->ai_protocol);
+		if (fd < 0)
+			continue;
+
+		if (connect(fd, address->ai_addr, address->ai_addrlen) == 0)
+			break;
+
+		pollfd pfd;
+		pfd.fd = fd;
+		pfd.events = POLLOUT;
+
+		int error = 0;
+		socklen_t size = sizeof(error);
+		const bool bConnected = (errno == EINPROGRESS) && (poll(&pfd, 1, DELTAMAKE_REMOTE_CONNECT_TIMEOUT) == 1) && (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &size) == 0) && (error == 0);
+		if (bConnected == false) {
+			close(fd);
+			fd = -1;
+		}
+	}
+
+	freeaddrinfo(addresses);
+
+	return fd;
+}
+
+// ******************************************************************************** //
+
+/* ****************************************
+ * CConnection::CConnection
+ */
+CConnection::CConnection(int fd, const std::atomic<bool>* bCancel) : m_fd(fd), m_bCancel(bCancel) {
+}
+
+/* ****************************************
+ * CConnection::~CConnection
+ */
+CConnection::~CConnection() {
+	close(m_fd);
+}
+
+/* ****************************************
+ * CConnection::Wait
+ */
+bool CConnection::Wait(short events) {
+	pollfd pfd;
+	pfd.fd = m_fd;
+	pfd.events = events;
+
+	const auto since = std::chrono::steady_clock::now();
+	while ((m_bCancel == nullptr) || (*m_bCancel == false)) {
+		const int ready = poll(&pfd, 1, DELTAMAKE_REMOTE_POLL_DELAY);
+		if (ready > 0)
+			return true;
+
+		if ((ready < 0) && (errno != EINTR))
+			return false;
+
+		if (std::chrono::steady_clock::now() - since >= std::chrono::milliseconds(m_timeout))
+			return false;
+	}
+
+	return false;
+}
+
+/* ****************************************
+ * CConnection::Send
+ */
+bool CConnection::Send(const void* data, size_t size) {
+	const char* buffer = static_cast<const char*>(data);
+	while (size != 0) {
+		const ssize_t nSent = send(m_fd, buffer, size, MSG_NOSIGNAL);
+		if (nSent > 0) {
+			buffer += nSent;
+			size -= static_cast<size_t>(nSent);
+			continue;
+		}
+
+		if ((nSent < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+			return false;
+
+		if (Wait(POLLOUT) == false)
+			return false;
+	}
+
+	return true;
+}
+
+/* ****************************************
+ * CConnection::SendU32
+ */
+bool CConnection::SendU32(uint32_t value) {
+	const uint32_t data = htonl(value);
+
+	return Send(&data, sizeof(data));
+}
+
+/* ****************************************
+ * CConnection::SendString
+ */
+bool CConnection::SendString(const std::string& str) {
+	if (str.size() > DELTAMAKE_REMOTE_MAX_MESSAGE)
+		return false;
+
+	return SendU32(static_cast<uint32_t>(str.size())) && Send(str.data(), str.size());
+}
+
+/* ****************************************
+ * CConnection::Recv
+ */
+bool CConnection::Recv(void* data, size_t size) {
+	char* buffer = static_cast<char*>(data);
+	while (size != 0) {
+		const ssize_t nReceived = recv(m_fd, buffer, size, 0);
+		if (nReceived > 0) {
+			buffer += nReceived;
+			size -= static_cast<size_t>(nReceived);
+			continue;
+		}
+
+		if (nReceived == 0) // Closed
+			return false;
+
+		if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+			return false;
+
+		if (Wait(POLLIN) == false)
+			return false;
+	}
+
+	return true;
+}
+
+/* ****************************************
+ * CConnection::RecvU32
+ */
+bool CConnection::RecvU32(uint32_t& rValue) {
+	uint32_t data;
+	if (Recv(&data, sizeof(data)) == false)
+		return false;
+
+	rValue = ntohl(data);
+
+	return true;
+}
+
+/* ****************************************
+ * CConnection::RecvString
+ */
+bool CConnection::RecvString(std::string& rStr, size_t maxSize) {
+	uint32_t size;
+	if ((RecvU32(size) == false) || (size > maxSize))
+		return false;
+
+	rStr.resize(size);
+
+	return (size == 0) || Recv(&rStr[0], size);
+}
+
+/* ****************************************
+ * CConnection::SetTimeout
+ */
+void CConnection::SetTimeout(int timeout) {
+	m_timeout = timeout;
+}
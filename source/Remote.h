@@ -0,0 +1,133 @@
+/**
+ * \file	Remote.h
+ * \brief	Remote execution of compile tasks on build nodes
+ * \date	14 oct 2026
+ * \author	Reklov
+ */
+#ifndef __DELTAMAKE_REMOTE_H__
+#define __DELTAMAKE_REMOTE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+#include <set>
+#include <mutex>
+#include <atomic>
+
+#include "deltamake.h"
+
+
+#define DELTAMAKE_REMOTE_ENV			"DELTAMAKE_REMOTE"
+#define DELTAMAKE_REMOTE_TOKEN_ENV		"DELTAMAKE_REMOTE_TOKEN" // Shared secret of the clients and the build nodes
+#define DELTAMAKE_REMOTE_PORT			"3633"
+#define DELTAMAKE_REMOTE_ADDRESS		"127.0.0.1" // Build nodes listen on loopback, if not set
+#define DELTAMAKE_REMOTE_COMPILERS		"cc,c++,gcc,g++,clang,clang++" // Allowed by build nodes, if not set
+#define DELTAMAKE_REMOTE_SLOTS			4 // Jobs at once on a host, if not set
+#define DELTAMAKE_REMOTE_SPARE_CONNECTIONS 4 // Served besides the slots, the other clients wait in the backlog
+#define DELTAMAKE_REMOTE_MAGIC			0x32524D44 // "DMR2"
+
+#define DELTAMAKE_REMOTE_CONNECT_TIMEOUT 2000 // ms
+#define DELTAMAKE_REMOTE_TIMEOUT		600000 // ms without any data
+#define DELTAMAKE_REMOTE_AUTH_TIMEOUT	5000 // ms for the token of a client
+#define DELTAMAKE_REMOTE_POLL_DELAY		100 // ms between cancel checks
+#define DELTAMAKE_REMOTE_MAX_MESSAGE	(1u << 30) // bytes
+#define DELTAMAKE_REMOTE_MAX_TOKEN		1024 // bytes
+
+// ******************************************************************************** //
+
+										//										//
+namespace DeltaMake {
+	/**
+	 * Compile of the preprocessed source
+	 */
+	struct SRemoteJob {
+		std::string						compile; /* Compiler and flags, the build node appends input and output */
+		std::string						extension; /* Of the preprocessed source: `i` or `ii` */
+		std::string						source; /* Preprocessed source */
+	};
+
+	/**
+	 * Result of the job executed on the build node
+	 */
+	struct SRemoteResult {
+		int								returnValue;
+		std::string						object; /* Empty if failed */
+		std::string						out;
+		std::string						err;
+	};
+
+	/**
+	 * Client side of the build nodes
+	 *
+	 * \warning `Execute()` is called from the worker threads
+	 */
+	class CRemoteExecutor final {
+		public:
+			/**
+			 * \param hosts `host[:port][/slots]` separated by commas or spaces, `nullptr` disables
+			 */
+			bool						Init(const char hosts[]);
+
+			bool						IsEnabled() const;
+
+			/**
+			 * \returns Number of jobs that all hosts execute at once
+			 */
+			size_t						GetCapacity() const;
+
+			/**
+			 * Execute the job on the least loaded host with a free slot
+			 *
+			 * \param bCancel Stop waiting for the host when set
+			 * \returns `false` if no host can execute it, so it must be executed locally
+			 */
+			bool						Execute(const SRemoteJob& job, SRemoteResult& rResult, const std::atomic<bool>& bCancel);
+
+			void						ShowStats() const;
+
+		private:
+			/**
+			 * Build node
+			 */
+			struct SHost {
+				std::string				name;
+				std::string				port;
+				size_t					nSlots;
+				size_t					nRunning;
+				bool					bDown; /* Unreachable, not used until the end */
+			};
+
+			/**
+			 * \returns Host with a free slot or `nullptr`
+			 */
+			SHost*						AcquireHost();
+			void						ReleaseHost(SHost* host, bool bDown);
+
+			std::vector<SHost>			m_hosts;
+			std::mutex					m_mutex; /* Hosts state */
+			std::string					m_token;
+
+			std::atomic<size_t>			m_nRemote								= 0;
+			std::atomic<size_t>			m_nLocal								= 0; /* Fallbacks */
+	};
+
+	/**
+	 * Build node: execute jobs of the clients until it's killed
+	 *
+	 * Clients must send the token of `DELTAMAKE_REMOTE_TOKEN_ENV`, and only the
+	 * allowed compilers are executed, without the options that load plugins,
+	 * replace the tools or write other files
+	 *
+	 * \param address `[host:]port`, loopback if the host is not set
+	 * \param nSlots Jobs executed at once
+	 * \param compilers Allowed compilers separated by commas or spaces, `nullptr` for `DELTAMAKE_REMOTE_COMPILERS`
+	 * \returns Exit status
+	 */
+	int									RunRemoteServer(const char address[], size_t nSlots, const char compilers[]);
+
+	extern CRemoteExecutor* const remoteExecutor;
+}
+
+#endif /* !__DELTAMAKE_REMOTE_H__ */
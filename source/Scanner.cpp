@@ -0,0 +1,257 @@
+/**
+ * \file	Scanner.cpp
+ * \brief	Parallel directory walker of `-s`
+ * \date	14 oct 2026
+ * \author	Reklov
+ */
+#include "Scanner.h"
+
+#include <ctype.h>
+#include <errno.h>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "Terminal.h"
+
+using namespace DeltaMake;
+
+// ******************************************************************************** //
+
+/* ****************************************
+ * DeltaMake::CScanner::CScanner
+ */
+DeltaMake::CScanner::CScanner(const std::filesystem::path& basePath, const std::set<std::string>& extensions, const Json::Value& cache)
+	: m_basePath(std::filesystem::absolute(basePath).lexically_normal()), m_extensions(extensions), m_oldCache(cache) { }
+
+/* ****************************************
+ * DeltaMake::CScanner::Exclude
+ */
+void DeltaMake::CScanner::Exclude(const std::filesystem::path& directory) {
+	m_excluded.insert(std::filesystem::absolute(directory).lexically_normal());
+}
+
+/* ****************************************
+ * DeltaMake::CScanner::Run
+ */
+void DeltaMake::CScanner::Run(const std::vector<std::filesystem::path>& roots, size_t nThreads) {
+	m_startTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+	for (size_t i = 0; i < roots.size(); ++i) {
+		std::filesystem::path root = std::filesystem::absolute(roots[i]).lexically_normal();
+		if (root.has_filename() == false)
+			root = root.parent_path(); // Trailing separator of `"src/"`
+
+		if (m_excluded.count(root) == 0)
+			m_queue.push_back(root);
+	}
+
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < nThreads; ++i)
+		threads.emplace_back(&CScanner::Routine, this);
+
+	Routine();
+
+	for (size_t i = 0; i < threads.size(); ++i)
+		threads[i].join();
+
+	// Roots may overlap
+	std::sort(m_files.begin(), m_files.end(), [](const SScannedFile& a, const SScannedFile& b) { return a.path < b.path; });
+	m_files.erase(std::unique(m_files.begin(), m_files.end(), [](const SScannedFile& a, const SScannedFile& b) { return a.path == b.path; }), m_files.end());
+}
+
+/* ****************************************
+ * DeltaMake::CScanner::GetFiles
+ */
+const std::vector<DeltaMake::SScannedFile>& DeltaMake::CScanner::GetFiles() const {
+	return m_files;
+}
+
+/* ****************************************
+ * DeltaMake::CScanner::GetDirectories
+ */
+const std::vector<std::filesystem::path>& DeltaMake::CScanner::GetDirectories() const {
+	return m_directories;
+}
+
+/* ****************************************
+ * DeltaMake::CScanner::GetCache
+ */
+const Json::Value& DeltaMake::CScanner::GetCache() const {
+	return m_cache;
+}
+
+/* ****************************************
+ * DeltaMake::CScanner::GetListedCount
+ */
+size_t DeltaMake::CScanner::GetListedCount() const {
+	return m_nListed;
+}
+
+/* ****************************************
+ * DeltaMake::CScanner::GetCachedCount
+ */
+size_t DeltaMake::CScanner::GetCachedCount() const {
+	return m_nCached;
+}
+
+/* ****************************************
+ * DeltaMake::CScanner::IsMatch
+ */
+bool DeltaMake::CScanner::IsMatch(const std::filesystem::path& path, const std::set<std::string>& extensions) {
+	std::string extension = path.extension().string();
+	for (size_t i = 0; i < extension.size(); ++i)
+		extension[i] = static_cast<char>(tolower(static_cast<unsigned char>(extension[i])));
+
+	return extensions.count(extension) != 0;
+}
+
+/* ****************************************
+ * DeltaMake::CScanner::Routine
+ */
+void DeltaMake::CScanner::Routine() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (true) {
+		m_event.wait(lock, [this]() { return (m_queue.size() != 0) || (m_nBusy == 0); });
+		if (m_queue.size() == 0)
+			break; // Nobody can add more
+
+		const std::filesystem::path directory = m_queue.back();
+		m_queue.pop_back();
+		++m_nBusy;
+
+		lock.unlock();
+
+		std::vector<std::filesystem::path> directories;
+		std::vector<SScannedFile> files;
+		Json::Value entry;
+		const bool bListed = ScanDirectory(directory, directories, files, entry);
+
+		lock.lock();
+
+		--m_nBusy;
+
+		for (size_t i = 0; i < directories.size(); ++i) {
+			if (m_excluded.count(directories[i]) == 0)
+				m_queue.push_back(directories[i]);
+		}
+
+		m_files.insert(m_files.end(), files.begin(), files.end());
+		m_directories.push_back(directory);
+
+		if (entry.isNull() == false)
+			m_cache[GetKey(directory)].swap(entry);
+
+		if (bListed == true)
+			++m_nListed;
+		else
+			++m_nCached;
+
+		m_event.notify_all();
+	}
+}
+
+/* ****************************************
+ * DeltaMake::CScanner::ScanDirectory
+ */
+bool DeltaMake::CScanner::ScanDirectory(const std::filesystem::path& directory, std::vector<std::filesystem::path>& rDirectories, std::vector<SScannedFile>& rFiles, Json::Value& rEntry) {
+	struct stat stats;
+	if (stat(directory.c_str(), &stats) != 0) {
+		terminal->Log(LOG_WARNING, "Can't scan \"%s\"\n", directory.c_str());
+		return true;
+	}
+
+	const int64_t mtime = static_cast<int64_t>(stats.st_mtim.tv_sec) * 1000000000 + stats.st_mtim.tv_nsec;
+
+	std::vector<std::string> files;
+	std::vector<std::string> directories;
+	bool bListed = true;
+
+	const std::string key = GetKey(directory);
+	const Json::Value* cached = m_oldCache.find(key.data(), key.data() + key.size());
+	if ((cached != nullptr) && (cached->isObject() == true) && ((*cached)["mtime"].isInt64() == true) && ((*cached)["mtime"].asInt64() == mtime)) {
+		const Json::Value& cachedFiles = (*cached)["files"];
+		for (Json::ArrayIndex i = 0; i < cachedFiles.size(); ++i)
+			files.push_back(cachedFiles[i].asString());
+
+		const Json::Value& cachedDirectories = (*cached)["dirs"];
+		for (Json::ArrayIndex i = 0; i < cachedDirectories.size(); ++i)
+			directories.push_back(cachedDirectories[i].asString());
+
+		bListed = false;
+	}
+	else {
+		DIR* dir = opendir(directory.c_str());
+		if (dir == nullptr) {
+			terminal->Log(LOG_WARNING, "Can't scan \"%s\"\n", directory.c_str());
+			return true;
+		}
+
+		for (const dirent* entry = readdir(dir); entry != nullptr; entry = readdir(dir)) {
+			if (entry->d_name[0] == '.')
+				continue; // `.`, `..`, `.git` and others
+
+			unsigned char type = entry->d_type;
+			if (type == DT_UNKNOWN) { // Some file systems don't fill it
+				struct stat entryStats;
+				if (lstat((directory / entry->d_name).c_str(), &entryStats) != 0)
+					continue;
+
+				type = (S_ISDIR(entryStats.st_mode) != 0) ? DT_DIR : ((S_ISLNK(entryStats.st_mode) != 0) ? DT_LNK : DT_REG);
+			}
+
+			if (type == DT_DIR)
+				directories.push_back(entry->d_name);
+			else if (((type == DT_REG) || (type == DT_LNK)) && (IsMatch(entry->d_name, m_extensions) == true)) // Linked directories are not followed, no loops
+				files.push_back(entry->d_name);
+		}
+
+		closedir(dir);
+	}
+
+	for (size_t i = 0; i < directories.size(); ++i)
+		rDirectories.push_back(directory / directories[i]);
+
+	for (size_t i = 0; i < files.size(); ++i) {
+		SScannedFile file;
+		file.path = directory / files[i];
+
+		if ((CFileStat::Get(file.path.c_str(), file.stat) == false) || (file.stat.bRegular == false))
+			continue; // Dangling link or a linked directory
+
+		rFiles.push_back(file);
+	}
+
+	if (mtime + DELTAMAKE_SCAN_RACY_TIME > m_startTime)
+		return bListed;
+
+	rEntry["mtime"] = static_cast<Json::Int64>(mtime);
+
+	Json::Value& entryFiles = rEntry["files"];
+	entryFiles = Json::Value(Json::arrayValue);
+	for (size_t i = 0; i < files.size(); ++i)
+		entryFiles.append(files[i]);
+
+	Json::Value& entryDirectories = rEntry["dirs"];
+	entryDirectories = Json::Value(Json::arrayValue);
+	for (size_t i = 0; i < directories.size(); ++i)
+		entryDirectories.append(directories[i]);
+
+	return bListed;
+}
+
+/* ****************************************
+ * DeltaMake::CScanner::GetKey
+ */
+std::string DeltaMake::CScanner::GetKey(const std::filesystem::path& directory) const {
+	const std::filesystem::path relative = directory.lexically_relative(m_basePath);
+	if ((relative.empty() == false) && (*relative.begin() != ".."))
+		return relative.string();
+
+	return directory.string();
+}
@@ -0,0 +1,128 @@
+/**
+ * \file	Scanner.h
+ * \brief	Parallel directory walker of `-s`
+ * \date	14 oct 2026
+ * \author	Reklov
+ */
+#ifndef __DELTAMAKE_SCANNER_H__
+#define __DELTAMAKE_SCANNER_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <set>
+#include <mutex>
+#include <condition_variable>
+
+#include <json/json.h>
+
+#include "deltamake.h"
+#include "FileStat.h"
+
+
+#define DELTAMAKE_SCAN_MIN_THREADS		4 // Directory reads wait for the disk or NFS, not for the CPU
+#define DELTAMAKE_SCAN_RACY_TIME		1000000000 // ns, directory changed so recently may change again with the same mtime, so it's not cached
+
+// ******************************************************************************** //
+
+										//										//
+namespace DeltaMake {
+	/**
+	 * Found source file
+	 */
+	struct SScannedFile {
+		std::filesystem::path			path;
+		SFileStat						stat;
+	};
+
+	/**
+	 * Walker of directory trees on several threads
+	 *
+	 * Directory listings are cached with the directory mtime, so only the changed
+	 * directories are read again, the others cost one `stat()`
+	 */
+	class CScanner final {
+		public:
+			/**
+			 * \param basePath Cache keys are relative to it
+			 * \param extensions Lower case extensions of the files to find, with the dot
+			 * \param cache Listings of the last scan
+			 */
+										CScanner(const std::filesystem::path& basePath, const std::set<std::string>& extensions, const Json::Value& cache);
+
+			/**
+			 * Directory and its subdirectories are not scanned
+			 */
+			void						Exclude(const std::filesystem::path& directory);
+
+			/**
+			 * Walk the directory trees, hidden entries are skipped
+			 */
+			void						Run(const std::vector<std::filesystem::path>& roots, size_t nThreads);
+
+			/**
+			 * \returns Found files sorted by path
+			 */
+			const std::vector<SScannedFile>& GetFiles() const;
+
+			/**
+			 * \returns All walked directories, a new file changes the mtime of one of them
+			 */
+			const std::vector<std::filesystem::path>& GetDirectories() const;
+
+			/**
+			 * \returns Listings of this scan for the next one
+			 */
+			const Json::Value&			GetCache() const;
+
+			size_t						GetListedCount() const;
+			size_t						GetCachedCount() const;
+
+			/**
+			 * \returns `true` if the extension of the file is one of `extensions`
+			 */
+			static bool					IsMatch(const std::filesystem::path& path, const std::set<std::string>& extensions);
+
+		private:
+			/**
+			 * Thread entry point
+			 */
+			void						Routine();
+
+			/**
+			 * Find files and subdirectories of the directory
+			 * 
+			 * \param rEntry Listing for the cache, stays `null` if the directory is too new for it
+			 * \returns `true` if the directory is read, `false` if the listing is cached
+			 */
+			bool						ScanDirectory(const std::filesystem::path& directory, std::vector<std::filesystem::path>& rDirectories, std::vector<SScannedFile>& rFiles, Json::Value& rEntry);
+
+			/**
+			 * \returns Key of the directory in the cache
+			 */
+			std::string					GetKey(const std::filesystem::path& directory) const;
+
+			const std::filesystem::path m_basePath;
+			const std::set<std::string>& m_extensions;
+			const Json::Value&			m_oldCache; /* Read only, so the threads share it */
+			std::set<std::filesystem::path> m_excluded;
+			int64_t						m_startTime								= 0; /* ns of the system clock */
+
+			std::mutex					m_mutex;
+			std::condition_variable		m_event; /* New directories or the end */
+			std::vector<std::filesystem::path> m_queue;
+			size_t						m_nBusy									= 0; /* Threads that may add directories */
+
+			std::vector<SScannedFile>	m_files;
+			std::vector<std::filesystem::path> m_directories;
+			Json::Value					m_cache									= Json::Value(Json::objectValue);
+			size_t						m_nListed								= 0;
+			size_t						m_nCached								= 0;
+	};
+}
+
+#endif /* !__DELTAMAKE_SCANNER_H__ */
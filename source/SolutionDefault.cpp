@@ -7,19 +7,31 @@
 #include "SolutionDefault.h"
 
 #include <stddef.h>
+#include <time.h>
 
 #include <new>
+#include <algorithm>
 #include <fstream>
 #include <filesystem>
 #include <chrono>
+#include <limits>
 #include <vector>
 #include <string>
+#include <thread>
 
 #include <json/json.h>
 
 #include "deltamake.h"
 #include "Terminal.h"
 #include "Exception.h"
+#include "Hash.h"
+#include "Cache.h"
+#include "Remote.h"
+#include "Watch.h"
+#include "Scanner.h"
+#include "FileStat.h"
+#include "SolutionRegistry.h"
+#include "DiffStore.h"
  
 // ******************************************************************************** //
 
@@ -30,7 +42,7 @@
 /* ****************************************
  * DeltaMake::ISolution::Load
  */
-inline DeltaMake::ISolution* DeltaMake::ISolution::Load(const char path[]) {
+DeltaMake::ISolution* DeltaMake::ISolution::Load(const char path[]) {
 	terminal->Log(LOG_DETAIL, "Loading solution \"%s\"...\n", path);
 	
 	std::filesystem::path currentPath = std::filesystem::absolute(path).parent_path();
@@ -139,21 +151,40 @@ DeltaMake::CSolutionDefault::CSolutionDefault(Json::Value root, std::filesystem:
 		throw CConfigValueNotSet("files");
 	else {
 		terminal->Log(LOG_DETAIL, "Files:\n");
+
+		std::vector<Json::String> keys;
+		std::vector<std::filesystem::path> paths;
 		for (Json::ArrayIndex i = 0; i < files.size(); ++i) {
-			const Json::String relativePath = files[i].asString();
-			terminal->Log(LOG_DETAIL, "\t\"%s\"\n", relativePath.c_str());
-			SSourceFile file;
-			file.path = m_currentPath / relativePath.c_str();
+			keys.push_back(files[i].asString());
+			paths.push_back(m_currentPath / keys.back().c_str());
+			terminal->Log(LOG_DETAIL, "\t\"%s\"\n", keys.back().c_str());
+		}
+
+		// One pass, NFS latency of every file is paid at once
+		std::vector<SFileStat> stats;
+		CFileStat::GetAll(paths, stats);
 
-			if (std::filesystem::exists(file.path) == false) {
-				terminal->Log(LOG_WARNING, "File \"%s\" does not exists!..\n", file.path.c_str());
-				//throw CFileNotExists(file.path.c_str());
+		std::vector<size_t> missing;
+		for (size_t i = 0; i < keys.size(); ++i) {
+			if (stats[i].bExists == false) {
+				missing.push_back(i);
 				continue; // TODO: rewrite solution
 			}
 
-			file.mtime = terminal->GetLastModificationTime(file.path.c_str());
+			SSourceFile file;
+			file.path = paths[i];
+			file.mtime = stats[i].mtime;
+			file.mtimeNs = stats[i].mtimeNs;
+			file.size = stats[i].size;
+			file.bToCompile = false;
+
+			m_sources[keys[i]] = file;
+		}
 
-			m_sources[relativePath] = file;
+		if (missing.size() != 0) {
+			terminal->Log(LOG_WARNING, "%zu files do not exist:\n", missing.size());
+			for (size_t i = 0; i < missing.size(); ++i)
+				terminal->Log(LOG_WARNING, "\t\"%s\"\n", paths[missing[i]].c_str());
 		}
 	}
 
@@ -176,21 +207,52 @@ DeltaMake::CSolutionDefault::CSolutionDefault(Json::Value root, std::filesystem:
  * DeltaMake::CSolutionDefault::ScanFolders
  */
 inline bool DeltaMake::CSolutionDefault::ScanFolders() {
-	terminal->Log(LOG_ERROR, "Default solution type does not have scan mode!\n");
-	return false;
+	const std::set<std::string>& extensions = GetSourceExtensions();
+	if (extensions.size() == 0) {
+		terminal->Log(LOG_ERROR, "Default solution type does not have scan mode!\n");
+		return false;
+	}
+
+	// Listings of the last scan, unchanged directories are not read again
+	CScanner scanner(m_currentPath, extensions, static_cast<const Json::Value&>(m_diffFile)["scan"]);
+	scanner.Exclude(m_buildPath);
+	scanner.Exclude(m_tmpPath);
+	scanner.Run(m_sourcePaths, std::max<size_t>(config->nCores, DELTAMAKE_SCAN_MIN_THREADS));
+
+	std::set<std::filesystem::path> listed;
+	GetListedPaths(listed);
+
+	size_t nAdded = 0;
+	const std::vector<SScannedFile>& files = scanner.GetFiles();
+	for (size_t i = 0; i < files.size(); ++i) {
+		if (AddScannedSource(files[i].path, files[i].stat, listed) == true)
+			++nAdded;
+	}
+
+	// Directories read again are read by every build until it's saved
+	if (scanner.GetCache() != static_cast<const Json::Value&>(m_diffFile)["scan"]) {
+		m_diffFile["scan"] = scanner.GetCache();
+		m_bDiffChanged = true;
+	}
+
+	m_scannedPaths = scanner.GetDirectories();
+
+	terminal->Log(
+		LOG_INFO,
+		"Scan: %zu sources, %zu new (%zu directories read, %zu cached)\n",
+		files.size(),
+		nAdded,
+		scanner.GetListedCount(),
+		scanner.GetCachedCount()
+	);
+
+	return true;
 }
 
 /* ****************************************
  * DeltaMake::CSolutionDefault::GenBuild
  */
 inline DeltaMake::IBuild* DeltaMake::CSolutionDefault::GenBuild(const char build[]) {
-	if (m_diffFile.isNull() == true) {
-		m_diffFile = Json::Value(Json::objectValue);
-		char buffer[32];
-		snprintf(buffer, 32, "%i.%i.%i", DELTAMAKE_VERSION_MAJOR, DELTAMAKE_VERSION_MINOR, DELTAMAKE_VERSION_PATCH);
-		m_diffFile["version"] = buffer;
-	}
-
 	auto iterator = m_builds.find(build);
 	if (iterator == m_builds.end())
 		return nullptr;
@@ -202,26 +264,50 @@ inline DeltaMake::IBuild* DeltaMake::CSolutionDefault::GenBuild(const char build
  * DeltaMake::CSolutionDefault::LoadDiff
  */
 inline bool DeltaMake::CSolutionDefault::LoadDiff(const char path[]) {
-	terminal->Log(LOG_DETAIL, "Loading diff \"%s\"...\n", path);
-	
-	std::ifstream solutionFile(path);
-	if (solutionFile.good() == false) {
-		terminal->Log(LOG_DETAIL, "Can't open \"%s\". Ignoring..\n", path);
-		return false;
-	}
-	
 	Json::Value diff;
-	solutionFile >> diff;
+	bool bLoaded = false;
+
+	// The newer one is of the last build, `--binary-diff` may be set or not
+	const std::filesystem::path binaryPath = CDiffStore::GetBinaryPath(path);
+	SFileStat binaryStat;
+	SFileStat jsonStat;
+	if ((CFileStat::Get(binaryPath.c_str(), binaryStat) == true) && ((CFileStat::Get(path, jsonStat) == false) || (binaryStat.mtimeNs >= jsonStat.mtimeNs))) {
+		terminal->Log(LOG_DETAIL, "Loading diff \"%s\"...\n", binaryPath.c_str());
+		bLoaded = CDiffStore::Load(binaryPath.c_str(), diff);
+	}
+
+	if (bLoaded == false) {
+		terminal->Log(LOG_DETAIL, "Loading diff \"%s\"...\n", path);
+
+		std::ifstream solutionFile(path);
+		if (solutionFile.good() == true) {
+			solutionFile >> diff;
+			bLoaded = true;
+		}
+		else
+			terminal->Log(LOG_DETAIL, "Can't open \"%s\". Ignoring..\n", path);
+	}
 
 	// Version
 	const Json::Value& version = diff["version"];
-	if (version.isString() == false) {
+	if ((bLoaded == true) && (version.isString() == false)) {
 		terminal->Log(LOG_ERROR, "Can't get version\n", path);
 		return false;
 	}
 
 	// TODO: check version
-	terminal->Log(LOG_DETAIL, "Diff version: %s\n", version.asCString());
+	if (bLoaded == true)
+		terminal->Log(LOG_DETAIL, "Diff version: %s\n", version.asCString());
+	else
+		diff = Json::Value(Json::objectValue);
+
+	// Tasks finished after the last save, by an interrupted or failed build
+	const size_t nRecords = CDiffJournal::Replay(CDiffStore::GetJournalPath(path).c_str(), diff);
+	if (nRecords != 0)
+		terminal->Log(LOG_DETAIL, "%zu diff journal records applied\n", nRecords);
+
+	if ((bLoaded == false) && (nRecords == 0))
+		return false;
 
 	m_diffFile = diff;
 
@@ -234,26 +320,331 @@ inline bool DeltaMake::CSolutionDefault::LoadDiff(const char path[]) {
 inline bool DeltaMake::CSolutionDefault::SaveDiff(const char path[]) {
 	terminal->Log(LOG_DETAIL, "Saving diff \"%s\"...\n", path);
 
-	std::ofstream file;
-	file.open(path);
+	if (m_diffFile["version"].isString() == false) { // Not loaded
+		char buffer[32];
+		snprintf(buffer, 32, "%i.%i.%i", DELTAMAKE_VERSION_MAJOR, DELTAMAKE_VERSION_MINOR, DELTAMAKE_VERSION_PATCH);
+		m_diffFile["version"] = buffer;
+	}
+
+	if (config->bBinaryDiff == true) {
+		if (CDiffStore::Save(CDiffStore::GetBinaryPath(path).c_str(), m_diffFile) == false)
+			return false;
+	}
+	else {
+		std::ofstream file;
+		file.open(path);
+
+		Json::StyledWriter writer;
+		file << writer.write(m_diffFile);
+
+		file.close();
+	}
+
+	// Everything of the journal is saved too
+	m_journal.Close();
+	std::error_code error;
+	std::filesystem::remove(CDiffStore::GetJournalPath(path), error);
+
+	m_bDiffChanged = false;
+
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionDefault::IsDiffChanged
+ */
+bool DeltaMake::CSolutionDefault::IsDiffChanged() const {
+	return m_bDiffChanged;
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionDefault::GetSourceFlags
+ */
+std::string DeltaMake::CSolutionDefault::GetSourceFlags(const std::string& /* build */, const SSourceFile& /* file */, const std::filesystem::path& /* outPath */) {
+	return "";
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionDefault::GetSourceInputs
+ */
+bool DeltaMake::CSolutionDefault::GetSourceInputs(const SSourceFile& /* file */, const std::filesystem::path& /* outPath */, std::vector<std::string>& /* rInputs */) const {
+	return true; // The source only
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionDefault::SetSourceInputs
+ */
+void DeltaMake::CSolutionDefault::SetSourceInputs(const SSourceFile& /* file */, const std::filesystem::path& /* outPath */, const std::vector<std::string>& /* inputs */) const {
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionDefault::IsSourceOutdated
+ */
+bool DeltaMake::CSolutionDefault::IsSourceOutdated(const std::string& /* build */, const Json::String& /* source */, int64_t /* builtTime */) {
+	return false; // Wizardry is not included
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionDefault::OnSourceCompiled
+ */
+void DeltaMake::CSolutionDefault::OnSourceCompiled(const std::string& /* build */, const Json::String& /* source */, const std::filesystem::path& /* outPath */) {
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionDefault::GetSourceExtensions
+ */
+const std::set<std::string>& DeltaMake::CSolutionDefault::GetSourceExtensions() const {
+	static const std::set<std::string> extensions; // Wizardry is not included
+
+	return extensions;
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionDefault::GetUnityExtension
+ */
+std::string DeltaMake::CSolutionDefault::GetUnityExtension(const SSourceFile& /* file */) const {
+	return std::string();
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionDefault::WriteUnitySource
+ */
+bool DeltaMake::CSolutionDefault::WriteUnitySource(const std::filesystem::path& /* path */, const std::vector<const SSourceFile*>& /* files */) const {
+	return false;
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionDefault::GenPrecompiledHeader
+ */
+bool DeltaMake::CSolutionDefault::GenPrecompiledHeader(const std::string& /* build */, const Json::Value& /* config */, const std::string& /* compiler */, SPrecompiledHeader& /* rHeader */) {
+	return false;
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionDefault::GenScanTasks
+ */
+size_t DeltaMake::CSolutionDefault::GenScanTasks(ITaskList* /* taskList */, const std::string& /* build */, const Json::Value& /* config */, const std::string& /* compiler */, const std::string& /* flagsBegin */) {
+	return 0;
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionDefault::ScanSourceDeps
+ */
+void DeltaMake::CSolutionDefault::ScanSourceDeps(const std::string& /* build */) {
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionDefault::GetSourceDeps
+ */
+void DeltaMake::CSolutionDefault::GetSourceDeps(const std::string& /* build */, const Json::String& /* source */, std::vector<Json::String>& /* rDeps */) const {
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionDefault::GetListedPaths
+ */
+void DeltaMake::CSolutionDefault::GetListedPaths(std::set<std::filesystem::path>& rPaths) const {
+	for (auto iterator = m_sources.begin(); iterator != m_sources.end(); ++iterator) {
+		if (iterator->second.bScanned == false)
+			rPaths.insert(CWatcher::Normalize(iterator->second.path));
+	}
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionDefault::AddScannedSource
+ */
+bool DeltaMake::CSolutionDefault::AddScannedSource(const std::filesystem::path& path, const SFileStat& stat, const std::set<std::filesystem::path>& listed) {
+	const std::filesystem::path normalized = CWatcher::Normalize(path);
+
+	// Same key as in `files`, so the diff entry is the same
+	Json::String key = normalized.lexically_relative(m_currentPath.lexically_normal()).string();
+	if (key.size() == 0)
+		key = normalized.string();
+
+	if ((m_sources.count(key) != 0) || (listed.count(normalized) != 0)) // Also `files` with another spelling
+		return false;
+
+	SSourceFile file;
+	file.path = normalized;
+	file.mtime = stat.mtime;
+	file.mtimeNs = stat.mtimeNs;
+	file.size = stat.size;
+	file.bToCompile = false;
+	file.bScanned = true;
 
-	Json::StyledWriter writer;
-	file << writer.write(m_diffFile);
+	terminal->Log(LOG_DETAIL, "Found \"%s\"\n", key.c_str());
+	m_sources[key] = file;
 
-	file.close();
 	return true;
 }
 
+/* ****************************************
+ * DeltaMake::CSolutionDefault::GetWatchPaths
+ */
+void DeltaMake::CSolutionDefault::GetWatchPaths(std::vector<std::filesystem::path>& rPaths) const {
+	for (size_t i = 0; i < m_sourcePaths.size(); ++i)
+		rPaths.push_back(m_sourcePaths[i]);
+
+	for (auto iterator = m_sources.begin(); iterator != m_sources.end(); ++iterator)
+		rPaths.push_back(iterator->second.path);
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionDefault::GetGraphInputs
+ */
+void DeltaMake::CSolutionDefault::GetGraphInputs(std::vector<std::filesystem::path>& rPaths) const {
+	GetWatchPaths(rPaths);
+	rPaths.insert(rPaths.end(), m_scannedPaths.begin(), m_scannedPaths.end());
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionDefault::Update
+ */
+bool DeltaMake::CSolutionDefault::Update(const std::set<std::filesystem::path>& changed) {
+	bool bChanged = false;
+
+	// New sources of `paths.scan`
+	if (config->bScan == true) {
+		std::set<std::filesystem::path> listed;
+		bool bListed = false;
+
+		for (auto path = changed.begin(); path != changed.end(); ++path) {
+			if ((CScanner::IsMatch(*path, GetSourceExtensions()) == false) || (IsScanned(*path) == false))
+				continue;
+
+			SFileStat stat;
+			if ((CFileStat::Get(path->c_str(), stat) == false) || (stat.bRegular == false))
+				continue;
+
+			if (bListed == false) {
+				GetListedPaths(listed);
+				bListed = true;
+			}
+
+			if (AddScannedSource(*path, stat, listed) == true)
+				bChanged = true;
+		}
+	}
+
+	for (auto iterator = m_sources.begin(); iterator != m_sources.end();) {
+		SSourceFile& file = iterator->second;
+		if (IsChanged(changed, file.path) == false) {
+			++iterator;
+			continue;
+		}
+
+		SFileStat stat;
+		const bool bExists = CFileStat::Get(file.path.c_str(), stat);
+		if ((bExists == false) && (file.bScanned == true)) {
+			terminal->Log(LOG_DETAIL, "\"%s\" is removed\n", iterator->first.c_str());
+			iterator = m_sources.erase(iterator);
+			bChanged = true;
+			continue;
+		}
+
+		// Removed one of `files` fails to compile, like the first time
+		const int64_t mtime = (bExists == true) ? stat.mtimeNs : std::numeric_limits<int64_t>::max();
+		if (mtime != file.mtimeNs) {
+			terminal->Log(LOG_DETAIL, "\"%s\" is changed\n", iterator->first.c_str());
+			bChanged = true;
+		}
+
+		file.mtime = (bExists == true) ? stat.mtime : std::numeric_limits<time_t>::max();
+		file.mtimeNs = mtime;
+		file.size = stat.size;
+
+		++iterator;
+	}
+
+	return bChanged;
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionDefault::IsScanned
+ */
+bool DeltaMake::CSolutionDefault::IsScanned(const std::filesystem::path& path) const {
+	const std::filesystem::path normalized = CWatcher::Normalize(path);
+
+	auto isInside = [&normalized](const std::filesystem::path& directory) {
+		const std::filesystem::path relative = normalized.lexically_relative(CWatcher::Normalize(directory));
+		return (relative.empty() == false) && (*relative.begin() != "..");
+	};
+
+	if ((isInside(m_buildPath) == true) || (isInside(m_tmpPath) == true))
+		return false;
+
+	for (size_t i = 0; i < m_sourcePaths.size(); ++i) {
+		if (isInside(m_sourcePaths[i]) == false)
+			continue;
+
+		// Hidden ones are skipped by the scan too
+		const std::filesystem::path relative = normalized.lexically_relative(CWatcher::Normalize(m_sourcePaths[i]));
+		for (auto part = relative.begin(); part != relative.end(); ++part) {
+			if (part->string()[0] == '.')
+				return false;
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionDefault::IsChanged
+ */
+bool DeltaMake::CSolutionDefault::IsChanged(const std::set<std::filesystem::path>& changed, const std::filesystem::path& path) {
+	std::filesystem::path normalized = CWatcher::Normalize(path);
+	if (changed.count(normalized) != 0)
+		return true;
+
+	// Directory of a file event, or a removed or moved one above it
+	while ((normalized.has_parent_path() == true) && (normalized != normalized.root_path())) {
+		normalized = normalized.parent_path();
+		if (changed.count(normalized) != 0)
+			return true;
+	}
+
+	return false;
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionDefault::RecordDiff
+ */
+void DeltaMake::CSolutionDefault::RecordDiff(const std::vector<Json::String>& keys, const Json::Value& value) {
+	if ((config->bBinaryDiff == false) || (config->bDontSaveDiff == true) || (m_bJournalFailed == true))
+		return;
+
+	if (m_journal.IsOpen() == false) {
+		const std::filesystem::path path = CDiffStore::GetJournalPath(m_currentPath / DELTAMAKE_DIFF_FILENAME);
+		if (m_journal.Open(path.c_str()) == false) {
+			terminal->Log(LOG_WARNING, "Can't open diff journal \"%s\"\n", path.c_str());
+			m_bJournalFailed = true;
+			return;
+		}
+	}
+
+	if (m_journal.Write(keys, value) == false) {
+		terminal->Log(LOG_WARNING, "Can't write diff journal\n");
+		m_journal.Close();
+		m_bJournalFailed = true;
+	}
+}
+
 // ******************************************************************************** //
 
 /* ****************************************
  * DeltaMake::CBuild::CBuild
  */
-DeltaMake::CBuild::CBuild(CSolutionDefault* solution, const Json::Value& build, std::string name) : m_solution(solution), m_build(build), m_name(name) {
+DeltaMake::CBuild::CBuild(CSolutionDefault* solution, const Json::Value& build, std::string name) : m_name(name), m_build(build), m_solution(solution) {
+	const CSolutionDefault* root = dynamic_cast<const CSolutionDefault*>(config->root);
+	m_rootPath = ((root != nullptr) ? root->m_currentPath : m_solution->m_currentPath).lexically_normal();
+
 	const Json::Value subs = m_build["solutions"];
 	if (subs.isObject() == false)
 		terminal->Log(LOG_DETAIL, "No sub solutions setted. Ignoring...\n");
 	else {
+		std::vector<SSubSolution> loads;
+		std::vector<std::string> buildNames;
 		for(auto iterator = subs.begin(); iterator != subs.end(); ++iterator) {
 			const Json::String code = iterator.key().asString();
 			auto iterName = solution->m_subSolutions.find(code);
@@ -264,14 +655,8 @@ DeltaMake::CBuild::CBuild(CSolutionDefault* solution, const Json::Value& build,
 
 			SSubSolution sub;
 			sub.path = m_solution->m_currentPath / iterName->second;
-			sub.solution = dynamic_cast<CSolutionDefault*>(ISolution::Load((sub.path / std::string(DELTAMAKE_CONFIG_FILENAME)).c_str()));
-			if (sub.solution == nullptr) {
-				terminal->Log(LOG_ERROR, "Can't load solution: \"%s\"\n", iterName->second.c_str());
-				return; // TODO: exception
-			}
-
-			sub.solution->m_buildPath = m_solution->m_buildPath;
-			sub.solution->m_tmpPath   = m_solution->m_tmpPath;
+			sub.solution = nullptr;
+			sub.build = nullptr;
 
 			const Json::Value& params = (*iterator);
 			const Json::Value& buildName = params["build"];
@@ -281,16 +666,32 @@ DeltaMake::CBuild::CBuild(CSolutionDefault* solution, const Json::Value& build,
 			else
 				name = buildName.asString();
 
-			sub.build = sub.solution->GenBuild(name.c_str());
-			if (sub.build == nullptr) {
-				terminal->Log(LOG_ERROR, "Build not found: \"%s\"\n", name.c_str());
-				return; // TODO: exception
-			}
+			loads.push_back(sub);
+			buildNames.push_back(name);
+		}
+
+		// Independent sub trees are loaded at once, shared ones are loaded by the first parent
+		const CSolutionRegistry::TKey key = CSolutionRegistry::GetKey(m_solution->m_currentPath, m_name);
+		auto load = [this, &loads, &buildNames, &key](size_t i) {
+			loads[i].build = solutionRegistry->GetBuild(key, loads[i].path, buildNames[i], m_solution->m_buildPath, m_solution->m_tmpPath);
+		};
+
+		std::vector<std::thread> threads;
+		for (size_t i = 1; i < loads.size(); ++i)
+			threads.emplace_back(load, i);
+
+		if (loads.size() != 0)
+			load(0);
 
-			if (config->bForce == false)
-				sub.solution->LoadDiff((sub.path / std::string(DELTAMAKE_DIFF_FILENAME)).c_str());
+		for (size_t i = 0; i < threads.size(); ++i)
+			threads[i].join();
 
-			m_subs.push_back(sub);
+		for (size_t i = 0; i < loads.size(); ++i) {
+			if (loads[i].build == nullptr)
+				return; // TODO: exception
+
+			loads[i].solution = loads[i].build->m_solution;
+			m_subs.push_back(loads[i]);
 		}
 	}
 }
@@ -299,6 +700,9 @@ DeltaMake::CBuild::CBuild(CSolutionDefault* solution, const Json::Value& build,
  * DeltaMake::CBuild::PreBuild
  */
 inline bool DeltaMake::CBuild::PreBuild() {
+	if (Visit(m_preBuildRun) == false)
+		return true; // Shared sub build, done by another parent
+
 	// Check paths
 	if (std::filesystem::exists(m_solution->m_buildPath) == false) {
 		terminal->Log(LOG_DETAIL, "Build directory does not exists. Creating...\n");
@@ -326,26 +730,44 @@ inline bool DeltaMake::CBuild::PreBuild() {
 }
 
 /* ****************************************
- * DeltaMake::CBuild::PostBuild
+ * DeltaMake::CBuild::Scan
+ */
+size_t DeltaMake::CBuild::Scan(ITaskList* taskList) {
+	if (Visit(m_scanRun) == false)
+		return 0; // Shared sub build, done by another parent
+
+	size_t nTasks = 0;
+	for (size_t i = 0; i < m_subs.size(); ++i)
+		nTasks += m_subs[i].build->Scan(taskList);
+
+	GenFlagsBegin(m_compiler, m_compileBegin, m_flagsBegin);
+
+	return nTasks + m_solution->GenScanTasks(taskList, m_name, m_build["modules"], m_compiler, m_flagsBegin);
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::Build
  */
 inline size_t DeltaMake::CBuild::Build(ITaskList* taskList) {
-	bool bReLink = false; // Relink all objects
+	if (Visit(m_buildRun) == true)
+		m_nTasks = GenerateTasks(taskList);
 
-	// Subs
-	for (size_t i = 0; i < m_subs.size(); ++i) {
-		if (m_subs[i].build->Build(taskList) != 0)
-			bReLink = true;
-	}
+	return m_nTasks; // Same for every parent of a shared sub build
+}
 
-	// Build
-	std::string cmdBegin = "";
+/* ****************************************
+ * DeltaMake::CBuild::GenFlagsBegin
+ */
+void DeltaMake::CBuild::GenFlagsBegin(std::string& rCompiler, std::string& rCompileBegin, std::string& rFlagsBegin) const {
 	const Json::Value& compiler = m_build["compiler"];
 	if (compiler.isString() == false) {
 		terminal->Log(LOG_DETAIL, "Compiler is not set. Default value is used.\n");
-		cmdBegin += "g++ ";
+		rCompiler = "g++";
 	}
 	else
-		cmdBegin += compiler.asString() + " ";
+		rCompiler = compiler.asString();
+
+	std::string cmdBegin = rCompiler + " ";
 
 
 	const Json::Value& compilerFlags = m_build["compilerFlags"];
@@ -354,6 +776,8 @@ inline size_t DeltaMake::CBuild::Build(ITaskList* taskList) {
 	else
 		cmdBegin += compilerFlags.asString() + " ";
 
+	rCompileBegin = cmdBegin.substr(0, cmdBegin.size() - 1);
+
 	
 	const Json::Value& paths = m_build["paths"];
 	if (paths.isObject() == false)
@@ -385,8 +809,59 @@ inline size_t DeltaMake::CBuild::Build(ITaskList* taskList) {
 			cmdBegin += "-D\"" + defines[i].asString() + "\" ";
 	}
 
+	rFlagsBegin = cmdBegin;
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::GenerateTasks
+ */
+size_t DeltaMake::CBuild::GenerateTasks(ITaskList* taskList) {
+	// State of the last build (`--watch`)
+	m_bLink = false;
+	m_linkTask = DELTAMAKE_TASK_NONE;
+	m_linkExec.clear();
+	m_bArchiveAll = false;
+	m_pendingLinkHash.clear();
+	m_objects.clear();
+	m_taskSources.clear();
+	m_sourceHashes.clear();
+	m_cacheItems.clear();
+	m_bPch = false;
+	m_pchTask = DELTAMAKE_TASK_NONE;
+	m_bUnity = false;
+	m_unityBatches.clear();
+	m_unitySources.clear();
+	m_unityTasks.clear();
+	m_sourceDeps.clear();
+	m_orderedSources.clear();
+	m_expires = std::numeric_limits<time_t>::max();
+
+	// Subs
+	for (size_t i = 0; i < m_subs.size(); ++i)
+		m_subs[i].build->Build(taskList);
+
+	// Build, the flags are generated by `Scan()`
+	const std::string& compiler = m_compiler;
+	const std::string& remoteCompile = m_compileBegin; // Build nodes get the preprocessed source, so paths and defines are not needed there
+	std::string cmdBegin = m_flagsBegin;
+
+	const std::string preprocessBegin = cmdBegin + "-E ";
+	const std::string flagsBegin = cmdBegin;
 	cmdBegin += "-c ";
 
+	// Flags change must recompile everything compiled with the old ones, the precompiled header doesn't change objects
+	m_commandHash = GetCommandHash(cmdBegin + DELTAMAKE_OBJECT_NAMING);
+
+	// Not counted, the objects don't change with it
+	m_bPch = GenPchTask(taskList, flagsBegin, compiler);
+	const std::vector<TaskHandle> pchDeps = (m_pchTask != DELTAMAKE_TASK_NONE) ? std::vector<TaskHandle>{ m_pchTask } : std::vector<TaskHandle>();
+
+	m_solution->ScanSourceDeps(m_name);
+
+	std::string cachePrefix;
+	if (objectCache->IsEnabled() == true)
+		cachePrefix = objectCache->GetCompilerId(compiler) + "\n" + cmdBegin;
+
 	Json::Value& diff = m_solution->m_diffFile["diff"];
 	if (diff.isObject() == false) {
 		terminal->Log(LOG_DETAIL, "No diff data. Ignoring...\n");
@@ -399,71 +874,973 @@ inline size_t DeltaMake::CBuild::Build(ITaskList* taskList) {
 		buildDiff = Json::Value(Json::objectValue);
 	}
 
+	const Json::Value& rBuildDiff = buildDiff; // Reading without adding null members
+
+	const Json::Value& linkDiff = static_cast<const Json::Value&>(m_solution->m_diffFile)["link"][m_name];
+	const int64_t linked = GetBuiltTime(linkDiff);
+
+	const Json::Value& linkHash = linkDiff["hash"];
+	if (linkHash.isString() == true) {
+		m_linkHash = linkHash.asString();
+		m_bLinkHash = true;
+	}
+
+	// Configured memory is for the heaviest ones, where the peak of the last time is not enough
+	const Json::Value& memory = m_build["memory"];
+	const uint64_t compileMemory = ((memory.isObject() == true) && (memory["compile"].isNumeric() == true)) ? memory["compile"].asLargestUInt() : 0;
+	const uint64_t linkMemory = ((memory.isObject() == true) && (memory["link"].isNumeric() == true)) ? memory["link"].asLargestUInt() : 0;
+
 	size_t nToExecute = 0;
+	std::vector<TaskHandle> deps; // Of the link task
+	std::vector<TaskHandle> unknown; // Tasks without duration history
+	std::vector<TaskHandle> unknownMemory; // Tasks without peak RSS history
+
+	uint64_t knownDuration = 0;
+	uint64_t knownMemory = 0;
+	size_t nKnownMemory = 0;
+
+	std::set<std::filesystem::path> changed; // Objects compiled since the last link
+
+	const std::vector<TSourceMap::iterator> order = GenSourceOrder();
+	std::map<Json::String, TaskHandle> sourceTasks; // Of the ordered sources
+
+	// Objects are checked too, all of them at once
+	std::vector<std::filesystem::path> outPaths(order.size());
+	for (size_t n = 0; n < order.size(); ++n)
+		outPaths[n] = GetObjectPath(order[n]->second);
+
+	std::vector<SFileStat> outStats;
+	CFileStat::GetAll(outPaths, outStats);
+
+	GenUnityBatches(rBuildDiff);
+
 	terminal->Log(LOG_DETAIL, "Commands:\n");
-	for(auto iterator = m_solution->m_sources.begin(); iterator != m_solution->m_sources.end(); ++iterator) {
+	for (size_t n = 0; n < order.size(); ++n) {
+		const TSourceMap::iterator iterator = order[n];
 		const SSourceFile& file = iterator->second;
 		const std::string stem = std::string(file.path.stem());
-		const std::filesystem::path outPath = m_solution->m_tmpPath / (m_name + "_" + stem);
-		m_objects.push_back(outPath);
+		const std::filesystem::path& outPath = outPaths[n];
+
+		auto unity = m_unitySources.find(iterator->first);
+		if (unity == m_unitySources.end())
+			m_objects.push_back(outPath); // Objects of the batches are linked instead
+
+		const Json::Value& entry = rBuildDiff[iterator->first];
+		if ((linked != 0) && (GetBuiltTime(entry) >= linked)) // Seconds of the older diffs may be the same
+			changed.insert((unity != m_unitySources.end()) ? m_unityBatches[unity->second].outPath : outPath);
+		const bool bChanged = (GetDiffTime(entry) < file.mtimeNs);
+		const bool bCommand = (entry.isObject() == false) || (entry["cmd"] != m_commandHash);
+
+		// A dependency compiled again changes what the source gets from it
+		std::vector<TaskHandle> sourceDeps;
+		bool bDepsNewer = false;
+		auto dependencies = m_sourceDeps.find(iterator->first);
+		if (dependencies != m_sourceDeps.end()) {
+			for (size_t i = 0; i < dependencies->second.size(); ++i) {
+				auto task = sourceTasks.find(dependencies->second[i]);
+				if (task != sourceTasks.end())
+					sourceDeps.push_back(task->second);
+				else if (GetBuiltTime(rBuildDiff[dependencies->second[i]]) > GetBuiltTime(entry)) // Compiled by a run that didn't get to the source
+					bDepsNewer = true;
+			}
 
-		const Json::Value& fileTime = buildDiff[iterator->first];
-		if (fileTime.isNumeric() == true) {
-			time_t lastTime = static_cast<time_t>(buildDiff[iterator->first].asLargestInt());
-			if (lastTime >= file.mtime) {
-				continue;
+			if ((entry.isObject() == true) && ((sourceDeps.size() != 0) || (bDepsNewer == true)))
+				terminal->Log(LOG_DETAIL, "\"%s\" has changed dependencies\n", iterator->first.c_str());
+		}
+
+		const bool bOutdated = bCommand || (sourceDeps.size() != 0) || bDepsNewer || m_solution->IsSourceOutdated(m_name, iterator->first, GetBuiltTime(entry)) ||
+			((unity == m_unitySources.end()) && (IsOutputStale(iterator->first.c_str(), entry, outStats[n]) == true)); // Objects of the batches are checked by them
+		if ((bChanged == false) && (bOutdated == false))
+			continue;
+
+		if ((bCommand == true) && (entry.isObject() == true))
+			terminal->Log(LOG_DETAIL, "\"%s\" compile command is changed\n", iterator->first.c_str());
+
+		if (config->bChecksum == true) {
+			uint64_t hash;
+			if (CHash::HashFile(file.path.c_str(), hash) == true) {
+				const std::string hex = CHash::ToString(hash);
+				m_sourceHashes[iterator->first] = hex;
+
+				const bool bSame = (entry.isObject() == true) && (entry["hash"].isString() == true) && (entry["hash"].asString() == hex);
+				if ((bOutdated == false) && (bSame == true)) { // Just touched
+					terminal->Log(LOG_DETAIL, "\"%s\" content is not changed\n", iterator->first.c_str());
+					buildDiff[iterator->first]["mtime"] = static_cast<Json::Int64>(file.mtimeNs);
+					m_solution->m_bDiffChanged = true; // Else it's hashed again by every build
+					continue;
+				}
 			}
 		}
 
+		if (unity != m_unitySources.end()) { // The whole batch is compiled
+			m_unityBatches[unity->second].bOutdated = true;
+			continue;
+		}
+
 		m_bLink = true;
 		
 		++nToExecute;
-		buildDiff[iterator->first] = file.mtime;
 		
-		std::string cmd = cmdBegin + "\"" + file.path.c_str() + "\" -o \"" + outPath.c_str() + "\"";
+		const bool bPch = IsPchUsed(file);
+		std::string cmd = cmdBegin + ((bPch == true) ? m_pch.useFlags : std::string()) + m_solution->GetSourceFlags(m_name, file, outPath) + "\"" + file.path.c_str() + "\" -o \"" + outPath.c_str() + "\"";
 
 		terminal->Log(LOG_DETAIL, "\t%s\n", cmd.c_str());
 		
-		taskList->AddCommand(stem.c_str(), cmd);
-	}
+		if (bPch == true)
+			sourceDeps.insert(sourceDeps.end(), pchDeps.begin(), pchDeps.end());
+
+		const TaskHandle task = taskList->AddCommand(stem.c_str(), cmd, sourceDeps);
+		if (task == DELTAMAKE_TASK_NONE)
+			continue;
+
+		taskList->SetListener(task, this);
+		m_taskSources[task] = iterator->first;
+		deps.push_back(task);
+		changed.insert(outPath);
+
+		// Outputs besides the object (like module interfaces) are not sent back or cached
+		const bool bOrdered = m_orderedSources.count(iterator->first) != 0;
+		if (bOrdered == true)
+			sourceTasks[iterator->first] = task;
+
+		if ((remoteExecutor->IsEnabled() == true) && (bOrdered == false)) {
+			SRemoteCommand remote;
+			remote.source = std::string(outPath.c_str()) + ((file.path.extension() == ".c") ? ".i" : ".ii");
+			remote.preprocess = preprocessBegin + ((bPch == true) ? m_pch.preprocessFlags : std::string()) + m_solution->GetSourceFlags(m_name, file, outPath) + "\"" + file.path.c_str() + "\" -o \"" + remote.source.c_str() + "\"";
+			remote.compile = remoteCompile;
+			remote.outPath = outPath;
+			taskList->SetRemote(task, remote);
+		}
 
-	return nToExecute;
-}
+		if ((objectCache->IsEnabled() == true) && (bPch == false) && (bOrdered == false)) { // Depfiles of the precompiled header users miss its headers
+			SCacheItem& item = m_cacheItems[task];
+			item.file = &file;
+			item.outPath = outPath;
+			item.prefix = cachePrefix;
+			taskList->SetCache(task, this);
+		}
 
-/* ****************************************
- * DeltaMake::CBuild::PostBuild
- */
-inline bool DeltaMake::CBuild::PostBuild() {
-	// Subs
-	for (size_t i = 0; i < m_subs.size(); ++i) {
-		m_subs[i].build->PostBuild();
+		// Peak RSS of the last compile, KiB
+		if (compileMemory != 0)
+			taskList->SetResources(task, ETaskClass::COMPILE, compileMemory);
+		else if ((entry.isObject() == true) && (entry["rss"].isNumeric() == true)) {
+			const uint64_t rss = (entry["rss"].asLargestUInt() + 1023) >> 10;
+			taskList->SetResources(task, ETaskClass::COMPILE, rss);
+			knownMemory += rss;
+			++nKnownMemory;
+		}
+		else
+			unknownMemory.push_back(task);
 
-		if (config->bForce == false)
-			m_subs[i].solution->SaveDiff((m_subs[i].path / std::string(DELTAMAKE_DIFF_FILENAME)).c_str());
+		// Last compile time is the best guess
+		if ((entry.isObject() == true) && (entry["time"].isNumeric() == true)) {
+			const uint64_t duration = entry["time"].asLargestUInt();
+			taskList->SetEstimate(task, duration);
+			knownDuration += duration;
+		}
+		else
+			unknown.push_back(task);
 	}
 
-	if (m_bLink == false) {
-		terminal->Log(LOG_DETAIL, "Nothing to link.\n");
-		return true;
+	for (size_t i = 0; i < m_unityBatches.size(); ++i) {
+		SUnityBatch& batch = m_unityBatches[i];
+		m_objects.push_back(batch.outPath);
+
+		if (batch.bOutdated == false) {
+			SFileStat stat;
+			CFileStat::Get(batch.outPath.c_str(), stat);
+			batch.bOutdated = IsOutputStale(batch.outPath.filename().c_str(), rBuildDiff[batch.sources[0]], stat);
+			if (batch.bOutdated == false)
+				continue;
+		}
+
+		m_bLink = true;
+		++nToExecute;
+
+		uint64_t duration;
+		uint64_t rss;
+		const TaskHandle task = AddUnityTask(taskList, batch, cmdBegin, pchDeps, rBuildDiff, duration, rss);
+		if (task == DELTAMAKE_TASK_NONE)
+			continue;
+
+		m_unityTasks[task] = i;
+		deps.push_back(task);
+		changed.insert(batch.outPath);
+
+		if (compileMemory != 0)
+			taskList->SetResources(task, ETaskClass::COMPILE, compileMemory);
+		else if (rss != 0) {
+			taskList->SetResources(task, ETaskClass::COMPILE, rss);
+			knownMemory += rss;
+			++nKnownMemory;
+		}
+		else
+			unknownMemory.push_back(task);
+
+		if (duration != 0) {
+			taskList->SetEstimate(task, duration);
+			knownDuration += duration;
+		}
+		else
+			unknown.push_back(task);
+	}
+
+	// New ones are as average as the known ones
+	if ((unknown.size() != 0) && (unknown.size() != deps.size())) {
+		const uint64_t average = knownDuration / (deps.size() - unknown.size());
+		for (size_t i = 0; i < unknown.size(); ++i)
+			taskList->SetEstimate(unknown[i], average);
+	}
+
+	if ((unknownMemory.size() != 0) && (nKnownMemory != 0)) {
+		const uint64_t average = knownMemory / nKnownMemory;
+		for (size_t i = 0; i < unknownMemory.size(); ++i)
+			taskList->SetResources(unknownMemory[i], ETaskClass::COMPILE, average);
 	}
 
 	Json::Value type = m_build["type"];
 	if (type.isString() == false) {
-		terminal->Log(LOG_DETAIL, "Compiler is not set. Default value is used.\n");
+		terminal->Log(LOG_DETAIL, "Build type is not set. Default value is used.\n");
 		type = "exec";
 	}
 
+	m_type = type.asString();
+	if (type == "exec") { // Sub solutions' libraries are linked too
+		std::vector<TaskHandle> outputs;
+		for (size_t i = 0; i < m_subs.size(); ++i)
+			m_subs[i].build->GetOutputTasks(outputs);
+
+		// Only a library that is archived again changes the executable
+		if (outputs.size() != 0)
+			m_bLink = true;
+		else if ((m_bLink == false) && (IsOutputNewer(linked) == true)) {
+			terminal->Log(LOG_DETAIL, "Sub build outputs are newer than the link.\n");
+			m_bLink = true;
+		}
+
+		deps.insert(deps.end(), outputs.begin(), outputs.end());
+
+		// Shared sub builds are reached more than once
+		std::sort(deps.begin(), deps.end());
+		deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+	}
+
+	if (GenLinkCommand(type) == false)
+		return nToExecute;
+
+	const bool bCommand = linkDiff["cmd"] != GetCommandHash(m_linkCommand);
+	if ((m_bLink == false) && (bCommand == true)) {
+		terminal->Log(LOG_DETAIL, "Link command is changed.\n");
+		m_bLink = true;
+	}
+
+	SFileStat outStat;
+	CFileStat::Get(m_outPath.c_str(), outStat);
+	const bool bOutputStale = (linked != 0) && (IsOutputStale(m_outPath.filename().c_str(), linkDiff, outStat) == true);
+	if (bOutputStale == true)
+		m_bLink = true;
+
+	if (m_bLink == false) {
+		terminal->Log(LOG_DETAIL, "Nothing to link.\n");
+		return nToExecute;
+	}
+
+	// Members of the same objects are replaced in place. Other ones, or a missing archive, are archived again from scratch
+	std::vector<std::filesystem::path> members = m_objects;
+	if (type == "lib") {
+		m_bArchiveAll = (bCommand == true) || (linked == 0) || (bOutputStale == true);
+		if (m_bArchiveAll == false) {
+			members.clear();
+			for (size_t i = 0; i < m_objects.size(); ++i) {
+				if (changed.count(m_objects[i]) != 0)
+					members.push_back(m_objects[i]);
+			}
+
+			terminal->Log(LOG_DETAIL, "Replacing %zu of %zu archive members\n", members.size(), m_objects.size());
+		}
+	}
+
+	m_linkExec = m_linkBegin + GetObjectArgs(members) + m_linkEnd;
+
+	terminal->Log(LOG_DETAIL, "Link command:\n\t%s\n", m_linkExec.c_str());
+
+	m_linkTask = taskList->AddCommand(m_outPath.filename().c_str(), m_linkExec, deps);
+	if (m_linkTask == DELTAMAKE_TASK_NONE)
+		return nToExecute;
+
+	taskList->SetListener(m_linkTask, this);
+
+	if (linkDiff["time"].isNumeric() == true)
+		taskList->SetEstimate(m_linkTask, linkDiff["time"].asLargestUInt());
+
+	if (linkMemory != 0)
+		taskList->SetResources(m_linkTask, ETaskClass::LINK, linkMemory);
+	else
+		taskList->SetResources(m_linkTask, ETaskClass::LINK, (linkDiff["rss"].isNumeric() == true) ? ((linkDiff["rss"].asLargestUInt() + 1023) >> 10) : 0);
+
+	return nToExecute + 1;
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::OnTaskDone
+ */
+void DeltaMake::CBuild::OnTaskDone(TaskHandle task, const STaskResult& result) {
+	if (task == m_linkTask) {
+		Json::Value& entry = m_solution->m_diffFile["link"][m_name];
+		if ((result.bSuccess == true) && (m_pendingLinkHash.size() != 0)) {
+			entry["hash"] = m_pendingLinkHash;
+			m_linkHash = m_pendingLinkHash;
+			m_bLinkHash = true;
+		}
+		else {
+			entry.removeMember("hash");
+			m_bLinkHash = false;
+		}
+
+		if (result.bSuccess == true) {
+			entry["time"] = static_cast<Json::UInt64>(result.duration);
+			entry["built"] = static_cast<Json::Int64>(result.startTime);
+			entry["cmd"] = GetCommandHash(m_linkCommand);
+			if (result.maxRSS != 0)
+				entry["rss"] = static_cast<Json::UInt64>(result.maxRSS);
+
+			uint64_t size; // Not kept, `post` may strip it
+			if (IsOutputWritten(m_outPath, size) == false)
+				entry.removeMember("cmd"); // Linked again next time
+		}
+
+		m_solution->RecordDiff({ "link", m_name }, entry);
+		return;
+	}
+
+	if (task == m_pchTask) {
+		Json::Value& entry = m_solution->m_diffFile["pch"][m_name];
+		if (result.bSuccess == true) {
+			entry["cmd"] = m_pchCommandHash;
+			entry["built"] = static_cast<Json::Int64>(result.startTime);
+			entry["time"] = static_cast<Json::UInt64>(result.duration);
+		}
+		else
+			entry = Json::Value(Json::objectValue); // Compiled again next time
+
+		m_solution->RecordDiff({ "pch", m_name }, entry);
+		return;
+	}
+
+	if (result.bSuccess == false)
+		return; // Not in the diff, so it will be executed again next time
+
+	std::string objectHash;
+	uint64_t hash;
+
+	auto unity = m_unityTasks.find(task);
+	if (unity != m_unityTasks.end()) {
+		const SUnityBatch& batch = m_unityBatches[unity->second];
+		if ((config->bChecksum == true) && (CHash::HashFile(batch.outPath.c_str(), hash) == true))
+			objectHash = CHash::ToString(hash);
+
+		// Every source gets its share, so the batches of the next build are sized the same
+		for (size_t i = 0; i < batch.sources.size(); ++i)
+			SaveSourceDiff(batch.sources[i], result, result.duration / batch.sources.size(), batch.name, batch.outPath, objectHash);
+
+		return;
+	}
+
+	auto iterator = m_taskSources.find(task);
+	if (iterator == m_taskSources.end())
+		return;
+
+	const std::filesystem::path outPath = GetObjectPath(m_solution->m_sources[iterator->second]);
+	if ((config->bChecksum == true) && (CHash::HashFile(outPath.c_str(), hash) == true))
+		objectHash = CHash::ToString(hash);
+
+	SaveSourceDiff(iterator->second, result, result.duration, std::string(), outPath, objectHash);
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::SaveSourceDiff
+ */
+void DeltaMake::CBuild::SaveSourceDiff(const Json::String& source, const STaskResult& result, uint64_t duration, const std::string& unity, const std::filesystem::path& outPath, const std::string& objectHash) {
+	const SSourceFile& file = m_solution->m_sources[source];
+
+	Json::Value& entry = m_solution->m_diffFile["diff"][m_name][source];
+	if (entry.isObject() == false)
+		entry = Json::Value(Json::objectValue); // Also converts old `"file": mtime` entries
+
+	entry["mtime"] = static_cast<Json::Int64>(file.mtimeNs);
+	entry["built"] = static_cast<Json::Int64>(result.startTime);
+	entry["time"] = static_cast<Json::UInt64>(duration);
+	entry["cmd"] = m_commandHash;
+	if (result.maxRSS != 0) // Cache hits keep the old one
+		entry["rss"] = static_cast<Json::UInt64>(result.maxRSS);
+
+	// Hashes are valid only if they are updated on every compile
+	entry.removeMember("hash");
+	entry.removeMember("object");
+
+	if (config->bChecksum == true) {
+		auto hash = m_sourceHashes.find(source);
+		if (hash != m_sourceHashes.end())
+			entry["hash"] = hash->second;
+
+		if (objectHash.size() != 0)
+			entry["object"] = objectHash;
+	}
+
+	// Batch of the next build
+	entry.removeMember("unity");
+	entry.removeMember("hot");
+	if (unity.size() != 0)
+		entry["unity"] = unity;
+	else if (m_bUnity == true)
+		entry["hot"] = true; // Compiled alone while it's being edited
+
+	uint64_t size;
+	if (IsOutputWritten(outPath, size) == false) {
+		entry.removeMember("cmd"); // Compiled again next time
+		entry.removeMember("size");
+		m_solution->RecordDiff({ "diff", m_name, source }, entry);
+		return;
+	}
+
+	entry["size"] = static_cast<Json::UInt64>(size);
+
+	m_solution->OnSourceCompiled(m_name, source, outPath);
+
+	// After the headers, so a source is never up to date without them
+	m_solution->RecordDiff({ "diff", m_name, source }, entry);
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::GetObjectPath
+ */
+std::filesystem::path DeltaMake::CBuild::GetObjectPath(const SSourceFile& file) const {
+	return m_solution->m_tmpPath / (std::string(file.path.stem()) + "_" + GetObjectFingerprint({ &file })); // Stem is for humans, same ones are common
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::GetObjectFingerprint
+ */
+std::string DeltaMake::CBuild::GetObjectFingerprint(const std::vector<const SSourceFile*>& files) const {
+	CHash hash;
+	for (size_t i = 0; i < files.size(); ++i) {
+		hash.Update(GetRootKey(files[i]->path));
+		hash.Update("\n");
+	}
+
+	hash.Update(m_commandHash);
+	if (IsPchUsed(*files[0]) == true)
+		hash.Update(m_pch.useFlags);
+
+	return CHash::ToString(hash.Digest());
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::GenSourceOrder
+ */
+std::vector<DeltaMake::TSourceMap::iterator> DeltaMake::CBuild::GenSourceOrder() {
+	TSourceMap& sources = m_solution->m_sources;
+	for (auto iterator = sources.begin(); iterator != sources.end(); ++iterator) {
+		std::vector<Json::String> sourceDeps;
+		m_solution->GetSourceDeps(m_name, iterator->first, sourceDeps);
+		if (sourceDeps.size() == 0)
+			continue;
+
+		m_orderedSources.insert(iterator->first);
+		m_orderedSources.insert(sourceDeps.begin(), sourceDeps.end());
+		m_sourceDeps[iterator->first].swap(sourceDeps);
+	}
+
+	std::vector<TSourceMap::iterator> order;
+	order.reserve(sources.size());
+	if (m_sourceDeps.size() == 0) {
+		for (auto iterator = sources.begin(); iterator != sources.end(); ++iterator)
+			order.push_back(iterator);
+
+		return order;
+	}
+
+	// Depth first, a source is added after all its dependencies
+	enum EVisit : uint8_t { NONE = 0, VISITING, ADDED };
+	std::map<Json::String, EVisit> visits;
+	std::vector<std::pair<TSourceMap::iterator, size_t>> stack; // Source -> index of its next dependency
+	for (auto iterator = sources.begin(); iterator != sources.end(); ++iterator) {
+		EVisit& rVisit = visits[iterator->first];
+		if (rVisit != EVisit::NONE)
+			continue;
+
+		rVisit = EVisit::VISITING;
+		stack.emplace_back(iterator, 0);
+
+		while (stack.size() != 0) {
+			const TSourceMap::iterator source = stack.back().first;
+			auto sourceDeps = m_sourceDeps.find(source->first);
+			if ((sourceDeps != m_sourceDeps.end()) && (stack.back().second < sourceDeps->second.size())) {
+				auto dependency = sources.find(sourceDeps->second[stack.back().second++]);
+				if (dependency == sources.end())
+					continue;
+
+				EVisit& rDependency = visits[dependency->first];
+				if (rDependency == EVisit::VISITING) { // The compiler explains it better
+					terminal->Log(LOG_WARNING, "\"%s\" and \"%s\" depend on each other\n", source->first.c_str(), dependency->first.c_str());
+					continue;
+				}
+
+				if (rDependency == EVisit::NONE) {
+					rDependency = EVisit::VISITING;
+					stack.emplace_back(dependency, 0);
+				}
+
+				continue;
+			}
+
+			visits[source->first] = EVisit::ADDED;
+			order.push_back(source);
+			stack.pop_back();
+		}
+	}
+
+	return order;
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::GenUnityBatches
+ */
+void DeltaMake::CBuild::GenUnityBatches(const Json::Value& buildDiff) {
+	const Json::Value& unity = m_build["unity"];
+	if ((unity.isObject() == false) && ((unity.isBool() == false) || (unity.asBool() == false)))
+		return;
+
+	m_bUnity = true;
+
+	size_t maxFiles = DELTAMAKE_UNITY_FILES;
+	uint64_t maxTime = 0; // ms, `0` for no limit
+	if (unity.isObject() == true) {
+		if (unity["files"].isUInt() == true)
+			maxFiles = std::max<size_t>(unity["files"].asUInt(), 2);
+
+		if (unity["time"].isNumeric() == true)
+			maxTime = unity["time"].asLargestUInt();
+	}
+
+	const time_t now = time(nullptr);
+
+	std::map<std::string, std::vector<Json::String>> batches; // Name of the last build -> sources
+	std::map<std::string, std::vector<Json::String>> fresh; // Unity extension -> sources without a batch
+	std::map<Json::String, std::string> extensions;
+	uint64_t knownTime = 0;
+	size_t nKnownTime = 0;
+
+	for (auto iterator = m_solution->m_sources.begin(); iterator != m_solution->m_sources.end(); ++iterator) {
+		const std::string extension = m_solution->GetUnityExtension(iterator->second);
+		if ((extension.size() == 0) || (m_orderedSources.count(iterator->first) != 0))
+			continue; // Ordered ones would need the others of the batch
+
+		const Json::Value& entry = buildDiff[iterator->first];
+		if (entry.isObject() == true) {
+			// Changes of a source being edited don't compile the others again
+			const bool bChanged = GetDiffTime(entry) < iterator->second.mtimeNs;
+			const bool bHot = (entry["hot"].asBool() == true) && (now - iterator->second.mtime < DELTAMAKE_UNITY_HOT_TIME);
+			if ((bChanged == true) || (bHot == true)) {
+				terminal->Log(LOG_DETAIL, "\"%s\" is being edited, it's compiled alone\n", iterator->first.c_str());
+				if (bHot == true) // Batched again later
+					m_expires = std::min(m_expires, iterator->second.mtime + DELTAMAKE_UNITY_HOT_TIME);
+
+				continue;
+			}
+
+			if (entry["time"].isNumeric() == true) {
+				knownTime += entry["time"].asLargestUInt();
+				++nKnownTime;
+			}
+		}
+
+		extensions[iterator->first] = extension;
+
+		if ((entry.isObject() == true) && (entry["unity"].isString() == true))
+			batches[entry["unity"].asString()].push_back(iterator->first);
+		else
+			fresh[extension].push_back(iterator->first);
+	}
+
+	const uint64_t averageTime = (nKnownTime != 0) ? knownTime / nKnownTime : 0;
+	auto getTime = [&buildDiff, averageTime](const Json::String& source) {
+		const Json::Value& sourceTime = buildDiff[source]["time"];
+		return (sourceTime.isNumeric() == true) ? sourceTime.asLargestUInt() : averageTime;
+	};
+
+	std::vector<std::vector<Json::String>> groups;
+
+	// Batches of the last build stay, unless the limits are changed
+	for (auto iterator = batches.begin(); iterator != batches.end(); ++iterator) {
+		const std::vector<Json::String>& sources = iterator->second;
+
+		uint64_t batchTime = 0;
+		for (size_t i = 0; i < sources.size(); ++i)
+			batchTime += getTime(sources[i]);
+
+		if ((sources.size() < 2) || (sources.size() > maxFiles) || ((maxTime != 0) && (batchTime > maxTime))) {
+			std::vector<Json::String>& rFresh = fresh[extensions[sources[0]]];
+			rFresh.insert(rFresh.end(), sources.begin(), sources.end());
+			continue;
+		}
+
+		groups.push_back(sources);
+	}
+
+	// New batches of neighbours
+	for (auto iterator = fresh.begin(); iterator != fresh.end(); ++iterator) {
+		std::vector<Json::String>& sources = iterator->second;
+		std::sort(sources.begin(), sources.end());
+
+		std::vector<Json::String> group;
+		uint64_t groupTime = 0;
+		for (size_t i = 0; i <= sources.size(); ++i) {
+			const uint64_t sourceTime = (i < sources.size()) ? getTime(sources[i]) : 0;
+			const bool bFull = (group.size() == maxFiles) || ((maxTime != 0) && (group.size() != 0) && (groupTime + sourceTime > maxTime));
+			if ((i == sources.size()) || (bFull == true)) {
+				if (group.size() >= 2) // A single source is compiled alone
+					groups.push_back(group);
+
+				group.clear();
+				groupTime = 0;
+			}
+
+			if (i < sources.size()) {
+				group.push_back(sources[i]);
+				groupTime += sourceTime;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < groups.size(); ++i) {
+		SUnityBatch batch;
+		batch.sources = groups[i];
+		batch.extension = extensions[batch.sources[0]];
+
+		CHash hash;
+		hash.Update(batch.extension);
+		for (size_t j = 0; j < batch.sources.size(); ++j) {
+			hash.Update(batch.sources[j]);
+			hash.Update("\n");
+		}
+
+		batch.name = CHash::ToString(hash.Digest());
+
+		std::vector<const SSourceFile*> files;
+		for (size_t j = 0; j < batch.sources.size(); ++j)
+			files.push_back(&m_solution->m_sources[batch.sources[j]]);
+
+		batch.outPath = m_solution->m_tmpPath / ("unity_" + GetObjectFingerprint(files));
+
+		// A new or changed batch is compiled even if its sources are not
+		for (size_t j = 0; j < batch.sources.size(); ++j) {
+			m_unitySources[batch.sources[j]] = m_unityBatches.size();
+
+			const Json::Value& name = buildDiff[batch.sources[j]]["unity"];
+			if ((name.isString() == false) || (name.asString() != batch.name))
+				batch.bOutdated = true;
+		}
+
+		m_unityBatches.push_back(batch);
+	}
+
+	terminal->Log(LOG_DETAIL, "%zu unity batches of %zu sources\n", m_unityBatches.size(), m_unitySources.size());
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::AddUnityTask
+ */
+DeltaMake::TaskHandle DeltaMake::CBuild::AddUnityTask(ITaskList* taskList, const SUnityBatch& batch, const std::string& cmdBegin, const std::vector<TaskHandle>& pchDeps, const Json::Value& buildDiff, uint64_t& rDuration, uint64_t& rMemory) {
+	rDuration = 0;
+	rMemory = 0;
+
+	std::vector<const SSourceFile*> files;
+	for (size_t i = 0; i < batch.sources.size(); ++i) {
+		files.push_back(&m_solution->m_sources[batch.sources[i]]);
+
+		const Json::Value& entry = buildDiff[batch.sources[i]];
+		if (entry["time"].isNumeric() == true)
+			rDuration += entry["time"].asLargestUInt();
+
+		if (entry["rss"].isNumeric() == true)
+			rMemory = std::max<uint64_t>(rMemory, (entry["rss"].asLargestUInt() + 1023) >> 10);
+	}
+
+	const std::filesystem::path sourcePath = std::string(batch.outPath.c_str()) + batch.extension;
+	if (m_solution->WriteUnitySource(sourcePath, files) == false) {
+		terminal->Log(LOG_ERROR, "Can't write unity source \"%s\"\n", sourcePath.c_str());
+		return DELTAMAKE_TASK_NONE;
+	}
+
+	const bool bPch = IsPchUsed(*files[0]); // Same extension for all of them
+	const std::string cmd = cmdBegin + ((bPch == true) ? m_pch.useFlags : std::string()) + m_solution->GetSourceFlags(m_name, *files[0], batch.outPath) + "\"" + sourcePath.c_str() + "\" -o \"" + batch.outPath.c_str() + "\"";
+	terminal->Log(LOG_DETAIL, "\t%s\n", cmd.c_str());
+
+	const std::string name = std::string(files[0]->path.stem()) + " +" + std::to_string(files.size() - 1);
+	const TaskHandle task = taskList->AddCommand(name.c_str(), cmd, (bPch == true) ? pchDeps : std::vector<TaskHandle>());
+	if (task != DELTAMAKE_TASK_NONE)
+		taskList->SetListener(task, this);
+
+	return task;
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::GenPchTask
+ */
+bool DeltaMake::CBuild::GenPchTask(ITaskList* taskList, const std::string& flagsBegin, const std::string& compiler) {
+	const Json::Value& config = m_build["pch"];
+	if ((config.isObject() == false) && ((config.isBool() == false) || (config.asBool() == false)))
+		return false;
+
+	m_pch = SPrecompiledHeader();
+	const bool bHeaders = m_solution->GenPrecompiledHeader(m_name, config, compiler, m_pch);
+	m_expires = std::min(m_expires, m_pch.expires);
+	if (bHeaders == false) {
+		terminal->Log(LOG_DETAIL, "No headers for the precompiled header\n");
+		return false;
+	}
+
+	const std::string cmd = flagsBegin + m_pch.compileFlags + "\"" + m_pch.header.c_str() + "\" -o \"" + m_pch.outPath.c_str() + "\"";
+	m_pchCommandHash = GetCommandHash(cmd);
+
+	terminal->Log(LOG_DETAIL, "Precompiled header of %zu headers:\n\t%s\n", m_pch.nHeaders, cmd.c_str());
+
+	// Invalid with other flags or older than some of its headers
+	const Json::Value& entry = static_cast<const Json::Value&>(m_solution->m_diffFile)["pch"][m_name];
+	SFileStat stat;
+	const bool bExists = CFileStat::Get(m_pch.outPath.c_str(), stat);
+	const bool bCommand = entry["cmd"] != m_pchCommandHash;
+	const int64_t built = GetBuiltTime(entry);
+	if ((bExists == true) && (bCommand == false) && (built != 0) && (m_pch.newest < built - DELTAMAKE_MTIME_SLACK)) {
+		terminal->Log(LOG_DETAIL, "Precompiled header is up to date\n");
+		return true;
+	}
+
+	m_pchTask = taskList->AddCommand(m_pch.header.filename().c_str(), cmd);
+	if (m_pchTask == DELTAMAKE_TASK_NONE)
+		return false;
+
+	taskList->SetListener(m_pchTask, this);
+	if (entry["time"].isNumeric() == true)
+		taskList->SetEstimate(m_pchTask, entry["time"].asLargestUInt());
+
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::IsPchUsed
+ */
+bool DeltaMake::CBuild::IsPchUsed(const SSourceFile& file) const {
+	return (m_bPch == true) && (m_solution->GetUnityExtension(file) == m_pch.extension);
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::Fetch
+ */
+bool DeltaMake::CBuild::Fetch(TaskHandle task) {
+	auto iterator = m_cacheItems.find(task);
+	if (iterator == m_cacheItems.end())
+		return false;
+
+	SCacheItem& item = iterator->second;
+
+	uint64_t sourceHash;
+	if (CHash::HashFile(item.file->path.c_str(), sourceHash) == false)
+		return false;
+
+	// Same bytes at another path include other headers and have other `__FILE__`
+	CHash key;
+	key.Update(item.prefix);
+	key.Update(GetRootKey(item.file->path));
+	key.Update(&sourceHash, sizeof(sourceHash));
+	item.key = CHash::ToString(key.Digest());
+
+	std::vector<std::string> inputs;
+	if (objectCache->Fetch(item.key, item.outPath, inputs) == false)
+		return false;
+
+	m_solution->SetSourceInputs(*item.file, item.outPath, inputs);
+
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::Store
+ */
+void DeltaMake::CBuild::Store(TaskHandle task) {
+	auto iterator = m_cacheItems.find(task);
+	if ((iterator == m_cacheItems.end()) || (iterator->second.key.size() == 0))
+		return;
+
+	const SCacheItem& item = iterator->second;
+
+	std::vector<std::string> inputs;
+	if (m_solution->GetSourceInputs(*item.file, item.outPath, inputs) == false)
+		return;
+
+	objectCache->Store(item.key, item.outPath, inputs);
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::GetDiffTime
+ */
+int64_t DeltaMake::CBuild::GetDiffTime(const Json::Value& entry) {
+	int64_t mtime = 0; // Never built
+	if (entry.isNumeric() == true) // Before diff entries became objects
+		mtime = entry.asLargestInt();
+	else if ((entry.isObject() == true) && (entry["mtime"].isNumeric() == true))
+		mtime = entry["mtime"].asLargestInt();
+
+	// Start of the second of the older diffs, so an edit later in that second is not missed
+	return (mtime < DELTAMAKE_TIME_SECONDS_MAX) ? mtime * 1000000000 : mtime;
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::GetBuiltTime
+ */
+int64_t DeltaMake::CBuild::GetBuiltTime(const Json::Value& entry) {
+	if ((entry.isObject() == false) || (entry["built"].isNumeric() == false))
+		return 0;
+
+	const int64_t built = entry["built"].asLargestInt();
+	return (built < DELTAMAKE_TIME_SECONDS_MAX) ? built * 1000000000 : built; // Start of the second of the older diffs
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::IsOutputStale
+ */
+bool DeltaMake::CBuild::IsOutputStale(const char name[], const Json::Value& entry, const SFileStat& stat) {
+	if (stat.bExists == false) {
+		terminal->Log(LOG_DETAIL, "\"%s\" has no output\n", name);
+		return true;
+	}
+
+	if ((entry["size"].isNumeric() == true) && (entry["size"].asLargestUInt() != stat.size)) {
+		terminal->Log(LOG_DETAIL, "\"%s\" output is changed since its build\n", name);
+		return true;
+	}
+
+	if (stat.mtimeNs < GetBuiltTime(entry) - DELTAMAKE_MTIME_SLACK) {
+		terminal->Log(LOG_DETAIL, "\"%s\" output is older than its build\n", name);
+		return true;
+	}
+
+	return false;
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::IsOutputWritten
+ */
+bool DeltaMake::CBuild::IsOutputWritten(const std::filesystem::path& path, uint64_t& rSize) {
+	SFileStat stat;
+	if (CFileStat::Get(path.c_str(), stat) == false) {
+		terminal->Log(LOG_WARNING, "\"%s\" is not written by its task\n", path.c_str());
+		return false;
+	}
+
+	rSize = stat.size;
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::GetOutputTasks
+ */
+void DeltaMake::CBuild::GetOutputTasks(std::vector<TaskHandle>& rTasks) const {
+	if (m_linkTask != DELTAMAKE_TASK_NONE)
+		rTasks.push_back(m_linkTask);
+
+	for (size_t i = 0; i < m_subs.size(); ++i)
+		m_subs[i].build->GetOutputTasks(rTasks);
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::GetOutputHashes
+ */
+bool DeltaMake::CBuild::GetOutputHashes(CHash& rHash) const {
+	if (m_bLinkHash == false)
+		return false;
+
+	rHash.Update(m_linkHash);
+
+	for (size_t i = 0; i < m_subs.size(); ++i) {
+		if (m_subs[i].build->GetOutputHashes(rHash) == false)
+			return false;
+	}
+
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::GetLinkHash
+ */
+bool DeltaMake::CBuild::GetLinkHash(std::string& rHash) const {
+	CHash hash;
+	hash.Update(m_linkCommand);
+
+	const Json::Value& buildDiff = static_cast<const Json::Value&>(m_solution->m_diffFile)["diff"][m_name];
+	for (auto iterator = m_solution->m_sources.begin(); iterator != m_solution->m_sources.end(); ++iterator) {
+		const Json::Value& entry = buildDiff[iterator->first];
+		if ((entry.isObject() == false) || (entry["object"].isString() == false))
+			return false; // Compiled without `-c`
+
+		hash.Update(entry["object"].asString());
+	}
+
+	if (m_type == "exec") {
+		for (size_t i = 0; i < m_subs.size(); ++i) {
+			if (m_subs[i].build->GetOutputHashes(hash) == false)
+				return false;
+		}
+	}
+
+	rHash = CHash::ToString(hash.Digest());
+
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::GetRootKey
+ */
+std::string DeltaMake::CBuild::GetRootKey(const std::filesystem::path& path) const {
+	return (m_rootPath / path).lexically_normal().lexically_relative(m_rootPath).string(); // An absolute `path` replaces `m_rootPath`
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::GetCommandHash
+ */
+std::string DeltaMake::CBuild::GetCommandHash(const std::string& command) {
+	CHash hash;
+	hash.Update(command);
+
+	return CHash::ToString(hash.Digest());
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::Visit
+ */
+bool DeltaMake::CBuild::Visit(size_t& rRun) const {
+	const size_t run = solutionRegistry->GetRun();
+	if (rRun == run)
+		return false;
+
+	rRun = run;
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::GenLinkCommand
+ */
+bool DeltaMake::CBuild::GenLinkCommand(const Json::Value& type) {
 	Json::Value out = m_build["outname"];
 	if (out.isString() == false) {
 		terminal->Log(LOG_DETAIL, "outname is not set. Default value is used.\n");
 		out = "out";
 	}
 
-	const char* workingPathName = m_solution->m_currentPath.filename().c_str();
 	std::string cmdBegin = "";
+	std::string cmdEnd = "";
 	if (type == "exec") {
-		terminal->Log(LOG_INFO, "Linking \"%s\"...\n", workingPathName);
-
 		const Json::Value& linker = m_build["linker"];
 		if (linker.isString() == false) {
 			terminal->Log(LOG_DETAIL, "linker is not set. Default value is used.\n");
@@ -472,6 +1849,12 @@ inline bool DeltaMake::CBuild::PostBuild() {
 		else
 			cmdBegin += linker.asString() + " ";
 
+		const Json::Value& ld = m_build["ld"];
+		if (ld.isString() == false)
+			terminal->Log(LOG_DETAIL, "ld is not set. Default of the linker is used.\n");
+		else
+			cmdBegin += "-fuse-ld=" + ld.asString() + " ";
+
 		const Json::Value& linkerFlags = m_build["linkerFlags"];
 		if (linkerFlags.isString() == false) {
 			terminal->Log(LOG_DETAIL, "No linkerFlags setted. Ignoring...\n");
@@ -479,36 +1862,136 @@ inline bool DeltaMake::CBuild::PostBuild() {
 		else
 			cmdBegin += linkerFlags.asString() + " ";
 
-		for (size_t i = 0; i < m_objects.size(); ++i)
-			cmdBegin += std::string("\"") + m_objects[i].c_str() + "\" ";
-
 		const Json::Value& staticLibs = m_build["staticLibs"];
 		if (staticLibs.isArray() == false)
 			terminal->Log(LOG_DETAIL, "No staticLibs setted. Ignoring...\n");
 		else {
 			for (Json::ArrayIndex i = 0; i < staticLibs.size(); ++i)
-				cmdBegin += "\"" + staticLibs[i].asString() + "\" ";
+				cmdEnd += "\"" + staticLibs[i].asString() + "\" ";
 		}
 
-		cmdBegin += std::string("-o \"") + (m_solution->m_buildPath / out.asCString()).c_str() + "\"";
+		cmdEnd += std::string("-o \"") + (m_solution->m_buildPath / out.asCString()).c_str() + "\"";
 	}
 	else if (type == "lib") {
-		terminal->Log(LOG_INFO, "Archiving \"%s\"...\n", workingPathName);
-
 		const Json::Value& archiver = m_build["archiver"];
 		if (archiver.isString() == false) {
 			terminal->Log(LOG_DETAIL, "archiver is not set. Default value is used.\n");
 			cmdBegin += "ar ";
 		}
 		else
-			cmdBegin += archiver.asString() + " rcs \"" + (m_solution->m_buildPath / out.asCString()).c_str() + "\" ";
+			cmdBegin += archiver.asString() + " ";
+
+		// Members of a thin archive are paths of the objects, nothing is copied
+		const bool bThin = m_build["thin"].asBool();
+		cmdBegin += std::string((bThin == true) ? "rcsT \"" : "rcs \"") + (m_solution->m_buildPath / out.asCString()).c_str() + "\" ";
+	}
+	else {
+		terminal->Log(LOG_ERROR, "Unknown build type: \"%s\"\n", type.asCString());
+		return false;
+	}
+
+	std::string objects;
+	for (size_t i = 0; i < m_objects.size(); ++i)
+		objects += std::string("\"") + m_objects[i].c_str() + "\" ";
+
+	m_linkBegin = cmdBegin;
+	m_linkEnd = cmdEnd;
+	m_linkCommand = cmdBegin + objects + cmdEnd;
+	m_outPath = m_solution->m_buildPath / out.asCString();
+
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::GetObjectArgs
+ */
+std::string DeltaMake::CBuild::GetObjectArgs(const std::vector<std::filesystem::path>& objects) const {
+	std::string args;
+	for (size_t i = 0; i < objects.size(); ++i)
+		args += std::string("\"") + objects[i].c_str() + "\" ";
+
+	if (args.size() < DELTAMAKE_RESPONSE_FILE_MIN)
+		return args;
+
+	// Quoted as GCC, binutils, lld and mold read it
+	std::string content;
+	for (size_t i = 0; i < objects.size(); ++i) {
+		content += '"';
+		for (const char* c = objects[i].c_str(); *c != '\0'; ++c) {
+			if ((*c == '"') || (*c == '\\'))
+				content += '\\';
+
+			content += *c;
+		}
+		content += "\"\n";
+	}
+
+	const std::filesystem::path path = m_solution->m_tmpPath / (m_outPath.filename().string() + "_" + GetCommandHash(m_outPath.string()) + ".rsp");
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(content.data(), static_cast<std::streamsize>(content.size()));
+	if (file.good() == false) {
+		terminal->Log(LOG_WARNING, "Can't write response file \"%s\"\n", path.c_str());
+		return args;
+	}
+
+	terminal->Log(LOG_DETAIL, "%zu objects are in the response file \"%s\"\n", objects.size(), path.c_str());
+
+	return std::string("\"@") + path.c_str() + "\" ";
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::IsOutputNewer
+ */
+bool DeltaMake::CBuild::IsOutputNewer(int64_t time) const {
+	for (size_t i = 0; i < m_subs.size(); ++i) {
+		const CBuild* sub = m_subs[i].build;
+
+		SFileStat stat;
+		if ((sub->m_outPath.empty() == false) && (CFileStat::Get(sub->m_outPath.c_str(), stat) == true) && (stat.mtimeNs > time))
+			return true;
+
+		if (sub->IsOutputNewer(time) == true)
+			return true;
+	}
+
+	return false;
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::OnTaskReady
+ */
+bool DeltaMake::CBuild::OnTaskReady(TaskHandle task) {
+	if (task != m_linkTask)
+		return true;
 
-		for (size_t i = 0; i < m_objects.size(); ++i)
-			cmdBegin += std::string("\"") + m_objects[i].c_str() + "\" ";
+	if (config->bChecksum == true) {
+		if (GetLinkHash(m_pendingLinkHash) == false)
+			m_pendingLinkHash.clear();
+		else if ((m_bLinkHash == true) && (m_pendingLinkHash == m_linkHash) && (std::filesystem::exists(m_outPath) == true)) {
+			terminal->Log(LOG_DETAIL, "Objects of \"%s\" are the same. Skipping link...\n", m_outPath.c_str());
+			return false;
+		}
+	}
+
+	// `ar` keeps the members of removed objects
+	if (m_bArchiveAll == true) {
+		std::error_code error;
+		std::filesystem::remove(m_outPath, error);
 	}
 
-	terminal->Log(LOG_DETAIL, "Command:\n\t%s\n", cmdBegin.c_str());
-	terminal->ExecSystem(cmdBegin.c_str());
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::PostBuild
+ */
+inline bool DeltaMake::CBuild::PostBuild() {
+	if (Visit(m_postBuildRun) == false)
+		return true;
+
+	// Subs, their diffs are saved by `solutionRegistry`
+	for (size_t i = 0; i < m_subs.size(); ++i)
+		m_subs[i].build->PostBuild();
 
 	const Json::Value post = m_build["post"];
 	if (post.isString() == true) {
@@ -518,4 +2001,68 @@ inline bool DeltaMake::CBuild::PostBuild() {
 	}
 
 	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::GetWatchPaths
+ */
+void DeltaMake::CBuild::GetWatchPaths(std::vector<std::filesystem::path>& rPaths, std::vector<std::filesystem::path>& rExcluded) const {
+	for (size_t i = 0; i < m_subs.size(); ++i)
+		m_subs[i].build->GetWatchPaths(rPaths, rExcluded);
+
+	rPaths.push_back(m_solution->m_currentPath / DELTAMAKE_CONFIG_FILENAME);
+	m_solution->GetWatchPaths(rPaths);
+
+	// Objects and links must not start the next build
+	rExcluded.push_back(m_solution->m_buildPath);
+	rExcluded.push_back(m_solution->m_tmpPath);
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::GetGraphInputs
+ */
+bool DeltaMake::CBuild::GetGraphInputs(std::vector<std::filesystem::path>& rPaths, time_t& rExpires) const {
+	if (m_build["pre"].isString() == true)
+		return false; // Executed by every build
+
+	for (size_t i = 0; i < m_subs.size(); ++i) {
+		if (m_subs[i].build->GetGraphInputs(rPaths, rExpires) == false)
+			return false;
+	}
+
+	const std::filesystem::path diffPath = m_solution->m_currentPath / DELTAMAKE_DIFF_FILENAME;
+	rPaths.push_back(m_solution->m_currentPath / DELTAMAKE_CONFIG_FILENAME);
+	rPaths.push_back(diffPath);
+	rPaths.push_back(CDiffStore::GetBinaryPath(diffPath));
+	rPaths.push_back(CDiffStore::GetJournalPath(diffPath)); // Records of a stopped build
+	m_solution->GetGraphInputs(rPaths);
+
+	// Removed or touched outputs
+	rPaths.insert(rPaths.end(), m_objects.begin(), m_objects.end());
+	rPaths.push_back(m_outPath);
+	if (m_bPch == true)
+		rPaths.push_back(m_pch.outPath);
+
+	rExpires = std::min(rExpires, m_expires);
+
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CBuild::Update
+ */
+DeltaMake::EWatchChange DeltaMake::CBuild::Update(const std::set<std::filesystem::path>& changed) {
+	EWatchChange change = EWatchChange::NONE;
+	for (size_t i = 0; i < m_subs.size(); ++i)
+		change = std::max(change, m_subs[i].build->Update(changed));
+
+	if (changed.count(CWatcher::Normalize(m_solution->m_currentPath / DELTAMAKE_CONFIG_FILENAME)) != 0) {
+		terminal->Log(LOG_DETAIL, "\"%s\" is changed\n", (m_solution->m_currentPath / DELTAMAKE_CONFIG_FILENAME).c_str());
+		return EWatchChange::CONFIG;
+	}
+
+	if (m_solution->Update(changed) == true)
+		change = std::max(change, EWatchChange::INPUTS);
+
+	return change;
 }
\ No newline at end of file
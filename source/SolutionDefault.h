@@ -8,17 +8,32 @@
 #define __DELTAMAKE_SOLUTION_DEFAULT_H__
 
 #include <stddef.h>
+#include <time.h>
 
 #include <filesystem>
 #include <vector>
 #include <map>
+#include <set>
 #include <string>
+#include <limits>
 
 #include <json/json.h>
 
 #include "deltamake.h"
 #include "Exception.h"
 #include "Workers.h"
+#include "Hash.h"
+#include "FileStat.h"
+#include "DiffStore.h"
+
+
+#define DELTAMAKE_RUN_NONE				static_cast<size_t>(-1) // Never visited
+#define DELTAMAKE_UNITY_FILES			16 // Sources per unity source if `unity.files` is not set
+#define DELTAMAKE_UNITY_HOT_TIME		3600 // s, a source changed so recently is compiled alone
+#define DELTAMAKE_OBJECT_NAMING			"2" // Version of the object paths, the diff of other ones is outdated
+#define DELTAMAKE_RESPONSE_FILE_MIN		65536 // Bytes of quoted objects, longer lists are passed in a response file
+#define DELTAMAKE_TIME_SECONDS_MAX		100000000000ll // Older diffs have times in s, ns are above it
+#define DELTAMAKE_MTIME_SLACK			20000000 // ns, the kernel stamps files by its coarse clock, behind the start time of a task
  
 // ******************************************************************************** //
 
@@ -29,8 +44,31 @@ namespace DeltaMake {
 	 */
 	struct SSourceFile {
 		std::filesystem::path			path;
-		time_t							mtime; /* Last modification time in diff file */
+		time_t							mtime; /* s, for the age of the source */
+		int64_t							mtimeNs									= 0; /* ns of the last `statx()`, for the up-to-date checks */
+		uint64_t						size									= 0;
 		bool							bToCompile;
+		bool							bScanned								= false; /* Found in `paths.scan`, not in `files` */
+	};
+
+	/**
+	 * Sources of a solution: key relative to the solution -> source
+	 */
+	typedef std::map<Json::String, SSourceFile> TSourceMap;
+
+	/**
+	 * Precompiled header of a build, picked by the solution type
+	 */
+	struct SPrecompiledHeader {
+		std::filesystem::path			header; /* Generated header that includes the picked ones */
+		std::filesystem::path			outPath; /* Compiled header */
+		std::string						extension; /* Unity extension of the sources that use it */
+		std::string						compileFlags; /* Before the header in its compile command */
+		std::string						useFlags; /* Of the sources, ends with a space */
+		std::string						preprocessFlags; /* Of the sources preprocessed for build nodes, ends with a space */
+		int64_t							newest									= 0; /* ns, mtime of the newest picked header */
+		size_t							nHeaders								= 0;
+		time_t							expires									= std::numeric_limits<time_t>::max(); /* A header becomes stable enough to be picked */
 	};
 
 	/**
@@ -47,54 +85,431 @@ namespace DeltaMake {
 
 			virtual bool				LoadDiff(const char path[]) override;
 			virtual bool				SaveDiff(const char path[]) override;
+			virtual bool				IsDiffChanged() const override;
 		protected:
 		
 			friend class CBuild;
+			friend class CSolutionRegistry;
+
+			/**
+			 * \returns Solution specific compiler flags for the source, ends with a space if not empty
+			 */
+			virtual std::string			GetSourceFlags(const std::string& build, const SSourceFile& file, const std::filesystem::path& outPath);
+
+			/**
+			 * Check things the source depends on besides itself
+			 * 
+			 * \param builtTime Start time of the last successful compile in ns
+			 * \returns `true` if the source must be compiled again
+			 */
+			virtual bool				IsSourceOutdated(const std::string& build, const Json::String& source, int64_t builtTime);
+
+			/**
+			 * Source is compiled successfully
+			 */
+			virtual void				OnSourceCompiled(const std::string& build, const Json::String& source, const std::filesystem::path& outPath);
+
+			/**
+			 * Implicit inputs (like headers) of the compiled source for the object cache
+			 * 
+			 * \warning Called from the worker thread
+			 * \returns `false` if they are unknown, so the object is not cached
+			 */
+			virtual bool				GetSourceInputs(const SSourceFile& file, const std::filesystem::path& outPath, std::vector<std::string>& rInputs) const;
+
+			/**
+			 * Object is restored from the cache, write what the compiler writes besides it
+			 * 
+			 * \warning Called from the worker thread
+			 */
+			virtual void				SetSourceInputs(const SSourceFile& file, const std::filesystem::path& outPath, const std::vector<std::string>& inputs) const;
+
+			/**
+			 * \returns Lower case extensions of the sources found by `ScanFolders()`, with the dot
+			 */
+			virtual const std::set<std::string>& GetSourceExtensions() const;
+
+			/**
+			 * \returns Extension of the unity source the file may be in, empty if it can't be in one
+			 */
+			virtual std::string			GetUnityExtension(const SSourceFile& file) const;
+
+			/**
+			 * Write the source that compiles all the files at once
+			 * 
+			 * \returns `false` if the solution type has no unity builds
+			 */
+			virtual bool				WriteUnitySource(const std::filesystem::path& path, const std::vector<const SSourceFile*>& files) const;
+
+			/**
+			 * Pick the headers of the precompiled header of the build and write its header
+			 * 
+			 * \param config `pch` of the build
+			 * \returns `false` if the build gets no precompiled header
+			 */
+			virtual bool				GenPrecompiledHeader(const std::string& build, const Json::Value& config, const std::string& compiler, SPrecompiledHeader& rHeader);
+
+			/**
+			 * Add the tasks that find what the sources of the build need from each other, like C++20 modules
+			 * 
+			 * \param config `modules` of the build
+			 * \param flagsBegin Compiler and flags of the compile commands without `-c`
+			 * \returns Number of added tasks
+			 */
+			virtual size_t				GenScanTasks(ITaskList* taskList, const std::string& build, const Json::Value& config, const std::string& compiler, const std::string& flagsBegin);
+
+			/**
+			 * Collect what the tasks of `GenScanTasks()` found, they are ended
+			 */
+			virtual void				ScanSourceDeps(const std::string& build);
+
+			/**
+			 * \param rDeps Sources of the build that must be compiled before the source
+			 */
+			virtual void				GetSourceDeps(const std::string& build, const Json::String& source, std::vector<Json::String>& rDeps) const;
+
+			/**
+			 * \param rPaths Normalized paths of the sources of `files`
+			 */
+			void						GetListedPaths(std::set<std::filesystem::path>& rPaths) const;
+
+			/**
+			 * Add the found source to the sources if it's not one of them
+			 * 
+			 * \param listed Paths of `GetListedPaths()`
+			 * \returns `true` if it's added
+			 */
+			bool						AddScannedSource(const std::filesystem::path& path, const SFileStat& stat, const std::set<std::filesystem::path>& listed);
+
+			/**
+			 * Inputs of the solution to watch: sources and `paths.scan`
+			 */
+			virtual void				GetWatchPaths(std::vector<std::filesystem::path>& rPaths) const;
+
+			/**
+			 * Inputs of the solution for the build graph: watched ones and the directories of the last scan
+			 */
+			virtual void				GetGraphInputs(std::vector<std::filesystem::path>& rPaths) const;
+
+			/**
+			 * Get modification times of the changed inputs again
+			 * 
+			 * \returns `true` if some input is changed
+			 */
+			virtual bool				Update(const std::set<std::filesystem::path>& changed);
+
+			/**
+			 * \returns `true` if `ScanFolders()` finds the file there
+			 */
+			bool						IsScanned(const std::filesystem::path& path) const;
+
+			/**
+			 * \returns `true` if the file, its directory or a directory above it is changed
+			 */
+			static bool					IsChanged(const std::set<std::filesystem::path>& changed, const std::filesystem::path& path);
+
+			/**
+			 * Diff member at `keys` is set to `value` by a finished task, with `--binary-diff`
+			 * it's written to the journal at once
+			 */
+			void						RecordDiff(const std::vector<Json::String>& keys, const Json::Value& value);
 
 			const std::filesystem::path m_currentPath;
 
 			Json::Value					m_diffFile								= Json::Value(Json::nullValue);
+			CDiffJournal				m_journal;
+			bool						m_bJournalFailed						= false; /* Don't try to open it again */
+			bool						m_bDiffChanged							= false; /* Of `IsDiffChanged()`, like new mtimes of touched sources */
 
 			std::vector<std::filesystem::path> m_sourcePaths;
+			std::vector<std::filesystem::path> m_scannedPaths; /* Directories of `ScanFolders()` */
 			std::filesystem::path		m_buildPath;
 			std::filesystem::path		m_tmpPath;
 
-			std::map<Json::String, SSourceFile>	m_sources;
+			TSourceMap					m_sources;
 			std::map<Json::String, Json::String> m_subSolutions;
 			std::map<Json::String, Json::Value> m_builds;
 	};
 
+	class CBuild;
+
 	/**
 	 * Sub Solution
 	 */
 	struct SSubSolution {
 		CSolutionDefault*				solution;
-		IBuild*							build;
+		CBuild*							build;
 		std::filesystem::path			path;
 	};
 
 	/**
 	 * Default build implementation
 	 */
-	class CBuild : public IBuild {
+	class CBuild : public IBuild, public ITaskListener, public ITaskCache {
 		public:
 										CBuild(CSolutionDefault* solution, const Json::Value& build, std::string name);
 			virtual						~CBuild()								= default;
 
 			virtual bool				PreBuild() override;
+			virtual size_t				Scan(ITaskList* taskList) override;
 			virtual size_t				Build(ITaskList* taskList) override;
 			virtual bool				PostBuild() override;
 
+			/**
+			 * Solution file, inputs of the solution and all sub solutions
+			 */
+			virtual void				GetWatchPaths(std::vector<std::filesystem::path>& rPaths, std::vector<std::filesystem::path>& rExcluded) const override;
+			virtual EWatchChange		Update(const std::set<std::filesystem::path>& changed) override;
+
+			/**
+			 * Solution and diff files, inputs and outputs of the solution and all sub solutions
+			 */
+			virtual bool				GetGraphInputs(std::vector<std::filesystem::path>& rPaths, time_t& rExpires) const override;
+
+			/**
+			 * Append link tasks of this build and all sub builds
+			 */
+			void						GetOutputTasks(std::vector<TaskHandle>& rTasks) const;
+
+			/**
+			 * Append hashes of the outputs of this build and all sub builds
+			 * 
+			 * \returns `false` if some output has no hash
+			 */
+			bool						GetOutputHashes(CHash& rHash) const;
+
+			/**
+			 * Skip the link if all objects are the same as in the last link (`-c`),
+			 * remove the archive that is archived again from scratch
+			 */
+			virtual bool				OnTaskReady(TaskHandle task) override;
+
+			/**
+			 * Save the result of the compile or link task to the diff
+			 */
+			virtual void				OnTaskDone(TaskHandle task, const STaskResult& result) override;
+
+			/**
+			 * Restore the object of the compile task from `objectCache`
+			 */
+			virtual bool				Fetch(TaskHandle task) override;
+
+			/**
+			 * Save the object of the compile task to `objectCache`
+			 */
+			virtual void				Store(TaskHandle task) override;
+
 		protected:
+			/**
+			 * Compile task data for the cache, it's not changed while tasks are executed
+			 */
+			struct SCacheItem {
+				const SSourceFile*		file;
+				std::filesystem::path	outPath;
+				std::string				prefix; /* Compiler id and command */
+				std::string				key; /* Manifest key, set by `Fetch()` */
+			};
+
+			/**
+			 * Sources compiled as one unity source (`unity` of the build)
+			 */
+			struct SUnityBatch {
+				std::vector<Json::String> sources; /* `m_sources` keys */
+				std::string				name; /* Hash of the sources, changes with them */
+				std::string				extension; /* Of the unity source */
+				std::filesystem::path	outPath;
+				bool					bOutdated								= false;
+			};
+
+			/**
+			 * Group the sources that are not being edited into `m_unityBatches`
+			 * 
+			 * Sources stay in the batch of the last build while it fits the limits,
+			 * so a source pulled out or added compiles only its own batch again
+			 */
+			void						GenUnityBatches(const Json::Value& buildDiff);
+
+			/**
+			 * Dependencies between the sources (`GetSourceDeps()`) to `m_sourceDeps`
+			 * 
+			 * \returns `m_sources` with the dependencies before the sources that need them
+			 */
+			std::vector<TSourceMap::iterator> GenSourceOrder();
+
+			/**
+			 * Compile task of the batch
+			 * 
+			 * \param rDuration Compile time of the sources from the diff, `0` if unknown
+			 * \param rMemory Peak RSS of the heaviest source from the diff in MiB, `0` if unknown
+			 * \returns `DELTAMAKE_TASK_NONE` on error
+			 */
+			TaskHandle					AddUnityTask(ITaskList* taskList, const SUnityBatch& batch, const std::string& cmdBegin, const std::vector<TaskHandle>& pchDeps, const Json::Value& buildDiff, uint64_t& rDuration, uint64_t& rMemory);
+
+			/**
+			 * Save the result of the compile of the source to the diff
+			 * 
+			 * \param unity Name of the batch of the source, empty if it's compiled alone
+			 * \param objectHash Hash of the object (`-c`), empty if unknown
+			 */
+			void						SaveSourceDiff(const Json::String& source, const STaskResult& result, uint64_t duration, const std::string& unity, const std::filesystem::path& outPath, const std::string& objectHash);
+
+			/**
+			 * Precompiled header of the build (`pch` of the build) to `m_pch`,
+			 * and its compile task if it's outdated
+			 * 
+			 * \param flagsBegin Compiler and flags of the compile commands without `-c`
+			 * \returns `false` if the build has no precompiled header
+			 */
+			bool						GenPchTask(ITaskList* taskList, const std::string& flagsBegin, const std::string& compiler);
+
+			/**
+			 * \returns `true` if the source is compiled with `m_pch`
+			 */
+			bool						IsPchUsed(const SSourceFile& file) const;
+
+			/**
+			 * \returns Source mtime of the diff entry in ns or `0` if never built
+			 */
+			static int64_t				GetDiffTime(const Json::Value& entry);
+
+			/**
+			 * \returns Start time of the last successful compile in ns or `0`
+			 */
+			static int64_t				GetBuiltTime(const Json::Value& entry);
+
+			/**
+			 * Output of the task of the diff entry is missing, changed since the task (truncated by a crash,
+			 * replaced by hand) or older than its task
+			 * 
+			 * \param entry Diff entry with `built`, and `size` of the output for the objects
+			 * \param stat Output now
+			 */
+			static bool					IsOutputStale(const char name[], const Json::Value& entry, const SFileStat& stat);
+
+			/**
+			 * Stat the output again after its task
+			 * 
+			 * \returns `false` if the task didn't write it
+			 */
+			static bool					IsOutputWritten(const std::filesystem::path& path, uint64_t& rSize);
+
+			/**
+			 * Hash of link command, object hashes and sub build outputs
+			 * 
+			 * \returns `false` if some object has no hash
+			 */
+			bool						GetLinkHash(std::string& rHash) const;
+
+			/**
+			 * Object of the source in `paths.tmp`, shared by the builds and the sub solutions that compile it the same way
+			 */
+			std::filesystem::path		GetObjectPath(const SSourceFile& file) const;
+
+			/**
+			 * \returns Hash of the source paths relative to the root solution and the compile command
+			 */
+			std::string					GetObjectFingerprint(const std::vector<const SSourceFile*>& files) const;
+
+			/**
+			 * \returns Path relative to the root solution, the same wherever `deltamake` is started and for every checkout
+			 */
+			std::string					GetRootKey(const std::filesystem::path& path) const;
+
+			/**
+			 * \returns Fingerprint of the fully expanded command line
+			 */
+			static std::string			GetCommandHash(const std::string& command);
+
+			/**
+			 * Generate link (`exec`) or archive (`lib`) command of all objects
+			 * to `m_linkCommand`, and its parts around the objects
+			 * 
+			 * \returns `false` if build type is unknown
+			 */
+			bool						GenLinkCommand(const Json::Value& type);
+
+			/**
+			 * \returns Quoted objects, or a response file of them in `paths.tmp` if they are too long
+			 */
+			std::string					GetObjectArgs(const std::vector<std::filesystem::path>& objects) const;
+
+			/**
+			 * \returns `true` if the output of some sub build is modified after `time` (ns)
+			 */
+			bool						IsOutputNewer(int64_t time) const;
+
+			/**
+			 * Command parts of the build
+			 * 
+			 * \param rCompileBegin Compiler and `compilerFlags`
+			 * \param rFlagsBegin Compiler and all flags of the compile commands without `-c`
+			 */
+			void						GenFlagsBegin(std::string& rCompiler, std::string& rCompileBegin, std::string& rFlagsBegin) const;
+
+			/**
+			 * \returns Number of commands to execute
+			 */
+			size_t						GenerateTasks(ITaskList* taskList);
+
+			/**
+			 * Shared sub builds are called by every parent
+			 * 
+			 * \param rRun Last run of the step
+			 * \returns `true` on the first call of the run of `solutionRegistry`
+			 */
+			bool						Visit(size_t& rRun) const;
+
+			size_t						m_preBuildRun							= DELTAMAKE_RUN_NONE;
+			size_t						m_scanRun								= DELTAMAKE_RUN_NONE;
+			size_t						m_buildRun								= DELTAMAKE_RUN_NONE;
+			size_t						m_postBuildRun							= DELTAMAKE_RUN_NONE;
+			size_t						m_nTasks								= 0; /* Of the last `Build()` */
+
 			bool						m_bLink									= false;
+			TaskHandle					m_linkTask								= DELTAMAKE_TASK_NONE;
+			std::string					m_type;
+			std::string					m_commandHash; /* Of the compile command prefix */
+			std::string					m_linkCommand; /* With all objects, its hash is in the diff */
+			std::string					m_linkBegin; /* Before the objects */
+			std::string					m_linkEnd; /* After the objects */
+			std::string					m_linkExec; /* Executed one, only changed members of the archive */
+			bool						m_bArchiveAll							= false; /* Archive is created again */
+			std::filesystem::path		m_outPath;
+
+			bool						m_bLinkHash								= false; /* `m_linkHash` is valid */
+			std::string					m_linkHash; /* Of the last successful link */
+			std::string					m_pendingLinkHash; /* Of the running link */
 
 			const std::string			m_name;
 			Json::Value					m_build;
 			CSolutionDefault*			m_solution;
+			std::filesystem::path		m_rootPath; /* Normalized path of the root solution */
+
+			std::string					m_compiler; /* Of `GenFlagsBegin()` by `Scan()` */
+			std::string					m_compileBegin;
+			std::string					m_flagsBegin;
 
 			std::vector<SSubSolution>	m_subs;
 
 			std::vector<std::filesystem::path> m_objects;
+			std::map<TaskHandle, Json::String> m_taskSources; /* Compile task -> `m_sources` key */
+
+			bool						m_bPch									= false; /* `m_pch` is used */
+			SPrecompiledHeader			m_pch;
+			TaskHandle					m_pchTask								= DELTAMAKE_TASK_NONE;
+			std::string					m_pchCommandHash;
+
+			bool						m_bUnity								= false; /* `unity` of the build is set */
+			std::vector<SUnityBatch>	m_unityBatches;
+			std::map<Json::String, size_t> m_unitySources; /* `m_sources` key -> index of its batch */
+			std::map<TaskHandle, size_t> m_unityTasks; /* Compile task -> index of its batch */
+			std::map<Json::String, std::string> m_sourceHashes; /* Content hashes before compile (`-c`) */
+			std::map<TaskHandle, SCacheItem> m_cacheItems;
+
+			std::map<Json::String, std::vector<Json::String>> m_sourceDeps; /* `m_sources` key -> sources compiled before it */
+			std::set<Json::String>		m_orderedSources; /* Have or are dependencies, compiled alone on this host */
+
+			time_t						m_expires								= std::numeric_limits<time_t>::max(); /* Tasks may change with the time only (`GetGraphInputs()`) */
 	};
 }
 
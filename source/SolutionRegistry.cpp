@@ -0,0 +1,221 @@
+/**
+ * \file	SolutionRegistry.cpp
+ * \brief	Loaded sub solutions
+ * \date	14 oct 2026
+ * \author	Reklov
+ */
+#include "SolutionRegistry.h"
+
+#include <system_error>
+
+#include "Terminal.h"
+#include "Exception.h"
+
+using namespace DeltaMake;
+
+// ******************************************************************************** //
+
+DeltaMake::CSolutionRegistry g_solutionRegistry;
+extern DeltaMake::CSolutionRegistry* const DeltaMake::solutionRegistry = &g_solutionRegistry;
+
+// ******************************************************************************** //
+
+/* ****************************************
+ * DeltaMake::CSolutionRegistry::~CSolutionRegistry
+ */
+DeltaMake::CSolutionRegistry::~CSolutionRegistry() {
+	// Everything is loaded by now, builds first as they point to their solutions
+	for (auto iterator = m_builds.begin(); iterator != m_builds.end(); ++iterator)
+		delete iterator->second.get();
+
+	for (auto iterator = m_solutions.begin(); iterator != m_solutions.end(); ++iterator)
+		delete iterator->second.solution.get();
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionRegistry::GetBuild
+ */
+DeltaMake::CBuild* DeltaMake::CSolutionRegistry::GetBuild(const TKey& parent, const std::filesystem::path& path, const std::string& build, const std::filesystem::path& buildPath, const std::filesystem::path& tmpPath) {
+	const TKey key = GetKey(path, build);
+
+	std::promise<CBuild*> promise;
+	std::shared_future<CBuild*> future;
+	bool bLoad = false;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// Waiting for own parent never ends
+		if ((key == parent) || (IsReachable(key, parent) == true)) {
+			terminal->Log(LOG_ERROR, "Circular sub solution: \"%s\" (%s)\n", key.first.c_str(), key.second.c_str());
+			return nullptr;
+		}
+
+		m_edges[parent].insert(key);
+
+		auto iterator = m_builds.find(key);
+		if (iterator == m_builds.end()) {
+			future = promise.get_future().share();
+			m_builds.emplace(key, future);
+			bLoad = true;
+		}
+		else
+			future = iterator->second;
+	}
+
+	if (bLoad == false) {
+		terminal->Log(LOG_DETAIL, "Sub solution \"%s\" (%s) is shared\n", key.first.c_str(), key.second.c_str());
+		return future.get();
+	}
+
+	CBuild* result = nullptr;
+	CSolutionDefault* solution = GetSolution(key.first, buildPath, tmpPath);
+	if (solution != nullptr) {
+		result = static_cast<CBuild*>(solution->GenBuild(build.c_str())); // Loads its own sub solutions
+		if (result == nullptr)
+			terminal->Log(LOG_ERROR, "Build not found: \"%s\"\n", build.c_str());
+	}
+
+	promise.set_value(result);
+
+	return result;
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionRegistry::SaveDiffs
+ */
+void DeltaMake::CSolutionRegistry::SaveDiffs() {
+	for (auto iterator = m_solutions.begin(); iterator != m_solutions.end(); ++iterator) {
+		CSolutionDefault* solution = iterator->second.solution.get();
+		if (solution != nullptr)
+			solution->SaveDiff(iterator->second.diffPath.c_str());
+	}
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionRegistry::IsDiffChanged
+ */
+bool DeltaMake::CSolutionRegistry::IsDiffChanged() const {
+	for (auto iterator = m_solutions.begin(); iterator != m_solutions.end(); ++iterator) {
+		const CSolutionDefault* solution = iterator->second.solution.get();
+		if ((solution != nullptr) && (solution->IsDiffChanged() == true))
+			return true;
+	}
+
+	return false;
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionRegistry::NextRun
+ */
+void DeltaMake::CSolutionRegistry::NextRun() {
+	++m_run;
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionRegistry::GetRun
+ */
+size_t DeltaMake::CSolutionRegistry::GetRun() const {
+	return m_run;
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionRegistry::GetKey
+ */
+DeltaMake::CSolutionRegistry::TKey DeltaMake::CSolutionRegistry::GetKey(const std::filesystem::path& path, const std::string& build) {
+	std::error_code error;
+	std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error); // `lib/` and `./lib/../lib` are the same
+	if (error)
+		canonical = std::filesystem::absolute(path).lexically_normal();
+
+	if ((canonical.has_filename() == false) && (canonical.has_parent_path() == true))
+		canonical = canonical.parent_path();
+
+	return TKey(canonical, build);
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionRegistry::GetSolution
+ */
+DeltaMake::CSolutionDefault* DeltaMake::CSolutionRegistry::GetSolution(const std::filesystem::path& path, const std::filesystem::path& buildPath, const std::filesystem::path& tmpPath) {
+	std::promise<CSolutionDefault*> promise;
+	std::shared_future<CSolutionDefault*> future;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto iterator = m_solutions.find(path);
+		if (iterator != m_solutions.end())
+			future = iterator->second.solution;
+		else {
+			SSolution& solution = m_solutions[path];
+			solution.solution = promise.get_future().share();
+			solution.diffPath = path / DELTAMAKE_DIFF_FILENAME;
+		}
+	}
+
+	if (future.valid() == true) // Another build of a loaded solution
+		return future.get();
+
+	CSolutionDefault* solution = LoadSolution(path, buildPath, tmpPath);
+	promise.set_value(solution);
+
+	return solution;
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionRegistry::LoadSolution
+ */
+DeltaMake::CSolutionDefault* DeltaMake::CSolutionRegistry::LoadSolution(const std::filesystem::path& path, const std::filesystem::path& buildPath, const std::filesystem::path& tmpPath) {
+	CSolutionDefault* solution = nullptr;
+	try {
+		solution = dynamic_cast<CSolutionDefault*>(ISolution::Load((path / DELTAMAKE_CONFIG_FILENAME).c_str()));
+	}
+	catch (const DeltaMake::CConfigValueNotSet& error) {
+		terminal->Log(LOG_ERROR, "Value not set: %s\n", error.GetMessage());
+	}
+	catch (const DeltaMake::CFileNotExists& error) {
+		terminal->Log(LOG_ERROR, "Can't open file: %s\n", error.GetMessage());
+	}
+
+	if (solution == nullptr) {
+		terminal->Log(LOG_ERROR, "Can't load solution: \"%s\"\n", path.c_str());
+		return nullptr;
+	}
+
+	solution->m_buildPath = buildPath;
+	solution->m_tmpPath   = tmpPath;
+
+	if (config->bForce == false)
+		solution->LoadDiff((path / DELTAMAKE_DIFF_FILENAME).c_str());
+
+	if (config->bScan == true) // The listing cache is in the diff
+		solution->ScanFolders();
+
+	return solution;
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionRegistry::IsReachable
+ */
+bool DeltaMake::CSolutionRegistry::IsReachable(const TKey& from, const TKey& to) const {
+	std::vector<TKey> stack = { from };
+	std::set<TKey> visited;
+
+	while (stack.size() != 0) {
+		const TKey key = stack.back();
+		stack.pop_back();
+
+		if (key == to)
+			return true;
+
+		if (visited.insert(key).second == false)
+			continue;
+
+		auto edges = m_edges.find(key);
+		if (edges == m_edges.end())
+			continue;
+
+		stack.insert(stack.end(), edges->second.begin(), edges->second.end());
+	}
+
+	return false;
+}
@@ -0,0 +1,109 @@
+/**
+ * \file	SolutionRegistry.h
+ * \brief	Loaded sub solutions
+ * \date	14 oct 2026
+ * \author	Reklov
+ */
+#ifndef __DELTAMAKE_SOLUTION_REGISTRY_H__
+#define __DELTAMAKE_SOLUTION_REGISTRY_H__
+
+#include <stddef.h>
+
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+#include <map>
+#include <set>
+#include <mutex>
+#include <future>
+
+#include "deltamake.h"
+#include "SolutionDefault.h"
+
+// ******************************************************************************** //
+
+										//										//
+namespace DeltaMake {
+	/**
+	 * Sub solutions and their builds, every one is loaded once and shared by all the builds that need it
+	 *
+	 * \warning `GetBuild()` is called from the loading threads of the parents
+	 */
+	class CSolutionRegistry final {
+		public:
+			/**
+			 * Solution directory and build name
+			 */
+			typedef std::pair<std::filesystem::path, std::string> TKey;
+
+										~CSolutionRegistry();
+
+			/**
+			 * Load the solution, its diff and its build, or wait for another parent that loads them
+			 *
+			 * \param parent Key of the build that needs it, for the circular check
+			 * \param buildPath `paths.build` of the parent, the first parent sets it
+			 * \param tmpPath `paths.tmp` of the parent
+			 * \returns `nullptr` on error
+			 */
+			CBuild*						GetBuild(const TKey& parent, const std::filesystem::path& path, const std::string& build, const std::filesystem::path& buildPath, const std::filesystem::path& tmpPath);
+
+			/**
+			 * Save diffs of all loaded solutions
+			 */
+			void						SaveDiffs();
+
+			/**
+			 * \returns `true` if some loaded solution has `ISolution::IsDiffChanged()`
+			 */
+			bool						IsDiffChanged() const;
+
+			/**
+			 * Start of the next `PreBuild()`, `Build()` and `PostBuild()` of all builds
+			 */
+			void						NextRun();
+
+			/**
+			 * \returns Number of the current run, shared builds are visited once per run
+			 */
+			size_t						GetRun() const;
+
+			/**
+			 * \returns Key of the build in the solution directory
+			 */
+			static TKey					GetKey(const std::filesystem::path& path, const std::string& build);
+
+		private:
+			/**
+			 * Loaded solution
+			 */
+			struct SSolution {
+				std::shared_future<CSolutionDefault*> solution;
+				std::filesystem::path	diffPath;
+			};
+
+			/**
+			 * \returns `nullptr` on error
+			 */
+			CSolutionDefault*			GetSolution(const std::filesystem::path& path, const std::filesystem::path& buildPath, const std::filesystem::path& tmpPath);
+
+			static CSolutionDefault*	LoadSolution(const std::filesystem::path& path, const std::filesystem::path& buildPath, const std::filesystem::path& tmpPath);
+
+			/**
+			 * \returns `true` if `from` needs `to` through the known edges
+			 */
+			bool						IsReachable(const TKey& from, const TKey& to) const;
+
+			std::mutex					m_mutex;
+			std::map<std::filesystem::path, SSolution> m_solutions;
+			std::map<TKey, std::shared_future<CBuild*>> m_builds;
+			std::map<TKey, std::set<TKey>> m_edges; /* Build -> sub builds */
+
+			size_t						m_run									= 0;
+	};
+
+	extern CSolutionRegistry* const solutionRegistry;
+}
+
+#endif /* !__DELTAMAKE_SOLUTION_REGISTRY_H__ */
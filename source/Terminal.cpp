@@ -25,6 +25,8 @@ class CTerminalLocal final : public ITerminal {
 		virtual							~CTerminalLocal() override				= default;
 
 		virtual void					Init() override;
+
+		virtual bool					IsInteractive() const override;
 	
 		virtual void					UpdateSize() override;
 
@@ -45,6 +47,9 @@ class CTerminalLocal final : public ITerminal {
 		virtual int						Log(ELogLevel level, const char format[], ...) override;
 		virtual int						Write(const char msg[]) override;
 
+		virtual void					Lock() override;
+		virtual void					Unlock() override;
+
 		virtual size_t					GetColumns() const override;
 		virtual size_t					GetRows() const override;
 
@@ -55,6 +60,9 @@ class CTerminalLocal final : public ITerminal {
 
 		size_t							m_nColumns;
 		size_t							m_nRows;
+
+		bool							m_bInteractive							= false;
+		bool							m_bColors[2]							= { false, false }; // { `stdout`, `stderr` }
 };
 
 CTerminalLocal g_terminalLocal;
@@ -73,9 +81,28 @@ extern DeltaMake::ITerminal* const DeltaMake::terminal = &g_terminalLocal;
  * CTerminalLocal::Init
  */
 void CTerminalLocal::Init() {
+	const char* term = getenv("TERM");
+	const bool bDumb = (term == nullptr) || (strcmp(term, "dumb") == 0);
+
+	m_bInteractive = (isatty(STDOUT_FILENO) == 1) && (bDumb == false);
+
+	// Colors are fine in CI logs, but not in files
+	m_bColors[0] = (isatty(STDOUT_FILENO) == 1) && (bDumb == false);
+	m_bColors[1] = (isatty(STDERR_FILENO) == 1) && (bDumb == false);
+
+	if (m_bInteractive == false) // In order with `stderr` in CI logs
+		SetBuffering(ELogBuffering::LINE);
+
 	UpdateSize();
 }
 
+/* ****************************************
+ * CTerminalLocal::IsInteractive
+ */
+bool CTerminalLocal::IsInteractive() const {
+	return m_bInteractive;
+}
+
 /* ****************************************
  * CTerminalLocal::MoveUp
  */
@@ -206,13 +233,18 @@ int CTerminalLocal::Log(ELogLevel level, const char format[], ...) {
 		return 0;
 
 	FILE* const out = (level == ELogLevel::LOG_ERROR) ? stderr : stdout;
+	const bool bColors = m_bColors[(level == ELogLevel::LOG_ERROR) ? 1 : 0];
 
-	switch (level) {
-		case ELogLevel::LOG_ERROR:		fputs("\033[0;31m", out); break; // Red
-		case ELogLevel::LOG_WARNING:	fputs("\033[0;33m", out); break; // Yellow
-		case ELogLevel::LOG_DETAIL:		fputs("\033[0;36m", out); break; // Cyan
-	
-		default:						fputs("\033[0m", out); break; // Reset
+	flockfile(out); // Color and message together
+
+	if (bColors == true) {
+		switch (level) {
+			case ELogLevel::LOG_ERROR:		fputs("\033[0;31m", out); break; // Red
+			case ELogLevel::LOG_WARNING:	fputs("\033[0;33m", out); break; // Yellow
+			case ELogLevel::LOG_DETAIL:		fputs("\033[0;36m", out); break; // Cyan
+		
+			default:						fputs("\033[0m", out); break; // Reset
+		}
 	}
 
 	va_list argptr;
@@ -220,7 +252,10 @@ int CTerminalLocal::Log(ELogLevel level, const char format[], ...) {
 	int size = vfprintf(out, format, argptr);
 	va_end(argptr);
 
-	fputs("\033[0m", out); // Reset color
+	if (bColors == true)
+		fputs("\033[0m", out); // Reset color
+
+	funlockfile(out);
 
 	return size;
 }
@@ -232,6 +267,22 @@ int CTerminalLocal::Write(const char msg[]) {
 	return fputs(msg, stdout);
 }
 
+/* ****************************************
+ * CTerminalLocal::Lock
+ */
+void CTerminalLocal::Lock() {
+	flockfile(stdout);
+	flockfile(stderr);
+}
+
+/* ****************************************
+ * CTerminalLocal::Unlock
+ */
+void CTerminalLocal::Unlock() {
+	funlockfile(stderr);
+	funlockfile(stdout);
+}
+
 /* ****************************************
  * CTerminalLocal::ExecSystem
  */
@@ -251,7 +302,8 @@ int CTerminalLocal::ExecSystem(const char cmd[]) {
  */
 time_t CTerminalLocal::GetLastModificationTime(const char path[]) {
 	struct stat stats;
-	stat(path, &stats);
+	if (stat(path, &stats) != 0)
+		return 0; // Missing file is not newer than anything
 	
 	return stats.st_mtime;
 }
@@ -261,7 +313,10 @@ time_t CTerminalLocal::GetLastModificationTime(const char path[]) {
  */
 void CTerminalLocal::UpdateSize() {
 	struct winsize ws;
-	ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws);
+	if ((ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) != 0) || (ws.ws_col == 0) || (ws.ws_row == 0)) { // Pipe or file
+		ws.ws_col = DELTAMAKE_TERMINAL_COLUMNS;
+		ws.ws_row = DELTAMAKE_TERMINAL_ROWS;
+	}
 
 	m_nColumns = static_cast<size_t>(ws.ws_col);
 	m_nRows = static_cast<size_t>(ws.ws_row);
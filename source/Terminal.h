@@ -40,6 +40,14 @@ namespace DeltaMake {
 
 			virtual void				Init()									= 0;
 
+			/**
+			 * \returns `true` if `stdout` is a terminal that knows escape sequences
+			 */
+			virtual bool				IsInteractive() const					= 0;
+
+			/**
+			 * Default size if it's not a terminal
+			 */
 			virtual void				UpdateSize()							= 0;
 
 			virtual void				MoveUp(size_t offset)					= 0;
@@ -66,6 +74,12 @@ namespace DeltaMake {
 			virtual int					Log(ELogLevel level, const char format[], ...) = 0;
 			virtual int					Write(const char msg[])					= 0;
 
+			/**
+			 * Output of other threads waits until `Unlock()`, recursive
+			 */
+			virtual void				Lock()									= 0;
+			virtual void				Unlock()								= 0;
+
 			virtual size_t				GetColumns() const						= 0;
 			virtual size_t				GetRows() const							= 0;
 
@@ -0,0 +1,153 @@
+/**
+ * \file	Trace.cpp
+ * \brief	Build timeline in Chrome trace event format
+ * \date	14 oct 2026
+ * \author	Reklov
+ */
+#include "Trace.h"
+
+#include <unistd.h>
+
+#include <fstream>
+
+#include "Terminal.h"
+
+using namespace DeltaMake;
+
+// ******************************************************************************** //
+
+DeltaMake::CTrace g_trace;
+extern DeltaMake::CTrace* const DeltaMake::trace = &g_trace;
+
+// ******************************************************************************** //
+
+/* ****************************************
+ * DeltaMake::CTrace::Init
+ */
+void DeltaMake::CTrace::Init(const char path[]) {
+	m_origin = std::chrono::steady_clock::now();
+
+	if (path == nullptr)
+		return;
+
+	m_path = path;
+	SetLaneName(DELTAMAKE_TRACE_MAIN_LANE, "deltamake");
+}
+
+/* ****************************************
+ * DeltaMake::CTrace::IsEnabled
+ */
+bool DeltaMake::CTrace::IsEnabled() const {
+	return m_path.size() != 0;
+}
+
+/* ****************************************
+ * DeltaMake::CTrace::GetTime
+ */
+uint64_t DeltaMake::CTrace::GetTime() const {
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_origin).count();
+}
+
+/* ****************************************
+ * DeltaMake::CTrace::AddEvent
+ */
+void DeltaMake::CTrace::AddEvent(const char name[], const char category[], size_t lane, uint64_t begin, uint64_t end, const Json::Value& args) {
+	if (IsEnabled() == false)
+		return;
+
+	Json::Value event;
+	event["name"] = name;
+	event["cat"] = category;
+	event["ph"] = "X";
+	event["pid"] = static_cast<Json::Int64>(getpid());
+	event["tid"] = static_cast<Json::UInt64>(lane);
+	event["ts"] = static_cast<Json::UInt64>(begin);
+	event["dur"] = static_cast<Json::UInt64>((end > begin) ? (end - begin) : 0);
+
+	if (args.isNull() == false)
+		event["args"] = args;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_events.append(event);
+}
+
+/* ****************************************
+ * DeltaMake::CTrace::AddCounter
+ */
+void DeltaMake::CTrace::AddCounter(const char name[], uint64_t time, const Json::Value& values) {
+	if (IsEnabled() == false)
+		return;
+
+	Json::Value event;
+	event["name"] = name;
+	event["ph"] = "C";
+	event["pid"] = static_cast<Json::Int64>(getpid());
+	event["ts"] = static_cast<Json::UInt64>(time);
+	event["args"] = values;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_events.append(event);
+}
+
+/* ****************************************
+ * DeltaMake::CTrace::SetLaneName
+ */
+void DeltaMake::CTrace::SetLaneName(size_t lane, const std::string& name) {
+	if (IsEnabled() == false)
+		return;
+
+	Json::Value event;
+	event["name"] = "thread_name";
+	event["ph"] = "M";
+	event["pid"] = static_cast<Json::Int64>(getpid());
+	event["tid"] = static_cast<Json::UInt64>(lane);
+	event["args"]["name"] = name;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_events.append(event);
+}
+
+/* ****************************************
+ * DeltaMake::CTrace::Save
+ */
+bool DeltaMake::CTrace::Save() {
+	if (IsEnabled() == false)
+		return true;
+
+	Json::Value root;
+	root["displayTimeUnit"] = "ms";
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		root["traceEvents"].swap(m_events);
+		m_events = Json::Value(Json::arrayValue);
+	}
+
+	SetLaneName(DELTAMAKE_TRACE_MAIN_LANE, "deltamake"); // The next build of `--watch` is saved again
+
+	std::ofstream file(m_path, std::ios::trunc);
+	Json::FastWriter writer;
+	file << writer.write(root);
+	file.close();
+
+	if (file.fail() == true) {
+		terminal->Log(LOG_WARNING, "Can't save trace \"%s\"\n", m_path.c_str());
+		return false;
+	}
+
+	terminal->Log(LOG_INFO, "Trace: \"%s\" (%u events)\n", m_path.c_str(), root["traceEvents"].size());
+
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CTraceScope::CTraceScope
+ */
+DeltaMake::CTraceScope::CTraceScope(const char name[]) : m_name(name), m_begin(trace->GetTime()) { }
+
+/* ****************************************
+ * DeltaMake::CTraceScope::~CTraceScope
+ */
+DeltaMake::CTraceScope::~CTraceScope() {
+	trace->AddEvent(m_name, "phase", DELTAMAKE_TRACE_MAIN_LANE, m_begin, trace->GetTime());
+}
@@ -0,0 +1,89 @@
+/**
+ * \file	Trace.h
+ * \brief	Build timeline in Chrome trace event format
+ * \date	14 oct 2026
+ * \author	Reklov
+ */
+#ifndef __DELTAMAKE_TRACE_H__
+#define __DELTAMAKE_TRACE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <mutex>
+#include <chrono>
+
+#include "deltamake.h"
+
+
+#define DELTAMAKE_TRACE_MAIN_LANE		0 // Phases of the main thread, workers are `1 + index`
+
+// ******************************************************************************** //
+
+										//										//
+namespace DeltaMake {
+	/**
+	 * Timeline for `chrome://tracing` or Perfetto (`--trace` flag)
+	 *
+	 * \warning `AddEvent()` may be called from any thread
+	 */
+	class CTrace final {
+		public:
+			/**
+			 * \param path Output file, `nullptr` disables the trace
+			 */
+			void						Init(const char path[]);
+
+			bool						IsEnabled() const;
+
+			/**
+			 * \returns µs since `Init()`
+			 */
+			uint64_t					GetTime() const;
+
+			/**
+			 * Complete event (`"ph": "X"`)
+			 *
+			 * \param lane Timeline row, `DELTAMAKE_TRACE_MAIN_LANE` or worker
+			 * \param args Shown in the details of the event
+			 */
+			void						AddEvent(const char name[], const char category[], size_t lane, uint64_t begin, uint64_t end, const Json::Value& args = Json::Value());
+
+			/**
+			 * Counter event (`"ph": "C"`), every member of `values` is a series of the counter
+			 */
+			void						AddCounter(const char name[], uint64_t time, const Json::Value& values);
+
+			/**
+			 * \param name Name of the timeline row
+			 */
+			void						SetLaneName(size_t lane, const std::string& name);
+
+			bool						Save();
+
+		private:
+			std::string					m_path;
+			std::chrono::steady_clock::time_point m_origin;
+
+			std::mutex					m_mutex; /* Events */
+			Json::Value					m_events								= Json::Value(Json::arrayValue);
+	};
+
+	/**
+	 * Phase of the main thread from the constructor to the destructor
+	 */
+	class CTraceScope final {
+		public:
+										CTraceScope(const char name[]);
+										~CTraceScope();
+
+		private:
+			const char*					m_name;
+			uint64_t					m_begin;
+	};
+
+	extern CTrace* const trace;
+}
+
+#endif /* !__DELTAMAKE_TRACE_H__ */
@@ -0,0 +1,236 @@
+/**
+ * \file	Watch.cpp
+ * \brief	Inputs watcher of `--watch`
+ * \date	14 oct 2026
+ * \author	Reklov
+ */
+#include "Watch.h"
+
+#include <string.h>
+#include <errno.h>
+
+#include <unistd.h>
+#include <poll.h>
+#include <sys/inotify.h>
+
+#include <system_error>
+
+#include "Terminal.h"
+
+using namespace DeltaMake;
+
+// ******************************************************************************** //
+
+#define DELTAMAKE_WATCH_EVENTS			(IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR)
+
+// ******************************************************************************** //
+
+/* ****************************************
+ * DeltaMake::CWatcher::~CWatcher
+ */
+DeltaMake::CWatcher::~CWatcher() {
+	if (m_fd >= 0)
+		close(m_fd);
+}
+
+/* ****************************************
+ * DeltaMake::CWatcher::Init
+ */
+bool DeltaMake::CWatcher::Init() {
+	m_fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+	if (m_fd < 0) {
+		terminal->Log(LOG_ERROR, "Can't init inotify: %s\n", strerror(errno));
+		return false;
+	}
+
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CWatcher::Add
+ */
+bool DeltaMake::CWatcher::Add(const std::filesystem::path& path) {
+	const std::filesystem::path normalized = Normalize(path);
+
+	std::error_code error;
+	if (std::filesystem::is_directory(normalized, error) == true)
+		return AddDirectory(normalized, true);
+
+	return AddDirectory(normalized.parent_path(), false);
+}
+
+/* ****************************************
+ * DeltaMake::CWatcher::Exclude
+ */
+void DeltaMake::CWatcher::Exclude(const std::filesystem::path& directory) {
+	m_excluded.insert(Normalize(directory));
+}
+
+/* ****************************************
+ * DeltaMake::CWatcher::Wait
+ */
+bool DeltaMake::CWatcher::Wait(std::set<std::filesystem::path>& rChanged) {
+	pollfd pfd;
+	pfd.fd = m_fd;
+	pfd.events = POLLIN;
+
+	int timeout = -1; // The first change may take a while
+	while (true) {
+		const int ready = poll(&pfd, 1, timeout);
+		if (ready < 0) {
+			if (errno == EINTR)
+				continue;
+
+			terminal->Log(LOG_ERROR, "Can't wait for changes: %s\n", strerror(errno));
+			return false;
+		}
+
+		if (ready == 0) {
+			if (rChanged.size() != 0)
+				return true;
+
+			timeout = -1; // Only ignored events, like of a removed watch
+			continue;
+		}
+
+		if (ReadEvents(rChanged) == false)
+			return false;
+
+		if (rChanged.size() != 0)
+			timeout = DELTAMAKE_WATCH_DEBOUNCE;
+	}
+}
+
+/* ****************************************
+ * DeltaMake::CWatcher::Normalize
+ */
+std::filesystem::path DeltaMake::CWatcher::Normalize(const std::filesystem::path& path) {
+	std::filesystem::path normalized = std::filesystem::absolute(path).lexically_normal();
+	if ((normalized.has_filename() == false) && (normalized.has_parent_path() == true) && (normalized != normalized.root_path()))
+		normalized = normalized.parent_path();
+
+	return normalized;
+}
+
+/* ****************************************
+ * DeltaMake::CWatcher::AddDirectory
+ */
+bool DeltaMake::CWatcher::AddDirectory(const std::filesystem::path& directory, bool bRecursive, std::set<std::filesystem::path>* pFound) {
+	if (m_excluded.count(directory) != 0)
+		return true;
+
+	auto watched = m_watched.find(directory);
+	if ((watched != m_watched.end()) && ((bRecursive == false) || (m_watches[watched->second].bRecursive == true)))
+		return true;
+
+	const int wd = inotify_add_watch(m_fd, directory.c_str(), DELTAMAKE_WATCH_EVENTS);
+	if (wd < 0) {
+		terminal->Log(LOG_WARNING, "Can't watch \"%s\": %s\n", directory.c_str(), strerror(errno));
+		return false;
+	}
+
+	SWatch& watch = m_watches[wd];
+	watch.path = directory;
+	watch.bRecursive = (watch.bRecursive == true) || (bRecursive == true); // The same directory may be watched with another path
+	m_watched[directory] = wd;
+
+	terminal->Log(LOG_DETAIL, "Watching \"%s\"\n", directory.c_str());
+
+	if (bRecursive == false)
+		return true;
+
+	std::error_code error;
+	for (auto iterator = std::filesystem::directory_iterator(directory, error); iterator != std::filesystem::directory_iterator(); iterator.increment(error)) {
+		if (error)
+			break;
+
+		const std::filesystem::directory_entry& entry = *iterator;
+		if (entry.is_symlink(error) == true)
+			continue; // No loops
+
+		if (entry.is_directory(error) == true)
+			AddDirectory(entry.path(), true, pFound);
+		else if (pFound != nullptr)
+			pFound->insert(entry.path());
+	}
+
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CWatcher::RemoveDirectory
+ */
+void DeltaMake::CWatcher::RemoveDirectory(const std::filesystem::path& directory) {
+	for (auto watched = m_watched.lower_bound(directory); watched != m_watched.end();) {
+		const std::filesystem::path relative = watched->first.lexically_relative(directory);
+		if ((relative.empty() == true) || (*relative.begin() == ".."))
+			break; // Sorted, so the subdirectories are next to it
+
+		inotify_rm_watch(m_fd, watched->second);
+		m_watches.erase(watched->second);
+		watched = m_watched.erase(watched);
+	}
+}
+
+/* ****************************************
+ * DeltaMake::CWatcher::ReadEvents
+ */
+bool DeltaMake::CWatcher::ReadEvents(std::set<std::filesystem::path>& rChanged) {
+	alignas(inotify_event) char buffer[DELTAMAKE_WATCH_BUFFER_SIZE];
+
+	while (true) {
+		const ssize_t nRead = read(m_fd, buffer, sizeof(buffer));
+		if (nRead < 0) {
+			if (errno == EAGAIN)
+				return true;
+
+			if (errno == EINTR)
+				continue;
+
+			terminal->Log(LOG_ERROR, "Can't read changes: %s\n", strerror(errno));
+			return false;
+		}
+
+		for (ssize_t offset = 0; offset < nRead;) {
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+			offset += sizeof(inotify_event) + event->len;
+
+			if ((event->mask & IN_Q_OVERFLOW) != 0) { // Changed directories are all we know
+				terminal->Log(LOG_WARNING, "Too many changes at once, rescanning watched directories\n");
+				for (auto watch = m_watches.begin(); watch != m_watches.end(); ++watch)
+					rChanged.insert(watch->second.path);
+
+				continue;
+			}
+
+			auto watch = m_watches.find(event->wd);
+			if (watch == m_watches.end())
+				continue;
+
+			if ((event->mask & IN_IGNORED) != 0) { // Directory is removed
+				m_watched.erase(watch->second.path);
+				m_watches.erase(watch);
+				continue;
+			}
+
+			if (event->len == 0)
+				continue;
+
+			const std::filesystem::path path = watch->second.path / event->name;
+
+			if ((event->mask & IN_ISDIR) != 0) {
+				if ((watch->second.bRecursive == true) && ((event->mask & (IN_CREATE | IN_MOVED_TO)) != 0))
+					AddDirectory(path, true, &rChanged);
+
+				if ((event->mask & (IN_DELETE | IN_MOVED_FROM)) != 0) { // Sources in it are gone too
+					RemoveDirectory(path);
+					rChanged.insert(path);
+				}
+
+				continue;
+			}
+
+			rChanged.insert(path);
+		}
+	}
+}
@@ -0,0 +1,101 @@
+/**
+ * \file	Watch.h
+ * \brief	Inputs watcher of `--watch`
+ * \date	14 oct 2026
+ * \author	Reklov
+ */
+#ifndef __DELTAMAKE_WATCH_H__
+#define __DELTAMAKE_WATCH_H__
+
+#include <stddef.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+#include "deltamake.h"
+
+
+#define DELTAMAKE_WATCH_DEBOUNCE		100 // ms without new events before the rebuild, editors write files in parts
+#define DELTAMAKE_WATCH_BUFFER_SIZE		65536
+
+// ******************************************************************************** //
+
+										//										//
+namespace DeltaMake {
+	/**
+	 * inotify watches of directories
+	 *
+	 * Files are watched with their directory, so the editors that save
+	 * with a rename of a new file are not lost
+	 */
+	class CWatcher final {
+		public:
+										~CWatcher();
+
+			bool						Init();
+
+			/**
+			 * Watch the directory of the file, or the directory and all its subdirectories,
+			 * also the ones created later (`paths.scan`)
+			 *
+			 * \returns `false` if it can't be watched
+			 */
+			bool						Add(const std::filesystem::path& path);
+
+			/**
+			 * Directory and its subdirectories are not watched with the recursive ones (outputs of the build)
+			 */
+			void						Exclude(const std::filesystem::path& directory);
+
+			/**
+			 * Wait for the first change, then collect the next ones until
+			 * `DELTAMAKE_WATCH_DEBOUNCE` ms pass without any
+			 *
+			 * \param rChanged Written, created, deleted and moved files, and deleted and moved away directories for everything in them
+			 * \returns `false` on error
+			 */
+			bool						Wait(std::set<std::filesystem::path>& rChanged);
+
+			/**
+			 * \returns Path without `.`, `..` and the trailing separator, as it's compared with the changed ones
+			 */
+			static std::filesystem::path Normalize(const std::filesystem::path& path);
+
+		private:
+			/**
+			 * Directory watch
+			 */
+			struct SWatch {
+				std::filesystem::path	path;
+				bool					bRecursive								= false;
+			};
+
+			/**
+			 * \param pFound Files of the new directories that are created before their watch
+			 */
+			bool						AddDirectory(const std::filesystem::path& directory, bool bRecursive, std::set<std::filesystem::path>* pFound = nullptr);
+
+			/**
+			 * Stop watching the moved away directory and its subdirectories, their watches follow them
+			 */
+			void						RemoveDirectory(const std::filesystem::path& directory);
+
+			/**
+			 * Read and parse the pending events
+			 *
+			 * \returns `false` on error
+			 */
+			bool						ReadEvents(std::set<std::filesystem::path>& rChanged);
+
+			int							m_fd									= -1;
+
+			std::map<int, SWatch>		m_watches; /* Watch descriptor -> directory */
+			std::map<std::filesystem::path, int> m_watched; /* Directory -> watch descriptor */
+			std::set<std::filesystem::path> m_excluded;
+	};
+}
+
+#endif /* !__DELTAMAKE_WATCH_H__ */
@@ -11,14 +11,31 @@
 #include <poll.h> // TODO: Win impl
 #include <paths.h>
 #include <wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
 
 #include <vector>
 #include <string>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <queue>
+#include <map>
+#include <ctime>
+#include <fstream>
+#include <iterator>
 
 #include "Terminal.h"
+#include "Process.h"
+#include "Remote.h"
+#include "JobServer.h"
+#include "Trace.h"
+#include "Pressure.h"
 
 using namespace DeltaMake;
 
@@ -26,60 +43,17 @@ using namespace DeltaMake;
 
 #if defined(__linux__) // TODO: Win impl
 
-#define PROCESS_POLL_OUT				0
-#define PROCESS_POLL_ERR				1
-
-#define PROCESS_CLOSE_PIPE(pipe) \
-	{ close(pipe); pipe = 0; }
-
-#define PROCESS_REDIRECT_OUTPUT_PIPE(pipe, std) { \
-		PROCESS_CLOSE_PIPE(pipe[0]); \
-		if (pipe[1] != std) { \
-			dup2(pipe[1], std); \
-			PROCESS_CLOSE_PIPE(pipe[1]); \
-		} \
-	}
-
-
-extern char** environ; // For POSIX.1
-
-/**
- * Wrapper for system process and output streams
- */
-class CProcess final {
-	public:
-										CProcess();
-										~CProcess();
-
-		bool							Exec(const char command[], int& rReturnStatus);
-
-		bool							Kill();
-
-		const std::string&				GetOutBuffer() const;
-		const std::string&				GetErrBuffer() const;
-
-	private:
-
-		bool							Clear();
-		bool							CheckPollFD(size_t index);
-
-		std::string						m_outBuffer;
-		std::string						m_errBuffer;
-
-		int								m_outPipe[2]							= { 0 };
-		int								m_errPipe[2]							= { 0 };
-
-		pid_t							m_pid									= -1;
-		pollfd							m_pfd[2]								= { 0 }; // { `stdout`, `stderr` }
-		int								m_status								= -1;
-};
-
 /**
  * SIGINT catcher
  */
 namespace SignalInterruptCatcher {
 	void								Init();
 
+	/**
+	 * Handler of the time before `Init()`
+	 */
+	void								Restore();
+
 	/**
 	 * Gentle SIGINT catcher
 	 */
@@ -122,32 +96,18 @@ class ITask {
 
 /**
  * Execution queue barrier
+ * There is nothing to execute, so the scheduler completes it as soon as all dependencies are done
  */
 class CBarrierTask final : public ITask {
 	public:
-										CBarrierTask(int value);
 		virtual							~CBarrierTask()	override				= default;
 		
 		virtual const char*				GetTitle() const override;
 		virtual ETaskType				GetType() const override;
-
-		/**
-		 * Wait untill `m_counter >= m_value`
-		 */
 		virtual bool					Execute() override;
 
-		/**
-		 * Sets `m_counter` to `m_value`
-		 */
-		void							Skip();
-
-		bool							IsDone() const;
-
 	protected:
 		const char						m_title[14]								= DELTAMAKE_BARRIER_TITLE;
-
-		std::atomic_int					m_counter								= 0;
-		const int						m_value;
 };
 
 /**
@@ -168,6 +128,39 @@ class CCommandTask final : public ITask {
 		 */
 		int								GetReturnValue() const;
 
+		/**
+		 * \param handle Handle of this task for the cache
+		 */
+		void							SetCache(ITaskCache* cache, TaskHandle handle);
+
+		/**
+		 * \returns `true` if the last `Execute()` was satisfied by the cache
+		 */
+		bool							IsCached() const;
+
+		void							SetRemote(const SRemoteCommand& remote);
+
+		/**
+		 * \param path `stdout` of the local process
+		 */
+		void							SetOutputFile(const std::filesystem::path& path);
+
+		/**
+		 * \returns `true` if the last `Execute()` was compiled on the build node
+		 */
+		bool							IsRemote() const;
+
+		/**
+		 * \returns Output of the local process or the build node
+		 */
+		const std::string&				GetOutBuffer() const;
+		const std::string&				GetErrBuffer() const;
+
+		/**
+		 * \returns Bytes of the output, not only captured
+		 */
+		size_t							GetOutputSize() const;
+
 
 		const CProcess&					GetProcess() const;
 		void							KillProcess();
@@ -175,13 +168,91 @@ class CCommandTask final : public ITask {
 	private:
 		const std::string				m_title;
 		const std::string				m_command;
+		std::vector<std::string>		m_args; /* Split `m_command`, empty if the shell is needed */
 		const bool						m_bFailIfNonZero;
 		
-		int								m_returnValue;
+		int								m_returnValue							= -1;
+
+		/**
+		 * Preprocess locally and compile on a build node
+		 * 
+		 * \returns `false` if it must be executed locally
+		 */
+		bool							ExecuteRemote(bool& rbSuccess);
+
+		/**
+		 * Local process, limited by `g_localSlots` and jobserver tokens
+		 *
+		 * \param args Split `command` to execute it without the shell, if not empty
+		 */
+		bool							ExecuteLocal(const std::string& command, const std::vector<std::string>& args);
+
+		ITaskCache*						m_cache									= nullptr;
+		TaskHandle						m_handle								= DELTAMAKE_TASK_NONE;
+		bool							m_bCached								= false;
+
+		SRemoteCommand					m_remote; /* Local only if `compile` is empty */
+		std::vector<std::string>		m_remoteArgs; /* Split `m_remote.preprocess` */
+		bool							m_bRemote								= false; /* Executed on the build node */
+		std::atomic<bool>				m_bCancel								= false;
+		std::string						m_remoteOut;
+		std::string						m_remoteErr;
 
 		CProcess						m_process;
 };
 
+/**
+ * Task state in the dependency graph
+ */
+enum class ETaskState : int {
+	WAITING, /* Some dependencies are not done */
+	READY, /* In the ready queue */
+	RUNNING,
+	DONE,
+	FAILED,
+};
+
+/**
+ * Task with its dependency graph edges
+ */
+struct STaskNode {
+	ITask*								task									= nullptr;
+	std::vector<ITaskListener*>			listeners; /* One per `AddCommand()` of the shared command */
+	ETaskState							state									= ETaskState::WAITING;
+	size_t								nPending								= 0; /* Dependencies that are not done yet */
+	std::vector<TaskHandle>				dependents;
+
+	uint64_t							estimate								= 0; /* ms */
+	uint64_t							priority								= 0; /* Longest path to the end through this task (ms) */
+
+	uint64_t							readyTime								= 0; /* µs of `trace`, queue wait starts */
+
+	ETaskClass							taskClass								= ETaskClass::COMPILE;
+	uint64_t							memory									= 0; /* MiB */
+	bool								bDelayed								= false; /* Waited for the memory budget */
+};
+
+/**
+ * Ready queue order: longest remaining path first, then the order of adding
+ */
+class CTaskPriorityLess final {
+	public:
+										CTaskPriorityLess(const std::vector<STaskNode>* tasks) : m_tasks(tasks) { }
+
+		bool							operator()(TaskHandle a, TaskHandle b) const {
+			const uint64_t priorityA = (*m_tasks)[a].priority;
+			const uint64_t priorityB = (*m_tasks)[b].priority;
+
+			if (priorityA != priorityB)
+				return priorityA < priorityB;
+
+			return a > b;
+		}
+
+	private:
+		const std::vector<STaskNode>*	m_tasks;
+};
+
 /**
  * Worker Status
  */
@@ -192,6 +263,18 @@ enum class EWorkerStatus : int {
 	STOPPED
 };
 
+/**
+ * Worker measurements (`-m` flag)
+ * Written by the worker thread, read by the scheduler after `join()`
+ */
+struct SWorkerStats {
+	size_t								nDispatches								= 0;
+	uint64_t							idleNs									= 0; /* Wall time spent waiting for a task */
+	uint64_t							latencyNs								= 0; /* Part of `idleNs` that ended with a task */
+	uint64_t							maxLatencyNs							= 0; /* Longest single wait for a task */
+	uint64_t							cpuNs									= 0; /* CPU time of the worker thread itself, waits don't count */
+};
+
 /**
  * Worker Data
  */
@@ -199,13 +282,30 @@ struct SWorker {
 	/* Critical section */
 
 	std::mutex							mutex;
+	std::condition_variable				wakeup; /* Notified with `mutex` when `status` leaves `WAIT_TASK` */
 	ITask*								task									= nullptr;
 
+	/* Scheduler thread only */
+
+	TaskHandle							handle									= DELTAMAKE_TASK_NONE; /* Task given to the worker and not reaped yet */
+
+	/* Written by the worker before it's back to `WAIT_TASK` */
+
+	int64_t								startTime								= 0; /* ns of the wall clock */
+	uint64_t							duration								= 0; /* ms */
+	bool								bFailed									= false; /* Task is failed, the worker goes on (`-k`) */
+
+	size_t								index									= 0; /* Trace lane is `1 + index` */
+	std::atomic<uint64_t>				traceBegin								= 0; /* µs of `trace` */
+	std::atomic<uint64_t>				traceEnd								= 0;
+
 	/* Not so critical section */
 
 	std::atomic<EWorkerStatus>			status									= EWorkerStatus::WAIT_TASK;
 
 	std::thread							thread;
+
+	SWorkerStats						stats;
 };
 
 /**
@@ -223,6 +323,16 @@ enum class ESchedulerStatus : int {
 	KILLING,
 };
 
+/**
+ * Ended task for the status thread
+ */
+struct STaskStatus {
+	const ITask*						task; /* Deleted after the status thread is joined */
+	size_t								index; /* Number of ended tasks, `0` if failed */
+	uint64_t							duration; /* ms */
+	bool								bCached;
+};
+
 /**
  * CSchedulerLocal
  */
@@ -234,37 +344,161 @@ class CSchedulerLocal final : public IScheduler, public ITaskList {
 
 		virtual ITaskList*				GetList() override;
 
-		virtual void					Start() override;
+		virtual bool					Start() override;
 
 		virtual void					Stop() override;
 		virtual void					Kill() override;
 
 
-		virtual void					AddCommand(const char title[], const std::string& command, bool bFailIfNonZero = true) override;
-		virtual void					AddBarrier() override;
+		virtual TaskHandle				AddCommand(const char title[], const std::string& command, const std::vector<TaskHandle>& deps = {}, bool bFailIfNonZero = true) override;
+		virtual TaskHandle				AddBarrier() override;
+		virtual void					SetListener(TaskHandle task, ITaskListener* listener) override;
+		virtual void					SetCache(TaskHandle task, ITaskCache* cache) override;
+		virtual void					SetRemote(TaskHandle task, const SRemoteCommand& remote) override;
+		virtual void					SetOutputFile(TaskHandle task, const std::filesystem::path& path) override;
+		virtual void					SetEstimate(TaskHandle task, uint64_t duration) override;
+		virtual void					SetResources(TaskHandle task, ETaskClass taskClass, uint64_t memory) override;
 		virtual size_t					GetTaskCount() const override;
 
+		/**
+		 * Wake up the scheduler loop (worker thread side)
+		 */
+		void							Notify();
+
 	private:
+		TaskHandle						AddTask(ITask* task, const std::vector<TaskHandle>& deps);
+		void							AddDependency(TaskHandle task, TaskHandle dependency);
+
+		/**
+		 * \returns `true` if `task` waits for `dependency` through any chain of tasks
+		 */
+		bool							IsDependent(TaskHandle task, TaskHandle dependency) const;
+
+		/**
+		 * Push task to the ready queue or complete it right away if there is nothing to execute
+		 */
+		void							MarkReady(TaskHandle handle);
+
+		/**
+		 * Mark task as done and release its dependents
+		 */
+		void							CompleteTask(TaskHandle handle, bool bSuccess);
+
+		/**
+		 * Task of the worker is ended
+		 */
+		void							ReapWorkerTask(SWorker* worker, bool bSuccess);
+
+		/**
+		 * Add timeline event of the task ended on the worker
+		 */
+		void							TraceTask(const SWorker* worker, TaskHandle handle, bool bSuccess) const;
+
+		/**
+		 * Set `STaskNode::priority` of all tasks
+		 */
+		void							UpdatePriorities();
+
+		/**
+		 * Simulate the build with `STaskNode::estimate` durations
+		 * 
+		 * \returns ms
+		 */
+		uint64_t						PredictMakespan() const;
+
 		void							KillWorkerTask(SWorker* worker);
 		void							GiveWorkerTask(SWorker* worker);
 
-		void							ShowCommandStatus(SWorker* worker);
+		/**
+		 * \returns `true` if the task fits the memory budget and the link limit with the running ones
+		 */
+		bool							CanAdmit(const STaskNode& node) const;
+
+		/**
+		 * Sample the pressure of the host, and add or remove active workers (`--adaptive`)
+		 *
+		 * Additive increase while the CPUs are free and tasks wait, multiplicative
+		 * decrease under pressure. Running tasks are not stopped, the limit is applied
+		 * when they end
+		 */
+		void							AdaptWorkers();
+
+		/**
+		 * Give the ended task to the status thread
+		 */
+		void							QueueTaskStatus(SWorker* worker, bool bSuccess);
+
+		/**
+		 * Status thread entry point: output of the ended tasks and the worker lines,
+		 * so the terminal never delays the scheduler loop
+		 */
+		void							RenderRoutine();
+
+		void							ShowCommandStatus(const STaskStatus& status);
 		void							UpdateStatus();
 		bool							CheckRunning() const;
 		char							GetSpinner(const SWorker* worker) const;
+		void							ShowMeasurements(uint64_t wallNs, uint64_t schedulerCpuNs) const;
+
+		std::vector<STaskNode>			m_tasks;
+		std::vector<TaskHandle>			m_ready; /* Heap of `CTaskPriorityLess` */
+		bool							m_bEstimated							= false; /* Some task has an estimate */
+
+		TaskHandle						m_lastBarrier							= DELTAMAKE_TASK_NONE;
+		std::vector<TaskHandle>			m_phase; /* Tasks added after `m_lastBarrier` */
+		std::map<std::string, TaskHandle> m_commands; /* Commands of `m_phase`, same ones are one task */
+
+		std::atomic<size_t>				m_nStarted								= 0;
+		size_t							m_nRunning								= 0;
+		size_t							m_nEnded								= 0;
 
-		std::vector<ITask*>				m_tasks;
-		size_t							m_nextTask								= 0;
+		uint64_t						m_memoryBudget							= 0; /* MiB, `0` for no limit */
+		uint64_t						m_memoryUsed							= 0; /* MiB of the running tasks */
+		size_t							m_nLinks								= 0; /* Running links */
+		size_t							m_nDelayed								= 0; /* Tasks waited for the budget */
+
+		bool							m_bAdaptive								= false; /* `--adaptive` and the pressure can be read */
+		CPressureMonitor				m_pressure;
+		SPressure						m_lastPressure;
+		std::chrono::steady_clock::time_point m_lastSample;
+		std::atomic<size_t>				m_nActive								= 0; /* Workers that may have a task, also read by the status thread */
+		std::atomic<uint32_t>			m_shownPressure							= 0; /* CPU and memory % of the last sample, for the status thread */
+		size_t							m_shownActive							= 0; /* Status thread only, plain mode */
 
 		std::vector<SWorker*>			m_workers;
 
-		ESchedulerStatus				m_status								= ESchedulerStatus::IDLE;
+		std::atomic<ESchedulerStatus>	m_status								= ESchedulerStatus::IDLE; /* Also changed by SIGINT handler */
+
+		/* Status thread only */
 
 		size_t							m_spinnerIndex							= 0;
 		size_t							m_topOffset								= 0;
+		ESchedulerStatus				m_shownStatus							= ESchedulerStatus::RUNNING; /* Plain mode */
+
+		std::thread						m_renderThread;
+		std::mutex						m_renderMutex;
+		std::condition_variable			m_renderEvent;
+		std::vector<STaskStatus>		m_renderQueue;
+		std::vector<STaskStatus>		m_failed; /* Shown at the end (`-k`) */
+		bool							m_bRenderStop							= false;
+
+		std::mutex						m_eventMutex;
+		std::condition_variable			m_event;
+		bool							m_bEvent								= false; /* Some worker has changed its status */
 };
 
+/**
+ * \returns CPU time of the calling thread in ns
+ */
+static uint64_t GetThreadCPUTime();
+
+/**
+ * \returns `MemAvailable` in MiB, `0` if unknown
+ */
+static uint64_t GetAvailableMemory();
+
 CSchedulerLocal g_schedulerLocal;
+CProcessSlots g_localSlots; // Build nodes add workers, but not local cores
 extern DeltaMake::IScheduler* const DeltaMake::scheduler = &g_schedulerLocal;
 
 // ******************************************************************************** //
@@ -281,9 +515,13 @@ CSchedulerLocal::~CSchedulerLocal() {
  * CSchedulerLocal::Init
  */
 void CSchedulerLocal::Init(size_t nWorkers) {
+	g_localSlots.Init((remoteExecutor->IsEnabled() == true) ? config->nCores : 0);
+
 	m_workers.resize(nWorkers);
-	for (size_t i = 0; i < m_workers.size(); ++i)
+	for (size_t i = 0; i < m_workers.size(); ++i) {
 		m_workers[i] = new SWorker();
+		m_workers[i]->index = i;
+	}
 }
 
 /* ****************************************
@@ -296,24 +534,75 @@ ITaskList* CSchedulerLocal::GetList() {
 /* ****************************************
  * CSchedulerLocal::Start
  */
-void CSchedulerLocal::Start() {
+bool CSchedulerLocal::Start() {
 	if (m_tasks.size() == 0) {
 		terminal->Log(LOG_WARNING, "Scheduler task list is empty! Abort start.\n");
-		return;
+		return true;
 	}
 
 	SignalInterruptCatcher::Init();
 
+	for (size_t i = 0; i < m_workers.size(); ++i)
+		trace->SetLaneName(DELTAMAKE_TRACE_MAIN_LANE + 1 + i, "Worker " + std::to_string(i));
+
+	UpdatePriorities();
+	const uint64_t predicted = PredictMakespan();
+
+	m_memoryBudget = (config->memoryLimit != 0) ? config->memoryLimit : static_cast<uint64_t>(GetAvailableMemory() * DELTAMAKE_MEMORY_SHARE);
+	terminal->Log(LOG_DETAIL, "Memory budget: %llu MiB\n", static_cast<unsigned long long>(m_memoryBudget));
+
+	// All workers until the first sample, the pressure before the build is not ours to fix
+	m_nActive = m_workers.size();
+	m_shownActive = m_workers.size();
+	m_shownPressure = 0;
+	m_bAdaptive = false;
+	if (config->nMinWorkers != 0) {
+		m_bAdaptive = m_pressure.Init();
+		if (m_bAdaptive == false)
+			terminal->Log(LOG_WARNING, "Can't read CPU pressure or load. Workers are not adaptive\n");
+		else {
+			terminal->Log(LOG_DETAIL, "Adaptive workers: %zu to %zu by %s\n", config->nMinWorkers, m_workers.size(), (m_pressure.IsPsi() == true) ? "pressure stall information" : "load average");
+			m_lastSample = std::chrono::steady_clock::now();
+		}
+	}
+
+	// Tasks without dependencies are ready from the beginning
+	for (TaskHandle i = 0; i < m_tasks.size(); ++i) {
+		if (m_tasks[i].nPending == 0)
+			MarkReady(i);
+	}
+
+	const auto startTime = std::chrono::steady_clock::now();
+	const uint64_t startCpuTime = GetThreadCPUTime();
+
 	// Start the worker threads
 	for (size_t i = 0; i < m_workers.size(); ++i) {
 		m_workers[i]->thread = std::thread(WorkerRoutine, m_workers[i]);
 	}
 
-	terminal->ShowCursor(false);
+	if (config->bPlain == false)
+		terminal->ShowCursor(false);
+
 	m_status = ESchedulerStatus::RUNNING;
+	m_bRenderStop = false;
+	m_shownStatus = ESchedulerStatus::RUNNING;
+	m_renderThread = std::thread(&CSchedulerLocal::RenderRoutine, this);
+
+	{
+		std::lock_guard<std::mutex> eventLock(m_eventMutex);
+		m_bEvent = true; // Ready tasks are given right away, not after the first timeout
+	}
+
 	while (true) {
-		std::this_thread::sleep_for(std::chrono::milliseconds(DELTAMAKE_SCHEDULER_DELAY)); // Let's not bother the CPU too much
+		// Sleep until some worker is done
+		// Timeout is needed for `Stop()`/`Kill()` from the SIGINT handler
+		{
+			std::unique_lock<std::mutex> eventLock(m_eventMutex);
+			m_event.wait_for(eventLock, std::chrono::milliseconds(DELTAMAKE_SCHEDULER_DELAY), [this]() { return m_bEvent; });
+			m_bEvent = false;
+		}
 
+		// Reap ended tasks first, so their dependents can be given right away
 		size_t nStopped = 0;
 		for (size_t i = 0; i < m_workers.size(); ++i) {
 			SWorker* worker = m_workers[i];
@@ -321,23 +610,22 @@ void CSchedulerLocal::Start() {
 			const EWorkerStatus status = worker->status;
 			switch (status) {
 				case EWorkerStatus::WORKING:
-					if (m_status != ESchedulerStatus::RUNNING) {
-						ITask* task = worker->task;
-						if (task->GetType() == ETaskType::BARRIER)
-							static_cast<CBarrierTask*>(task)->Skip();
-					}
-
 					if (m_status == ESchedulerStatus::KILLING)
 						KillWorkerTask(worker);
 
 					break;
 				
 				case EWorkerStatus::WAIT_TASK:
-					GiveWorkerTask(worker);
+					if (worker->handle != DELTAMAKE_TASK_NONE)
+						ReapWorkerTask(worker, worker->bFailed == false);
+
 					break;
 
 				case EWorkerStatus::FAIL:
-					if (m_status != ESchedulerStatus::STOPPING)
+					if (worker->handle != DELTAMAKE_TASK_NONE)
+						ReapWorkerTask(worker, false);
+
+					if (m_status == ESchedulerStatus::RUNNING)
 						Stop();
 
 					++nStopped;
@@ -352,10 +640,18 @@ void CSchedulerLocal::Start() {
 			}
 		}
 
+		if (m_bAdaptive == true)
+			AdaptWorkers();
+
+		// Let's work the work
+		for (size_t i = 0; i < m_workers.size(); ++i) {
+			SWorker* worker = m_workers[i];
+			if ((worker->status == EWorkerStatus::WAIT_TASK) && (worker->handle == DELTAMAKE_TASK_NONE))
+				GiveWorkerTask(worker);
+		}
+
 		if (nStopped == m_workers.size())
 			break;
-
-		UpdateStatus();
 	}
 
 	// Let's show failed workers' log
@@ -363,13 +659,19 @@ void CSchedulerLocal::Start() {
 		SWorker* worker = m_workers[i];
 		if (worker->status == EWorkerStatus::FAIL) {
 			if (worker->task != nullptr)
-				ShowCommandStatus(worker); // If it is a command task
+				QueueTaskStatus(worker, false); // If it is a command task
 		}
 		else
 			worker->status = EWorkerStatus::STOPPED;
 	}
 
-	UpdateStatus();
+	// All failures of `-k` together, after the output of the other tasks
+	for (size_t i = 0; i < m_failed.size(); ++i) {
+		std::lock_guard<std::mutex> renderLock(m_renderMutex);
+		m_renderQueue.push_back(m_failed[i]);
+	}
+
+	m_renderEvent.notify_one();
 
 	// Wait for everyone to end tasks
 	for (size_t i = 0; i < m_workers.size(); ++i) {
@@ -378,29 +680,84 @@ void CSchedulerLocal::Start() {
 	}
 
 	m_status = ESchedulerStatus::IDLE;
-	UpdateStatus();
 
-	// Clearing
-	for (size_t i = 0; i < m_workers.size(); ++i)
+	// Last status, then the terminal is ours again
+	{
+		std::lock_guard<std::mutex> renderLock(m_renderMutex);
+		m_bRenderStop = true;
+	}
+
+	m_renderEvent.notify_one();
+	m_renderThread.join();
+
+	const uint64_t wallNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+	terminal->Log(
+		(m_bEstimated == true) ? LOG_INFO : LOG_DETAIL, // Prediction without history is just a guess
+		"Makespan: %.2f s predicted, %.2f s actual\n",
+		predicted / 1e3,
+		wallNs / 1e9
+	);
+
+	if (config->bMeasure == true)
+		ShowMeasurements(wallNs, GetThreadCPUTime() - startCpuTime);
+
+	if (m_nDelayed != 0)
+		terminal->Log(LOG_DETAIL, "%zu tasks waited for the memory budget (%llu MiB) or the link limit\n", m_nDelayed, static_cast<unsigned long long>(m_memoryBudget));
+
+	bool bSuccess = true;
+	size_t nFailed = 0;
+	size_t nSkipped = 0; // Waited for a failed one, or stopped
+	for (size_t i = 0; i < m_tasks.size(); ++i) {
+		if (m_tasks[i].state != ETaskState::DONE)
+			bSuccess = false;
+
+		if (m_tasks[i].state == ETaskState::FAILED)
+			++nFailed;
+		else if ((m_tasks[i].state != ETaskState::DONE) && (m_tasks[i].task->GetType() == ETaskType::COMMAND))
+			++nSkipped;
+	}
+
+	if ((config->bKeepGoing == true) && (bSuccess == false))
+		terminal->Log(LOG_ERROR, "%zu tasks failed, %zu not executed, %zu done\n", nFailed, nSkipped, m_nEnded);
+
+	// Clearing, the workers are ready for the next start (`--watch`)
+	for (size_t i = 0; i < m_workers.size(); ++i) {
 		delete m_workers[i];
+		m_workers[i] = new SWorker();
+		m_workers[i]->index = i;
+	}
 
 	for (size_t i = 0; i < m_tasks.size(); ++i)
-		delete m_tasks[i];
+		delete m_tasks[i].task;
 
-	m_workers.clear();
 	m_tasks.clear();
-	m_nextTask = 0;
+	m_ready.clear();
+	m_bEstimated = false;
+	m_phase.clear();
+	m_commands.clear();
+	m_failed.clear();
+	m_lastBarrier = DELTAMAKE_TASK_NONE;
+	m_nStarted = 0;
+	m_nRunning = 0;
+	m_nEnded = 0;
+	m_memoryUsed = 0;
+	m_nLinks = 0;
+	m_nDelayed = 0;
 
 	// Restoring
-	terminal->ShowCursor(true);
+	SignalInterruptCatcher::Restore();
+
+	if (config->bPlain == false)
+		terminal->ShowCursor(true);
+
+	return bSuccess;
 }
 
 /* ****************************************
  * CSchedulerLocal::Stop
  */
 void CSchedulerLocal::Stop() {
-	m_status = ESchedulerStatus::STOPPING;
-	m_nextTask = m_tasks.size(); // Yeap, like this
+	m_status = ESchedulerStatus::STOPPING; // No new tasks will be given
 }
 
 /* ****************************************
@@ -412,20 +769,47 @@ void CSchedulerLocal::Kill() {
 	m_status = ESchedulerStatus::KILLING;
 }
 
+/* ****************************************
+ * CSchedulerLocal::Notify
+ */
+void CSchedulerLocal::Notify() {
+	{
+		std::lock_guard<std::mutex> eventLock(m_eventMutex);
+		m_bEvent = true;
+	}
+
+	m_event.notify_one();
+}
+
 /* ****************************************
  * CSchedulerLocal::ShowCommandStatus
  */
-void CSchedulerLocal::ShowCommandStatus(SWorker* worker) { // TODO: Enhance cleaning to reduce flickering
-	if (worker->task == nullptr)
-		return;
+void CSchedulerLocal::ShowCommandStatus(const STaskStatus& status) { // TODO: Enhance cleaning to reduce flickering
+	const CCommandTask* command = static_cast<const CCommandTask*>(status.task);
+	const std::string& rOut = command->GetOutBuffer();
+	const std::string& rErr = command->GetErrBuffer();
+
+	if (config->bPlain == true) { // Line per task, no cursor magic
+		if (status.index != 0)
+			terminal->Log(LOG_INFO, "[%3zu/%-3zu] %s (%.2f s%s)\n", status.index, m_tasks.size(), command->GetTitle(), status.duration / 1e3, (status.bCached == true) ? ", cached" : "");
+		else
+			terminal->Log(LOG_ERROR, "[ FAILED  ] %s\n", command->GetTitle());
 
-	if (worker->task->GetType() != ETaskType::COMMAND)
-		return;
+		if (rOut.length() != 0) {
+			terminal->Log(LOG_INFO, "%s | %s", command->GetTitle(), rOut.c_str());
+			if (rOut[rOut.size() - 1] != '\n')
+				terminal->Write("\n");
+		}
+
+		if (rErr.length() != 0) {
+			terminal->Log(LOG_ERROR, "%s | %s", command->GetTitle(), rErr.c_str());
+			if (rErr[rErr.size() - 1] != '\n')
+				terminal->Write("\n");
+		}
 
-	const CCommandTask* command = static_cast<CCommandTask*>(worker->task);
-	const CProcess& process = command->GetProcess();
-	const std::string& rOut = process.GetOutBuffer();
-	const std::string& rErr = process.GetErrBuffer();
+		terminal->Flush();
+		return;
+	}
 
 	if ((rOut.length() == 0) && (rErr.length() == 0))
 		return;
@@ -473,14 +857,50 @@ void CSchedulerLocal::ShowCommandStatus(SWorker* worker) { // TODO: Enhance clea
 /* ****************************************
  * CSchedulerLocal::AddCommand
  */
-void CSchedulerLocal::AddCommand(const char title[], const std::string& command, bool bFailIfNonZero) {
+TaskHandle CSchedulerLocal::AddCommand(const char title[], const std::string& command, const std::vector<TaskHandle>& deps, bool bFailIfNonZero) {
 	if (CheckRunning() == true)
-		return;
+		return DELTAMAKE_TASK_NONE;
+
+	// Builds and sub solutions with the same sources and flags ask for the same compile, it's executed once
+	const std::string key = std::string((bFailIfNonZero == true) ? "1" : "0") + command;
+	auto same = m_commands.find(key);
+	if (same != m_commands.end()) {
+		const TaskHandle shared = same->second;
+
+		// Dependencies are added tasks, so the shared one can wait for them, unless they wait for it
+		for (size_t i = 0; i < deps.size(); ++i) {
+			if ((deps[i] == DELTAMAKE_TASK_NONE) || (deps[i] >= m_tasks.size()))
+				continue; // Ignored by `AddTask()` too
+
+			if ((deps[i] == shared) || (IsDependent(deps[i], shared) == true)) {
+				terminal->Log(LOG_ERROR, "%s:\n\tSame command as \"%s\", but it needs a task that waits for it\n", title, m_tasks[shared].task->GetTitle());
+				return DELTAMAKE_TASK_NONE;
+			}
+		}
 
-	ITask* task = new CCommandTask(title, command, bFailIfNonZero);
-	m_tasks.push_back(task);
+		for (size_t i = 0; i < deps.size(); ++i) {
+			if ((deps[i] == DELTAMAKE_TASK_NONE) || (deps[i] >= m_tasks.size())) {
+				if (deps[i] != DELTAMAKE_TASK_NONE)
+					terminal->Log(LOG_WARNING, "Task \"%s\" has invalid dependency (%zu). Ignoring...\n", title, deps[i]);
+
+				continue;
+			}
+
+			const std::vector<TaskHandle>& dependents = m_tasks[deps[i]].dependents;
+			if (std::find(dependents.begin(), dependents.end(), shared) == dependents.end())
+				AddDependency(shared, deps[i]);
+		}
+
+		terminal->Log(LOG_DETAIL, "%s:\n\tSame command as \"%s\", shared\n", title, m_tasks[shared].task->GetTitle());
+		return shared;
+	}
+
+	const TaskHandle handle = AddTask(new CCommandTask(title, command, bFailIfNonZero), deps);
+	m_commands[key] = handle;
 
 	terminal->Log(LOG_DETAIL, "%s:\n\t%s\n", title, command.c_str());
+
+	return handle;
 }
 
 /* ****************************************
@@ -493,75 +913,591 @@ size_t CSchedulerLocal::GetTaskCount() const {
 /* ****************************************
  * CSchedulerLocal::AddBarrier
  */
-void CSchedulerLocal::AddBarrier() {
+TaskHandle CSchedulerLocal::AddBarrier() {
 	if (CheckRunning() == true)
-		return;
+		return DELTAMAKE_TASK_NONE;
+
+	const TaskHandle handle = m_tasks.size();
+	m_tasks.emplace_back();
+	m_tasks[handle].task = new CBarrierTask();
+
+	// Tasks of the phase already wait for the previous barrier
+	for (size_t i = 0; i < m_phase.size(); ++i)
+		AddDependency(handle, m_phase[i]);
+
+	if ((m_phase.size() == 0) && (m_lastBarrier != DELTAMAKE_TASK_NONE))
+		AddDependency(handle, m_lastBarrier);
 
-	ITask* task = new CBarrierTask(m_workers.size());
-	m_tasks.push_back(task);
+	m_phase.clear();
+	m_commands.clear(); // Later ones must wait for the barrier
+	m_lastBarrier = handle;
 
 	terminal->Log(LOG_DETAIL, DELTAMAKE_BARRIER_TITLE "\n");
+
+	return handle;
 }
 
 /* ****************************************
- * CSchedulerLocal::KillWorkerTask
+ * CSchedulerLocal::SetListener
  */
-inline void CSchedulerLocal::KillWorkerTask(SWorker* worker) {
-	std::lock_guard<std::mutex> workerLock(worker->mutex);
-
-	ITask* task = worker->task;
-	if (task->GetType() == ETaskType::COMMAND)
-		static_cast<CCommandTask*>(task)->KillProcess();
+void CSchedulerLocal::SetListener(TaskHandle task, ITaskListener* listener) {
+	if (task >= m_tasks.size())
+		return;
 
-	worker->status = EWorkerStatus::FAIL;
+	std::vector<ITaskListener*>& rListeners = m_tasks[task].listeners;
+	if (listener == nullptr)
+		rListeners.clear();
+	else if (std::find(rListeners.begin(), rListeners.end(), listener) == rListeners.end())
+		rListeners.push_back(listener);
 }
 
 /* ****************************************
- * CSchedulerLocal::GiveWorkerTask
+ * CSchedulerLocal::SetCache
  */
-void CSchedulerLocal::GiveWorkerTask(SWorker* worker) {
-	if (m_nextTask == m_tasks.size()) { // No task left
-		worker->task = nullptr;
-	}
-	else {
-		ITask* current = m_tasks[m_nextTask];
-
-		ShowCommandStatus(worker); // Let's show log of previous command task
-		
-		// Let's work the work
-		{
-			std::lock_guard<std::mutex> workerLock(worker->mutex);
-			worker->task = ((m_nextTask != m_tasks.size()) ? m_tasks[m_nextTask] : nullptr);
-		}
+void CSchedulerLocal::SetCache(TaskHandle task, ITaskCache* cache) {
+	if ((task >= m_tasks.size()) || (m_tasks[task].task->GetType() != ETaskType::COMMAND))
+		return;
 
-		if (current->GetType() == ETaskType::BARRIER) {
-			CBarrierTask* barrier = static_cast<CBarrierTask*>(current);
+	static_cast<CCommandTask*>(m_tasks[task].task)->SetCache(cache, task);
+}
 
-			if (barrier->IsDone() == true) // Next task only after all workers are waited
-				++m_nextTask;
-		}
-		else {
-			++m_nextTask; // Or just because task is not a barrier
-		}
-	}
+/* ****************************************
+ * CSchedulerLocal::SetRemote
+ */
+void CSchedulerLocal::SetRemote(TaskHandle task, const SRemoteCommand& remote) {
+	if ((task >= m_tasks.size()) || (m_tasks[task].task->GetType() != ETaskType::COMMAND))
+		return;
 
-	worker->status = EWorkerStatus::WORKING;
+	static_cast<CCommandTask*>(m_tasks[task].task)->SetRemote(remote);
 }
 
 /* ****************************************
- * CSchedulerLocal::UpdateStatus
+ * CSchedulerLocal::SetOutputFile
  */
-inline void CSchedulerLocal::UpdateStatus() {
-	++m_spinnerIndex; // Get rotated
+void CSchedulerLocal::SetOutputFile(TaskHandle task, const std::filesystem::path& path) {
+	if ((task >= m_tasks.size()) || (m_tasks[task].task->GetType() != ETaskType::COMMAND))
+		return;
 
-	terminal->UpdateSize();
+	static_cast<CCommandTask*>(m_tasks[task].task)->SetOutputFile(path);
+}
 
-	const size_t nWorkers			= m_workers.size();
+/* ****************************************
+ * CSchedulerLocal::SetEstimate
+ */
+void CSchedulerLocal::SetEstimate(TaskHandle task, uint64_t duration) {
+	if (task >= m_tasks.size())
+		return;
+
+	m_tasks[task].estimate = duration;
+	m_bEstimated = true;
+}
+
+/* ****************************************
+ * CSchedulerLocal::SetResources
+ */
+void CSchedulerLocal::SetResources(TaskHandle task, ETaskClass taskClass, uint64_t memory) {
+	if (task >= m_tasks.size())
+		return;
+
+	m_tasks[task].taskClass = taskClass;
+	m_tasks[task].memory = memory;
+}
+
+/* ****************************************
+ * CSchedulerLocal::AddTask
+ */
+TaskHandle CSchedulerLocal::AddTask(ITask* task, const std::vector<TaskHandle>& deps) {
+	const TaskHandle handle = m_tasks.size();
+	m_tasks.emplace_back();
+	m_tasks[handle].task = task;
+
+	if (m_lastBarrier != DELTAMAKE_TASK_NONE)
+		AddDependency(handle, m_lastBarrier);
+
+	for (size_t i = 0; i < deps.size(); ++i) {
+		if (deps[i] == DELTAMAKE_TASK_NONE)
+			continue; // Dependency was not added, nothing to wait
+
+		if (deps[i] >= handle) { // Only already added tasks, shared commands check their cycles themselves
+			terminal->Log(LOG_WARNING, "Task \"%s\" has invalid dependency (%zu). Ignoring...\n", task->GetTitle(), deps[i]);
+			continue;
+		}
+
+		AddDependency(handle, deps[i]);
+	}
+
+	m_phase.push_back(handle);
+
+	return handle;
+}
+
+/* ****************************************
+ * CSchedulerLocal::AddDependency
+ */
+inline void CSchedulerLocal::AddDependency(TaskHandle task, TaskHandle dependency) {
+	m_tasks[dependency].dependents.push_back(task);
+	++m_tasks[task].nPending;
+}
+
+/* ****************************************
+ * CSchedulerLocal::IsDependent
+ */
+bool CSchedulerLocal::IsDependent(TaskHandle task, TaskHandle dependency) const {
+	std::vector<TaskHandle> stack = { dependency };
+	std::vector<bool> visited(m_tasks.size(), false);
+	visited[dependency] = true;
+
+	while (stack.size() != 0) {
+		const TaskHandle handle = stack.back();
+		stack.pop_back();
+
+		const std::vector<TaskHandle>& dependents = m_tasks[handle].dependents;
+		for (size_t i = 0; i < dependents.size(); ++i) {
+			if (dependents[i] == task)
+				return true;
+
+			if (visited[dependents[i]] == false) {
+				visited[dependents[i]] = true;
+				stack.push_back(dependents[i]);
+			}
+		}
+	}
+
+	return false;
+}
+
+/* ****************************************
+ * CSchedulerLocal::MarkReady
+ */
+void CSchedulerLocal::MarkReady(TaskHandle handle) {
+	STaskNode& node = m_tasks[handle];
+
+	if (node.task->GetType() == ETaskType::BARRIER) { // Nothing to wait anymore
+		++m_nStarted;
+		CompleteTask(handle, true);
+		return;
+	}
+
+	node.state = ETaskState::READY;
+	if (trace->IsEnabled() == true)
+		node.readyTime = trace->GetTime();
+
+	m_ready.push_back(handle);
+	std::push_heap(m_ready.begin(), m_ready.end(), CTaskPriorityLess(&m_tasks));
+}
+
+/* ****************************************
+ * CSchedulerLocal::CompleteTask
+ */
+void CSchedulerLocal::CompleteTask(TaskHandle handle, bool bSuccess) {
+	m_tasks[handle].state = (bSuccess == true) ? ETaskState::DONE : ETaskState::FAILED;
+	if (bSuccess == false)
+		return; // Dependents will never be ready
+
+	const std::vector<TaskHandle>& dependents = m_tasks[handle].dependents;
+	for (size_t i = 0; i < dependents.size(); ++i) {
+		STaskNode& dependent = m_tasks[dependents[i]];
+
+		--dependent.nPending;
+		if (dependent.nPending == 0)
+			MarkReady(dependents[i]);
+	}
+}
+
+/* ****************************************
+ * CSchedulerLocal::ReapWorkerTask
+ */
+void CSchedulerLocal::ReapWorkerTask(SWorker* worker, bool bSuccess) {
+	const TaskHandle handle = worker->handle;
+	worker->handle = DELTAMAKE_TASK_NONE;
+	--m_nRunning;
+
+	m_memoryUsed -= m_tasks[handle].memory;
+	if (m_tasks[handle].taskClass == ETaskClass::LINK)
+		--m_nLinks;
+
+	if (trace->IsEnabled() == true)
+		TraceTask(worker, handle, bSuccess);
+
+	const std::vector<ITaskListener*>& listeners = m_tasks[handle].listeners;
+	if (listeners.size() != 0) {
+		STaskResult result;
+		result.bSuccess = bSuccess;
+		result.bCached = false;
+		result.returnValue = -1;
+		result.startTime = worker->startTime;
+		result.duration = worker->duration;
+		result.maxRSS = 0;
+
+		if (worker->task->GetType() == ETaskType::COMMAND) {
+			result.returnValue = static_cast<CCommandTask*>(worker->task)->GetReturnValue();
+			result.bCached = static_cast<CCommandTask*>(worker->task)->IsCached();
+			result.maxRSS = static_cast<CCommandTask*>(worker->task)->GetProcess().GetMaxRSS();
+		}
+
+		for (size_t i = 0; i < listeners.size(); ++i)
+			listeners[i]->OnTaskDone(handle, result);
+	}
+
+	CompleteTask(handle, bSuccess);
+
+	if ((bSuccess == false) && (config->bKeepGoing == true)) { // The worker goes on, the task is deleted by `Start()`
+		worker->bFailed = false;
+
+		if (worker->task->GetType() == ETaskType::COMMAND) {
+			STaskStatus status;
+			status.task = worker->task;
+			status.index = 0;
+			status.duration = worker->duration;
+			status.bCached = false;
+			m_failed.push_back(status);
+		}
+	}
+	else if (bSuccess == false)
+		return; // Failed task log is shown at the end
+	else
+		QueueTaskStatus(worker, true); // Let's show log of the command task
+
+	std::lock_guard<std::mutex> workerLock(worker->mutex);
+	worker->task = nullptr;
+}
+
+/* ****************************************
+ * CSchedulerLocal::QueueTaskStatus
+ */
+void CSchedulerLocal::QueueTaskStatus(SWorker* worker, bool bSuccess) {
+	if (worker->task->GetType() != ETaskType::COMMAND)
+		return;
+
+	STaskStatus status;
+	status.task = worker->task;
+	status.index = (bSuccess == true) ? ++m_nEnded : 0;
+	status.duration = worker->duration;
+	status.bCached = static_cast<CCommandTask*>(worker->task)->IsCached();
+
+	{
+		std::lock_guard<std::mutex> renderLock(m_renderMutex);
+		m_renderQueue.push_back(status);
+	}
+
+	m_renderEvent.notify_one();
+}
+
+/* ****************************************
+ * CSchedulerLocal::RenderRoutine
+ */
+void CSchedulerLocal::RenderRoutine() {
+#if defined(__linux__)
+	setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), DELTAMAKE_RENDER_NICE); // Only this thread on Linux
+#endif
+
+	std::vector<STaskStatus> statuses;
+	auto lastUpdate = std::chrono::steady_clock::now();
+	while (true) {
+		bool bStop;
+		{
+			std::unique_lock<std::mutex> renderLock(m_renderMutex);
+			m_renderEvent.wait_for(renderLock, std::chrono::milliseconds(DELTAMAKE_SCHEDULER_DELAY), [this]() { return (m_bRenderStop == true) || (m_renderQueue.size() != 0); });
+
+			statuses.swap(m_renderQueue);
+			bStop = m_bRenderStop;
+		}
+
+		terminal->Lock(); // Logs of the scheduler thread go after the redraw
+
+		for (size_t i = 0; i < statuses.size(); ++i)
+			ShowCommandStatus(statuses[i]);
+
+		statuses.clear();
+
+		const auto now = std::chrono::steady_clock::now();
+		if ((bStop == true) || (now - lastUpdate >= std::chrono::milliseconds(DELTAMAKE_SCHEDULER_DELAY))) { // Don't redraw on every task
+			lastUpdate = now;
+			UpdateStatus();
+		}
+
+		terminal->Unlock();
+
+		if (bStop == true)
+			break;
+	}
+}
+
+/* ****************************************
+ * CSchedulerLocal::TraceTask
+ */
+void CSchedulerLocal::TraceTask(const SWorker* worker, TaskHandle handle, bool bSuccess) const {
+	const uint64_t begin = worker->traceBegin;
+	uint64_t end = worker->traceEnd;
+	if (end < begin) // Killed, it's still running
+		end = trace->GetTime();
+
+	Json::Value args;
+	args["worker"] = static_cast<Json::UInt64>(worker->index);
+	args["queue_wait_us"] = static_cast<Json::UInt64>((begin > m_tasks[handle].readyTime) ? (begin - m_tasks[handle].readyTime) : 0);
+	args["success"] = bSuccess;
+
+	const char* category = "task";
+	if (worker->task->GetType() == ETaskType::COMMAND) {
+		const CCommandTask* command = static_cast<const CCommandTask*>(worker->task);
+		category = (command->IsCached() == true) ? "cached" : ((command->IsRemote() == true) ? "remote" : "local");
+
+		args["exit_code"] = command->GetReturnValue();
+		args["max_rss_kib"] = static_cast<Json::UInt64>(command->GetProcess().GetMaxRSS());
+		args["output_bytes"] = static_cast<Json::UInt64>(command->GetOutputSize());
+	}
+
+	trace->AddEvent(worker->task->GetTitle(), category, DELTAMAKE_TRACE_MAIN_LANE + 1 + worker->index, begin, end, args);
+}
+
+/* ****************************************
+ * CSchedulerLocal::UpdatePriorities
+ */
+void CSchedulerLocal::UpdatePriorities() {
+	// Shared commands can wait for later tasks, so the order of the handles is not enough
+	std::vector<size_t> nPending(m_tasks.size());
+	std::vector<TaskHandle> order;
+	order.reserve(m_tasks.size());
+
+	for (TaskHandle i = 0; i < m_tasks.size(); ++i) {
+		nPending[i] = m_tasks[i].nPending;
+		if (nPending[i] == 0)
+			order.push_back(i);
+	}
+
+	for (size_t i = 0; i < order.size(); ++i) {
+		const std::vector<TaskHandle>& dependents = m_tasks[order[i]].dependents;
+		for (size_t j = 0; j < dependents.size(); ++j) {
+			if (--nPending[dependents[j]] == 0)
+				order.push_back(dependents[j]);
+		}
+	}
+
+	for (size_t i = order.size(); i-- > 0;) {
+		STaskNode& node = m_tasks[order[i]];
+
+		uint64_t longest = 0;
+		for (size_t j = 0; j < node.dependents.size(); ++j)
+			longest = std::max(longest, m_tasks[node.dependents[j]].priority);
+
+		node.priority = node.estimate + longest;
+	}
+}
+
+/* ****************************************
+ * CSchedulerLocal::PredictMakespan
+ */
+uint64_t CSchedulerLocal::PredictMakespan() const {
+	typedef std::pair<uint64_t, TaskHandle> TEvent; // { end time, task }
+
+	const CTaskPriorityLess less(&m_tasks);
+	std::vector<size_t> nPending(m_tasks.size());
+	std::vector<TaskHandle> ready;
+	std::priority_queue<TEvent, std::vector<TEvent>, std::greater<TEvent>> running;
+
+	for (TaskHandle i = 0; i < m_tasks.size(); ++i) {
+		nPending[i] = m_tasks[i].nPending;
+		if (nPending[i] == 0)
+			ready.push_back(i);
+	}
+
+	std::make_heap(ready.begin(), ready.end(), less);
+
+	uint64_t time = 0;
+	size_t nFree = m_workers.size();
+	while ((ready.size() != 0) || (running.size() != 0)) {
+		while ((nFree != 0) && (ready.size() != 0)) {
+			std::pop_heap(ready.begin(), ready.end(), less);
+			const TaskHandle handle = ready.back();
+			ready.pop_back();
+
+			running.push(TEvent(time + m_tasks[handle].estimate, handle));
+			--nFree;
+		}
+
+		const TEvent event = running.top();
+		running.pop();
+		time = event.first;
+		++nFree;
+
+		const std::vector<TaskHandle>& dependents = m_tasks[event.second].dependents;
+		for (size_t i = 0; i < dependents.size(); ++i) {
+			if (--nPending[dependents[i]] == 0) {
+				ready.push_back(dependents[i]);
+				std::push_heap(ready.begin(), ready.end(), less);
+			}
+		}
+	}
+
+	return time;
+}
+
+/* ****************************************
+ * CSchedulerLocal::KillWorkerTask
+ */
+inline void CSchedulerLocal::KillWorkerTask(SWorker* worker) {
+	std::lock_guard<std::mutex> workerLock(worker->mutex);
+
+	ITask* task = worker->task;
+	if (task->GetType() == ETaskType::COMMAND)
+		static_cast<CCommandTask*>(task)->KillProcess();
+
+	worker->status = EWorkerStatus::FAIL;
+}
+
+/* ****************************************
+ * CSchedulerLocal::GiveWorkerTask
+ */
+void CSchedulerLocal::GiveWorkerTask(SWorker* worker) {
+	if ((m_status == ESchedulerStatus::RUNNING) && (m_nRunning >= m_nActive))
+		return; // Inactive one (`--adaptive`), a running task ends and gives it back
+
+	ITask* task = nullptr; // `nullptr` stops the worker
+	std::vector<TaskHandle> deferred; // Ready, but too heavy right now
+
+	while ((m_status == ESchedulerStatus::RUNNING) && (m_ready.size() != 0) && (deferred.size() < DELTAMAKE_ADMISSION_SCAN)) {
+		std::pop_heap(m_ready.begin(), m_ready.end(), CTaskPriorityLess(&m_tasks));
+		const TaskHandle handle = m_ready.back();
+		m_ready.pop_back();
+
+		STaskNode& node = m_tasks[handle];
+		if (CanAdmit(node) == false) { // Lighter ones with lower priority may fit
+			if (node.bDelayed == false) {
+				node.bDelayed = true;
+				++m_nDelayed;
+			}
+
+			deferred.push_back(handle);
+			continue;
+		}
+
+		++m_nStarted;
+
+		bool bNeeded = (node.listeners.size() == 0);
+		for (size_t i = 0; i < node.listeners.size(); ++i) {
+			if (node.listeners[i]->OnTaskReady(handle) == true)
+				bNeeded = true;
+		}
+
+		if (bNeeded == false) { // Not needed anymore
+			CompleteTask(handle, true);
+			continue;
+		}
+
+		node.state = ETaskState::RUNNING;
+		task = node.task;
+
+		worker->handle = handle;
+		++m_nRunning;
+
+		m_memoryUsed += node.memory;
+		if (node.taskClass == ETaskClass::LINK)
+			++m_nLinks;
+
+		break;
+	}
+
+	for (size_t i = 0; i < deferred.size(); ++i) {
+		m_ready.push_back(deferred[i]);
+		std::push_heap(m_ready.begin(), m_ready.end(), CTaskPriorityLess(&m_tasks));
+	}
+
+	if ((task == nullptr) && (m_status == ESchedulerStatus::RUNNING) && (m_nRunning != 0))
+		return; // Running tasks may release new ones, so keep waiting
+
+	std::lock_guard<std::mutex> workerLock(worker->mutex);
+	worker->task = task;
+	worker->status = EWorkerStatus::WORKING;
+	worker->wakeup.notify_one();
+}
+
+/* ****************************************
+ * CSchedulerLocal::CanAdmit
+ */
+bool CSchedulerLocal::CanAdmit(const STaskNode& node) const {
+	if ((node.taskClass == ETaskClass::LINK) && (config->nLinkJobs != 0) && (m_nLinks >= config->nLinkJobs))
+		return false;
+
+	if ((m_memoryBudget == 0) || (m_nRunning == 0)) // Alone it's executed anyway
+		return true;
+
+	return m_memoryUsed + node.memory <= m_memoryBudget;
+}
+
+/* ****************************************
+ * CSchedulerLocal::AdaptWorkers
+ */
+void CSchedulerLocal::AdaptWorkers() {
+	const auto now = std::chrono::steady_clock::now();
+	if (now - m_lastSample < std::chrono::milliseconds(DELTAMAKE_ADAPTIVE_PERIOD))
+		return;
+
+	m_lastSample = now;
+	if (m_pressure.Sample(m_lastPressure) == false)
+		return;
+
+	const size_t active = m_nActive;
+	const bool bStarved = (m_ready.size() != 0) && (m_nRunning >= active);
+	const size_t next = CPressureMonitor::GetWorkers(m_lastPressure, active, config->nMinWorkers, m_workers.size(), bStarved);
+
+	const uint32_t cpu = static_cast<uint32_t>(m_lastPressure.cpu * 100.0 + 0.5);
+	const uint32_t memory = static_cast<uint32_t>(m_lastPressure.memory * 100.0 + 0.5);
+	m_shownPressure = (cpu << 16) | memory;
+
+	if (trace->IsEnabled() == true) {
+		Json::Value values;
+		values["active"] = static_cast<Json::UInt64>(next);
+		values["running"] = static_cast<Json::UInt64>(m_nRunning);
+		values["cpu_pressure"] = cpu;
+		values["memory_pressure"] = memory;
+		trace->AddCounter("Workers", trace->GetTime(), values);
+	}
+
+	if (next == active)
+		return;
+
+	terminal->Log(LOG_DETAIL, "Workers: %zu -> %zu (CPU pressure %u%%, memory %u%%)\n", active, next, cpu, memory);
+	m_nActive = next;
+}
+
+/* ****************************************
+ * CSchedulerLocal::UpdateStatus
+ */
+inline void CSchedulerLocal::UpdateStatus() {
+	if (config->bPlain == true) { // Only changes of the state
+		const size_t active = m_nActive;
+		if ((m_bAdaptive == true) && (active != m_shownActive) && (m_status == ESchedulerStatus::RUNNING)) {
+			m_shownActive = active;
+
+			const uint32_t pressure = m_shownPressure;
+			terminal->Log(LOG_INFO, "Workers: %zu of %zu (CPU pressure %u%%, memory %u%%)\n", active, m_workers.size(), pressure >> 16, pressure & 0xFFFF);
+			terminal->Flush();
+		}
+
+		const ESchedulerStatus status = m_status;
+		if (status == m_shownStatus)
+			return;
+
+		m_shownStatus = status;
+		if (status == ESchedulerStatus::STOPPING)
+			terminal->Log(LOG_INFO, "Stopping workers...\n");
+		else if (status == ESchedulerStatus::KILLING)
+			terminal->Log(LOG_INFO, "Zat vas doctor-assisted homicide!\n");
+
+		terminal->Flush();
+		return;
+	}
+
+	++m_spinnerIndex; // Get rotated
+
+	terminal->UpdateSize();
+
+	const size_t nWorkers			= m_workers.size();
 	const size_t columns			= terminal->GetColumns();
 	const size_t minWorkerSize		= 4 + DELTAMAKE_MIN_WORKER_TITLE; // `[X] ` + title
-	const size_t maxWorkersInLine	= columns / minWorkerSize;
+	const size_t maxWorkersInLine	= std::max<size_t>(columns / minWorkerSize, 1); // Narrow terminal
 	const size_t nWorkerLines		= nWorkers / maxWorkersInLine + ((nWorkers % maxWorkersInLine != 0) ? 1 : 0) + 1; // Workers + status
-	const size_t maxTitleSize		= DELTAMAKE_MIN_WORKER_TITLE + (columns - maxWorkersInLine * minWorkerSize) / maxWorkersInLine;
+	const size_t maxTitleSize		= DELTAMAKE_MIN_WORKER_TITLE + ((columns > maxWorkersInLine * minWorkerSize) ? (columns - maxWorkersInLine * minWorkerSize) / maxWorkersInLine : 0);
 
 	if (nWorkerLines > m_topOffset) { // Add lines to fit
 		const size_t n = nWorkerLines - m_topOffset;
@@ -608,7 +1544,12 @@ inline void CSchedulerLocal::UpdateStatus() {
 			terminal->Log(LOG_INFO, "Ready.\n\r");
 			break;
 		case ESchedulerStatus::RUNNING:
-			terminal->Log(LOG_INFO, "[%3zu/%-3zu]\n\r", m_nextTask, m_tasks.size());
+			if (m_bAdaptive == true) {
+				const uint32_t pressure = m_shownPressure;
+				terminal->Log(LOG_INFO, "[%3zu/%-3zu] Workers: %zu of %zu (CPU pressure %u%%, memory %u%%)\n\r", m_nStarted.load(), m_tasks.size(), m_nActive.load(), m_workers.size(), pressure >> 16, pressure & 0xFFFF);
+			}
+			else
+				terminal->Log(LOG_INFO, "[%3zu/%-3zu]\n\r", m_nStarted.load(), m_tasks.size());
 			break;
 		case ESchedulerStatus::STOPPING:
 			terminal->Log(LOG_INFO, "Stopping workers...\n\r");
@@ -653,14 +1594,36 @@ inline char CSchedulerLocal::GetSpinner(const SWorker* worker) const {
 	}
 }
 
-// ******************************************************************************** //
-
 /* ****************************************
- * CBarrierTask::CBarrierTask
+ * CSchedulerLocal::ShowMeasurements
  */
-CBarrierTask::CBarrierTask(int value) : m_value(value) {
+void CSchedulerLocal::ShowMeasurements(uint64_t wallNs, uint64_t schedulerCpuNs) const {
+	SWorkerStats total;
+	for (size_t i = 0; i < m_workers.size(); ++i) {
+		const SWorkerStats& stats = m_workers[i]->stats;
+
+		total.nDispatches += stats.nDispatches;
+		total.idleNs += stats.idleNs;
+		total.latencyNs += stats.latencyNs;
+		total.cpuNs += stats.cpuNs;
+		if (stats.maxLatencyNs > total.maxLatencyNs)
+			total.maxLatencyNs = stats.maxLatencyNs;
+	}
+
+	const double avgLatency = (total.nDispatches != 0) ? (total.latencyNs / 1e6) / total.nDispatches : 0.0;
+	const double idleShare = (wallNs != 0) ? 100.0 * total.idleNs / (static_cast<double>(wallNs) * m_workers.size()) : 0.0;
+
+	terminal->Log(LOG_INFO, "Measurements:\n");
+	terminal->Log(LOG_INFO, "\tWall time:         %.3f ms\n", wallNs / 1e6);
+	terminal->Log(LOG_INFO, "\tDispatches:        %zu\n", total.nDispatches);
+	terminal->Log(LOG_INFO, "\tDispatch latency:  %.3f ms avg, %.3f ms max\n", avgLatency, total.maxLatencyNs / 1e6);
+	terminal->Log(LOG_INFO, "\tIdle wall time:    %.3f ms (%.1f%% of %zu workers)\n", total.idleNs / 1e6, idleShare, m_workers.size());
+	terminal->Log(LOG_INFO, "\tWorker CPU time:   %.3f ms (spawn and output of the tasks, not their processes)\n", total.cpuNs / 1e6);
+	terminal->Log(LOG_INFO, "\tScheduler CPU:     %.3f ms\n", schedulerCpuNs / 1e6);
 }
 
+// ******************************************************************************** //
+
 /* ****************************************
  * CBarrierTask::GetTitle
  */
@@ -679,30 +1642,7 @@ ETaskType CBarrierTask::GetType() const {
  * CBarrierTask::Execute
  */
 bool CBarrierTask::Execute() {
-	++m_counter; // Another one in the loop
-
-	// The scheduler will set `m_value` to the number of workers so wait until all workers are waiting
-	while (m_counter < m_value) {
-		std::this_thread::sleep_for(std::chrono::milliseconds(DELTAMAKE_BARRIER_DELAY));
-		// Let's do nothing... or some sort of nothing
-		// After all, synchronization is the scheduler's problem
-	}
-
-	return true; // But the nothing executed good
-}
-
-/* ****************************************
- * CBarrierTask::Skip
- */
-void CBarrierTask::Skip() {
-	m_counter = m_value;
-}
-
-/* ****************************************
- * CBarrierTask::IsDone
- */
-bool CBarrierTask::IsDone() const {
-	return m_counter == m_value;
+	return true; // Let's do nothing... or some sort of nothing
 }
 
 // ******************************************************************************** //
@@ -711,7 +1651,11 @@ bool CBarrierTask::IsDone() const {
  * CCommandTask::CCommandTask
  */
 CCommandTask::CCommandTask(const char title[], const std::string& command, bool bFailIfNonZero) :
-	m_title(title), m_command(command), m_bFailIfNonZero(bFailIfNonZero) { }
+	m_title(title), m_command(command), m_bFailIfNonZero(bFailIfNonZero) {
+	// Most of commands are `compiler flags... file`, one `/bin/sh` less for each of them
+	if (CProcess::SplitCommand(m_command, m_args) == false)
+		m_args.clear();
+}
 
 /* ****************************************
  * CCommandTask::GetTitle
@@ -731,12 +1675,26 @@ ETaskType CCommandTask::GetType() const {
  * CCommandTask::Execute
  */
 bool CCommandTask::Execute() {
-	// Once upon a time, an implementation with `popen()` was used
-	// But it was not perfect enough for me
+	m_bCached = false;
+	m_bRemote = false;
+	if ((m_cache != nullptr) && (m_cache->Fetch(m_handle) == true)) { // No process at all
+		m_bCached = true;
+		m_returnValue = 0;
+		return true;
+	}
 
-	if (m_process.Exec(m_command.c_str(), m_returnValue) == false)
+	if ((m_remote.compile.size() != 0) && (remoteExecutor->IsEnabled() == true)) {
+		bool bSuccess;
+		if (ExecuteRemote(bSuccess) == true)
+			return bSuccess;
+	}
+
+	if (ExecuteLocal(m_command, m_args) == false)
 		return false;
 
+	if ((m_cache != nullptr) && (m_returnValue == 0))
+		m_cache->Store(m_handle);
+
 	if (m_bFailIfNonZero == true)
 		return m_returnValue == 0;
 
@@ -744,237 +1702,271 @@ bool CCommandTask::Execute() {
 }
 
 /* ****************************************
- * CCommandTask::GetReturnValue
+ * CCommandTask::ExecuteLocal
  */
-int CCommandTask::GetReturnValue() const {
-	return m_returnValue;
-}
+bool CCommandTask::ExecuteLocal(const std::string& command, const std::vector<std::string>& args) {
+	// Once upon a time, an implementation with `popen()` was used
+	// But it was not perfect enough for me
 
-/* ****************************************
- * CCommandTask::KillProcess
- */
-void CCommandTask::KillProcess() {
-	m_process.Kill();
+	g_localSlots.Acquire();
+	if (jobServer->Acquire(m_bCancel) == false) {
+		g_localSlots.Release();
+		return false; // Killed
+	}
+
+	const bool bExecuted = (args.size() != 0) ? m_process.Exec(args, m_returnValue) : m_process.Exec(command.c_str(), m_returnValue);
+
+	jobServer->Release();
+	g_localSlots.Release();
+
+	return bExecuted;
 }
 
 /* ****************************************
- * CCommandTask::GetProcess
+ * CCommandTask::ExecuteRemote
  */
-const CProcess& CCommandTask::GetProcess() const {
-	return m_process;
-}
+bool CCommandTask::ExecuteRemote(bool& rbSuccess) {
+	if (ExecuteLocal(m_remote.preprocess, m_remoteArgs) == false)
+		return false;
 
-// ******************************************************************************** //
+	if (m_returnValue != 0) { // Error of the source itself
+		rbSuccess = (m_bFailIfNonZero == false);
+		return true;
+	}
 
-/* ****************************************
- * WorkerRoutine
- */
-void WorkerRoutine(SWorker* worker) {
-	while (true) {
-		worker->status = EWorkerStatus::WAIT_TASK;
+	SRemoteJob job;
+	job.compile = m_remote.compile;
+	job.extension = m_remote.source.extension().string().substr(1);
 
-		while (worker->status == EWorkerStatus::WAIT_TASK); // Wait for a task
-		if (worker->task == nullptr)
-			break;
+	{
+		std::ifstream source(m_remote.source, std::ios::binary);
+		job.source.assign(std::istreambuf_iterator<char>(source), std::istreambuf_iterator<char>());
+		if (source.bad() == true)
+			return false;
+	}
 
-		worker->status = EWorkerStatus::WORKING;
-		const bool bStatus = worker->task->Execute();
-		if (bStatus == false) {
-			worker->status = EWorkerStatus::FAIL;
-			return;
+	std::error_code error;
+	std::filesystem::remove(m_remote.source, error);
+
+	SRemoteResult result;
+	if (remoteExecutor->Execute(job, result, m_bCancel) == false)
+		return false;
+
+	m_bRemote = true;
+	m_returnValue = result.returnValue;
+	m_remoteOut = m_process.GetOutBuffer() + result.out; // Preprocessor warnings are here too
+	m_remoteErr = m_process.GetErrBuffer() + result.err;
+
+	if (m_returnValue == 0) {
+		std::ofstream object(m_remote.outPath, std::ios::binary | std::ios::trunc);
+		object.write(result.object.data(), result.object.size());
+		object.close();
+
+		if (object.fail() == true) {
+			m_remoteErr += "Can't write \"" + m_remote.outPath.string() + "\"\n";
+			m_returnValue = -1;
+			rbSuccess = false;
+			return true;
 		}
+
+		if (m_cache != nullptr)
+			m_cache->Store(m_handle);
 	}
 
-	worker->status = EWorkerStatus::STOPPED;
-}
+	rbSuccess = (m_bFailIfNonZero == false) || (m_returnValue == 0);
 
-// ******************************************************************************** //
-
-#if defined(__linux__) // TODO: Win impl
+	return true;
+}
 
 /* ****************************************
- * CProcess::CProcess
+ * CCommandTask::GetReturnValue
  */
-CProcess::CProcess() {
+int CCommandTask::GetReturnValue() const {
+	return m_returnValue;
 }
 
 /* ****************************************
- * CProcess::~CProcess
+ * CCommandTask::SetCache
  */
-CProcess::~CProcess() {
+void CCommandTask::SetCache(ITaskCache* cache, TaskHandle handle) {
+	m_cache = cache;
+	m_handle = handle;
 }
 
 /* ****************************************
- * CProcess::Clear
+ * CCommandTask::IsCached
  */
-bool CProcess::Clear() {
-	pid_t pid = 0;
-
-	if (m_pid > 0) {
-		do {
-			pid = waitpid(m_pid, &m_status, 0);
-		} while (pid == -1 && errno == EINTR);
-		
-		m_pid = 0;
-	}
-
-	for (size_t i = 0; i < 2; ++i) {
-		if (m_outPipe[i] != 0)
-			close(m_outPipe[i]);
+bool CCommandTask::IsCached() const {
+	return m_bCached;
+}
 
-		m_outPipe[i] = 0;
-	}
-	
+/* ****************************************
+ * CCommandTask::IsRemote
+ */
+bool CCommandTask::IsRemote() const {
+	return m_bRemote;
+}
 
-	for (size_t i = 0; i < 2; ++i) {
-		if (m_errPipe[i] != 0)
-			close(m_errPipe[i]);
+/* ****************************************
+ * CCommandTask::GetOutputSize
+ */
+size_t CCommandTask::GetOutputSize() const {
+	return (m_bRemote == true) ? (m_remoteOut.size() + m_remoteErr.size()) : m_process.GetOutputSize();
+}
 
-		m_errPipe[i] = 0;
-	}
+/* ****************************************
+ * CCommandTask::SetRemote
+ */
+void CCommandTask::SetRemote(const SRemoteCommand& remote) {
+	m_remote = remote;
 
-	return pid != -1;
+	if (CProcess::SplitCommand(m_remote.preprocess, m_remoteArgs) == false)
+		m_remoteArgs.clear();
 }
 
 /* ****************************************
- * CProcess::CheckPollFD
+ * CCommandTask::SetOutputFile
  */
-bool CProcess::CheckPollFD(size_t index) {
-	if (m_pfd[index].revents != 0) {
-		if (m_pfd[index].revents & POLLIN) {
-			char buffer[DELTAMAKE_POLL_BUFFER_SIZE];
-			const ssize_t nCh = read(m_pfd[index].fd, buffer, sizeof(buffer));
-			if (nCh == -1) {
-				m_errBuffer = "read() failed";
+void CCommandTask::SetOutputFile(const std::filesystem::path& path) {
+	m_process.SetOutPath(path.string());
+}
 
-				return false;
-			}
+/* ****************************************
+ * CCommandTask::GetOutBuffer
+ */
+const std::string& CCommandTask::GetOutBuffer() const {
+	return (m_bRemote == true) ? m_remoteOut : m_process.GetOutBuffer();
+}
 
-			if (nCh != 0) {
-				// Yes, I can turn it into hackery
-				// `((index == 0) ? &m_rOutBuffer : &m_rErrBuffer)->append(buffer, nCh);`
-				// But it's to hard to read later
+/* ****************************************
+ * CCommandTask::GetErrBuffer
+ */
+const std::string& CCommandTask::GetErrBuffer() const {
+	return (m_bRemote == true) ? m_remoteErr : m_process.GetErrBuffer();
+}
 
-				if (index == 0) // Process' `stdout`
-					m_outBuffer.append(buffer, nCh);
-				else // Process' `stderr`
-					m_errBuffer.append(buffer, nCh);
-			}
-		}
-		else // POLLERR | POLLHUP
-			return false;
-	}
+/* ****************************************
+ * CCommandTask::KillProcess
+ */
+void CCommandTask::KillProcess() {
+	m_bCancel = true;
+	m_process.Kill();
+}
 
-	return true;
+/* ****************************************
+ * CCommandTask::GetProcess
+ */
+const CProcess& CCommandTask::GetProcess() const {
+	return m_process;
 }
 
+// ******************************************************************************** //
+
 /* ****************************************
- * CProcess::Exec
+ * WorkerRoutine
  */
-bool CProcess::Exec(const char command[], int& rReturnStatus) {
-	if (pipe(m_outPipe) < 0){
-		m_errBuffer = "pipe(m_outPipe) failed";
+void WorkerRoutine(SWorker* worker) {
+	SWorkerStats& stats = worker->stats;
 
-		return false;
-	}
-	
-	if (pipe(m_errPipe) < 0) {
-		Clear();
-		m_errBuffer = "pipe(m_errPipe) failed";
+	while (true) {
+		ITask* task = nullptr;
+		{
+			// `status` is already `WAIT_TASK` (initial value or set below), so the scheduler may have given a task before we got here
+			std::unique_lock<std::mutex> workerLock(worker->mutex);
 
-		return false;
-	}
+			const auto idleSince = std::chrono::steady_clock::now();
+			worker->wakeup.wait(workerLock, [worker]() { return worker->status != EWorkerStatus::WAIT_TASK; }); // Wait for a task
 
-	// Fork go brrr
-	m_pid = fork();
-	if (m_pid == -1) { // Bruh
-		Clear();
-		m_errBuffer = "fork() failed";
+			const uint64_t latency = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - idleSince).count();
+			stats.idleNs += latency;
 
-		return false;
-	}
-	else if (m_pid == 0) { // Child
-		// Let's ignore SIGINT!
-		struct sigaction sa;
-		sa.sa_handler = SIG_IGN;
-		sigemptyset(&sa.sa_mask);
-		sa.sa_flags = 0;
+			task = worker->task;
+			if (task != nullptr) {
+				stats.latencyNs += latency;
+				if (latency > stats.maxLatencyNs)
+					stats.maxLatencyNs = latency;
+			}
+		}
 
-		if (sigaction(SIGINT, &sa, NULL) == -1)
-			_exit(127);
+		if (task == nullptr)
+			break;
 
-		// Let's redirect some pipes
-		PROCESS_REDIRECT_OUTPUT_PIPE(m_outPipe, STDOUT_FILENO); // Redirect child's `stdout` to `m_outPipe`
-		PROCESS_REDIRECT_OUTPUT_PIPE(m_errPipe, STDERR_FILENO); // Redirect child's `stderr` to `m_errPipe`
+		++stats.nDispatches;
 
-		// Let's replace some process
-		const char* args[] = { "sh", "-c", command, NULL };
-		execve(_PATH_BSHELL, const_cast<char**>(args), environ);
-		_exit(127); // As in implementation of `popen()`
-	}
+		worker->status = EWorkerStatus::WORKING;
+		worker->startTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
 
-	// Parent
-	PROCESS_CLOSE_PIPE(m_outPipe[1]);
-	PROCESS_CLOSE_PIPE(m_errPipe[1]);
-	
-	// Events for `poll()`
-	m_pfd[0].fd = m_outPipe[0]; // Process' `stdout`
-	m_pfd[0].events = POLLIN; // Read condition
+		if (trace->IsEnabled() == true)
+			worker->traceBegin = trace->GetTime();
 
-	m_pfd[1].fd = m_errPipe[0]; // Process' `stderr`
-	m_pfd[1].events = POLLIN; // Read condition
+		const auto taskStart = std::chrono::steady_clock::now();
+		const bool bStatus = task->Execute();
+		worker->duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - taskStart).count();
 
-	while (true) {
-		const int ready = poll(m_pfd, 2, -1); // Waiting for event with infinite timeout
-		if (ready < 0) { // Smh bad happened
-			m_errBuffer = "poll() failed";
-			Clear();
+		if (trace->IsEnabled() == true)
+			worker->traceEnd = trace->GetTime();
 
-			return false;
+		if ((bStatus == false) && (config->bKeepGoing == false)) {
+			stats.cpuNs = GetThreadCPUTime();
+			worker->status = EWorkerStatus::FAIL;
+			g_schedulerLocal.Notify();
+			return;
 		}
 
-		if (CheckPollFD(PROCESS_POLL_OUT) == false) // Why?
-			break;
-
-		CheckPollFD(PROCESS_POLL_ERR); // Don't care
-	}
+		{
+			std::lock_guard<std::mutex> workerLock(worker->mutex);
+			if (worker->status == EWorkerStatus::FAIL) { // Killed, it's reaped already
+				stats.cpuNs = GetThreadCPUTime();
+				return;
+			}
 
-	Clear();
+			worker->bFailed = bStatus == false;
+			worker->status = EWorkerStatus::WAIT_TASK;
+		}
 
-	if (WIFEXITED(m_status) == 0) { // And here's why
-		m_errBuffer = "WIFEXITED() is zero";
-		
-		return false;
+		g_schedulerLocal.Notify();
 	}
 
-	rReturnStatus = WEXITSTATUS(m_status);
-
-	return true;
+	stats.cpuNs = GetThreadCPUTime();
+	worker->status = EWorkerStatus::STOPPED;
+	g_schedulerLocal.Notify();
 }
 
 /* ****************************************
- * CProcess::Kill
+ * GetAvailableMemory
  */
-bool CProcess::Kill() {
-	return kill(m_pid, SIGKILL) != -1;
-}
+static uint64_t GetAvailableMemory() {
+	FILE* file = fopen("/proc/meminfo", "r");
+	if (file == nullptr)
+		return 0;
+
+	unsigned long long available = 0; // kB
+	char line[256];
+	while (fgets(line, sizeof(line), file) != nullptr) {
+		if (sscanf(line, "MemAvailable: %llu kB", &available) == 1)
+			break;
+	}
 
-/* ****************************************
- * CProcess::GetOutBuffer
- */
-const std::string& CProcess::GetOutBuffer() const {
-	return m_outBuffer;
+	fclose(file);
+
+	return available >> 10;
 }
 
 /* ****************************************
- * CProcess::GetErrBuffer
+ * GetThreadCPUTime
  */
-const std::string& CProcess::GetErrBuffer() const {
-	return m_errBuffer;
+static uint64_t GetThreadCPUTime() {
+	timespec ts;
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+		return 0;
+
+	return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
 }
 
 // ******************************************************************************** //
 
+#if defined(__linux__) // TODO: Win impl
+
 /* ****************************************
  * SignalInterruptCatcher::Init
  */
@@ -988,10 +1980,17 @@ void SignalInterruptCatcher::Init() {
 	sigaction(SIGINT, &sa, &oldHandler);
 }
 
+/* ****************************************
+ * SignalInterruptCatcher::Restore
+ */
+void SignalInterruptCatcher::Restore() {
+	sigaction(SIGINT, &oldHandler, NULL);
+}
+
 /* ****************************************
  * SignalInterruptCatcher::FirstHandler
  */
-void SignalInterruptCatcher::FirstHandler(int signal) {
+void SignalInterruptCatcher::FirstHandler(int /* signal */) {
 	struct sigaction sa;
 
 	sa.sa_handler = SignalInterruptCatcher::SecondHandler;
@@ -1006,7 +2005,7 @@ void SignalInterruptCatcher::FirstHandler(int signal) {
 /* ****************************************
  * SignalInterruptCatcher::SecondHandler
  */
-void SignalInterruptCatcher::SecondHandler(int signal) {
+void SignalInterruptCatcher::SecondHandler(int /* signal */) {
 	sigaction(SIGINT, &oldHandler, NULL);
 
 	g_schedulerLocal.Kill();
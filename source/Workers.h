@@ -7,29 +7,166 @@
 #ifndef __DELTAMAKE_WORKERS_H__
 #define __DELTAMAKE_WORKERS_H__
 
+#include <stdint.h>
+#include <time.h>
+
 #include <string>
+#include <vector>
+#include <filesystem>
 
 #include "deltamake.h"
+
+
+#define DELTAMAKE_TASK_NONE				(static_cast<DeltaMake::TaskHandle>(-1))
  
 // ******************************************************************************** //
 
 										//										//
 namespace DeltaMake {
+	/**
+	 * Task index in the scheduler list
+	 */
+	typedef size_t						TaskHandle;
+
+	/**
+	 * Ended task info
+	 */
+	struct STaskResult {
+		bool							bSuccess;
+		bool							bCached; /* Outputs are restored without execution */
+		int								returnValue; /* Exit status of command */
+		int64_t							startTime; /* ns of the wall clock at the start */
+		uint64_t						duration; /* ms */
+		uint64_t						maxRSS; /* KiB of the local process, `0` if there is none */
+	};
+
+	/**
+	 * Resource class of the task: links are heavier and may be limited separately
+	 */
+	enum class ETaskClass : int {
+		COMPILE,
+		LINK,
+	};
+
+	/**
+	 * Task events receiver
+	 * 
+	 * \warning Called from the scheduler thread
+	 */
+	class ITaskListener {
+		public:
+			ITaskListener&				operator=(const ITaskListener&)			= delete;
+
+			/**
+			 * Task is about to start
+			 * 
+			 * \returns `false` to skip it, so it's done without execution
+			 */
+			virtual bool				OnTaskReady(TaskHandle /* task */)		{ return true; }
+
+			virtual void				OnTaskDone(TaskHandle task, const STaskResult& result) = 0;
+
+		protected:
+			virtual						~ITaskListener()						= default;
+	};
+
+	/**
+	 * Task outputs cache, it's asked before the execution of the task
+	 * 
+	 * \warning Called from the worker thread, so it must be thread-safe
+	 */
+	class ITaskCache {
+		public:
+			ITaskCache&					operator=(const ITaskCache&)			= delete;
+
+			/**
+			 * Restore outputs of the task instead of execution
+			 * 
+			 * \returns `true` if the task is done
+			 */
+			virtual bool				Fetch(TaskHandle task)					= 0;
+
+			/**
+			 * Save outputs of the successfully executed task
+			 */
+			virtual void				Store(TaskHandle task)					= 0;
+
+		protected:
+			virtual						~ITaskCache()							= default;
+	};
+
+	/**
+	 * Compile command split into the local preprocessing and the remote compiling
+	 */
+	struct SRemoteCommand {
+		std::string						preprocess; /* Local command that writes `source` */
+		std::filesystem::path			source; /* Preprocessed source */
+		std::string						compile; /* Compiler and flags without input and output */
+		std::filesystem::path			outPath; /* Object */
+	};
+
 	/**
 	 * Scheduler list of tasks
+	 * Every task starts when all its dependencies are done
 	 */
 	class ITaskList {
 		public:
 			ITaskList&					operator=(const ITaskList&)				= delete;
 
 			/**
+			 * Same command added again in the same phase is the same task, with `deps` added to it
+			 * 
 			 * \param title Title of task
 			 * \param command Full system command string
+			 * \param deps Tasks that must be done before this one
 			 * \param bFailIfNonZero Treat a non-zero return of command as an error and stop worker
+			 * \returns Task handle or `DELTAMAKE_TASK_NONE`
+			 */
+			virtual TaskHandle			AddCommand(const char title[], const std::string& command, const std::vector<TaskHandle>& deps = {}, bool bFailIfNonZero = true) = 0;
+
+			/**
+			 * All tasks added after the barrier wait for all tasks added before it
+			 * 
+			 * \returns Task handle or `DELTAMAKE_TASK_NONE`
+			 */
+			virtual TaskHandle			AddBarrier()							= 0;
+
+			/**
+			 * Listeners are added, every one that shares the task gets its events
+			 * 
+			 * \param listener Receiver of the task events or `nullptr` to remove all of them
 			 */
-			virtual void				AddCommand(const char title[], const std::string& command, bool bFailIfNonZero = true) = 0;
+			virtual void				SetListener(TaskHandle task, ITaskListener* listener) = 0;
 
-			virtual void				AddBarrier()							= 0;
+			/**
+			 * \param cache Outputs cache of the command task or `nullptr`
+			 */
+			virtual void				SetCache(TaskHandle task, ITaskCache* cache) = 0;
+
+			/**
+			 * Command task may be executed on a build node (`--remote`)
+			 */
+			virtual void				SetRemote(TaskHandle task, const SRemoteCommand& remote) = 0;
+
+			/**
+			 * `stdout` of the command task is written to the file instead of the terminal
+			 */
+			virtual void				SetOutputFile(TaskHandle task, const std::filesystem::path& path) = 0;
+
+			/**
+			 * Expected duration of the task, so the longest chains of tasks are started first
+			 * 
+			 * \param duration ms
+			 */
+			virtual void				SetEstimate(TaskHandle task, uint64_t duration) = 0;
+
+			/**
+			 * Expected memory of the task, it's started only while the running ones
+			 * with it fit the memory budget (`--mem-limit`)
+			 * 
+			 * \param memory MiB
+			 */
+			virtual void				SetResources(TaskHandle task, ETaskClass taskClass, uint64_t memory) = 0;
 
 			virtual size_t				GetTaskCount() const					= 0;
 
@@ -48,7 +185,12 @@ namespace DeltaMake {
 
 			virtual ITaskList*			GetList()								= 0;
 
-			virtual void				Start()									= 0;
+			/**
+			 * Execute all tasks and wait for them
+			 * 
+			 * \returns `false` if some task is failed or was not executed
+			 */
+			virtual bool				Start()									= 0;
 
 			/**
 			 * Stop task queue and wait for current tasks to end
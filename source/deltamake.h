@@ -9,9 +9,11 @@
 
 #include <stddef.h>
 #include <signal.h>
+#include <time.h>
 
 #include <string>
 #include <vector>
+#include <set>
 #include <filesystem>
 
 #include <json/json.h>
@@ -23,20 +25,42 @@
 
 #define DELTAMAKE_CONFIG_FILENAME		"solution.json"
 #define DELTAMAKE_DIFF_FILENAME			"deltamake.json"
+#define DELTAMAKE_GRAPH_FILENAME		"deltamake.graph"
 
 #define DELTAMAKE_MIN_WORKER_TITLE		32
 #define DELTAMAKE_SCHEDULER_DELAY		80 // ms
-#define DELTAMAKE_BARRIER_DELAY			10 // ms
+#define DELTAMAKE_RENDER_NICE			10 // Of the status thread, it must not slow down the workers
+
+#define DELTAMAKE_MEMORY_SHARE			0.8 // Of `MemAvailable` for the tasks, if `--mem-limit` is not set
+#define DELTAMAKE_ADMISSION_SCAN		64 // Ready tasks checked for one that fits the budget
+
+#define DELTAMAKE_ADAPTIVE_PERIOD		1000 // ms between the pressure samples of `--adaptive`
+#define DELTAMAKE_ADAPTIVE_CPU_LOW		0.10 // Share of the period with waiting for a CPU, below it a worker is added
+#define DELTAMAKE_ADAPTIVE_CPU_HIGH		0.30 // Above it a quarter of the workers is removed
+#define DELTAMAKE_ADAPTIVE_MEMORY_HIGH	0.05 // Share of the period with waiting for memory, above it half of the workers is removed
+
+#define DELTAMAKE_TERMINAL_COLUMNS		80 // If it's not a terminal
+#define DELTAMAKE_TERMINAL_ROWS			24
 
 #define DELTAMAKE_BARRIER_TITLE			"-= BARRIER =-"
 
-#define DELTAMAKE_POLL_BUFFER_SIZE		512
+#define DELTAMAKE_POLL_BUFFER_SIZE		65536 // Default pipe capacity, one `read()` for a full pipe
+#define DELTAMAKE_MAX_OUTPUT_SIZE		(1u << 20) // Captured bytes of `stdout`/`stderr`, the rest goes to a file
 
 
 // ******************************************************************************** //
 
 										//										//
 namespace DeltaMake {
+	/**
+	 * Effect of the changed files on the loaded builds (`--watch`)
+	 */
+	enum class EWatchChange : int {
+		NONE, /* Not an input */
+		INPUTS, /* Sources or headers, rebuild */
+		CONFIG, /* `solution.json`, load again */
+	};
+
 	/**
 	 * Build basic interface
 	 */
@@ -49,6 +73,13 @@ namespace DeltaMake {
 			 */
 			virtual bool				PreBuild()								= 0;
 
+			/**
+			 * Generate tasks that must end before `Build()`, like the dependency scans of the sources
+			 * 
+			 * \returns Number of commands to execute
+			 */
+			virtual size_t				Scan(class ITaskList* taskList)			= 0;
+
 			/**
 			 * Generate command task list
 			 * 
@@ -61,6 +92,30 @@ namespace DeltaMake {
 			 */
 			virtual bool				PostBuild()								= 0;
 
+			/**
+			 * Inputs to watch (`--watch`)
+			 * 
+			 * \param rPaths Files, and directories that are watched with subdirectories
+			 * \param rExcluded Outputs inside of the watched directories
+			 */
+			virtual void				GetWatchPaths(std::vector<std::filesystem::path>& rPaths, std::vector<std::filesystem::path>& rExcluded) const = 0;
+
+			/**
+			 * Apply the changed files to the loaded state, so the next `Build()` sees them
+			 * 
+			 * \param changed Normalized paths of changed files and directories
+			 */
+			virtual EWatchChange		Update(const std::set<std::filesystem::path>& changed) = 0;
+
+			/**
+			 * Files and directories of a build without tasks (`deltamake.graph`): while none of them
+			 * is changed, the next build has no tasks too
+			 * 
+			 * \param rExpires Time when the tasks may be there without any file change, not changed if never
+			 * \returns `false` if the build does something even without tasks
+			 */
+			virtual bool				GetGraphInputs(std::vector<std::filesystem::path>& rPaths, time_t& rExpires) const = 0;
+
 		protected:
 			virtual						~IBuild()								= default;
 	};
@@ -110,6 +165,11 @@ namespace DeltaMake {
 			 */
 			virtual bool				SaveDiff(const char path[])				= 0;
 
+			/**
+			 * \returns `true` if the diff is changed without a task, so it's saved by a build with nothing to do too
+			 */
+			virtual bool				IsDiffChanged() const					= 0;
+
 		protected:
 			virtual						~ISolution()							= default;
 	};
@@ -177,8 +237,28 @@ namespace DeltaMake {
 		bool							bScan									= false;
 		bool							bForce									= false;
 		bool							bDontSaveDiff							= false;
+		bool							bMeasure								= false;
+		bool							bChecksum								= false;
+		bool							bPlain									= false; /* Line per task, no escape sequences */
+		bool							bWatch									= false; /* Rebuild on changes */
+		bool							bBinaryDiff								= false; /* Node table diff with a journal */
+		bool							bNoGraph								= false; /* Don't skip no-op builds by `deltamake.graph` */
+		bool							bKeepGoing								= false; /* Failed tasks cancel only their dependents */
+
+		const char*						cachePath								= nullptr; /* Object cache directory */
+		size_t							cacheSize								= 0; /* MiB */
+
+		const char*						remoteHosts								= nullptr; /* Build nodes */
+		const char*						servePort								= nullptr; /* Be a build node, `[address:]port` */
+		const char*						serveCompilers							= nullptr; /* Allowed on the build node */
+
+		const char*						tracePath								= nullptr; /* Chrome trace events */
+
+		size_t							memoryLimit								= 0; /* MiB of running tasks, `0` for a part of available memory */
+		size_t							nLinkJobs								= 0; /* Links at once, `0` for no limit */
 
 		size_t							nMaxWorkers								= 0;
+		size_t							nMinWorkers								= 0; /* Of `--adaptive`, `0` if the number of workers is fixed */
 		size_t							nCores									= 1;
 	};
 
@@ -7,10 +7,16 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
+
+#include <unistd.h>
 
 #include <vector>
 #include <map>
+#include <set>
+#include <algorithm>
 #include <thread>
+#include <limits>
 
 #include "deltamake.h"
 #include "Terminal.h"
@@ -18,6 +24,13 @@
 #include "Exception.h"
 #include "SolutionDefault.h"
 #include "Workers.h"
+#include "Cache.h"
+#include "Remote.h"
+#include "JobServer.h"
+#include "Trace.h"
+#include "Watch.h"
+#include "SolutionRegistry.h"
+#include "BuildGraph.h"
 
 using namespace DeltaMake;
 
@@ -26,6 +39,8 @@ using namespace DeltaMake;
 DeltaMake::SConfig g_config;
 extern DeltaMake::SConfig* const DeltaMake::config = &g_config;
 
+std::string g_graphKey; // `CBuildGraph::GetKey()` of the arguments
+
 // ******************************************************************************** //
 										//										//
 
@@ -76,6 +91,32 @@ void Init();
  */
 void RegisterPlugin(IPlugin* plugin);
 
+/**
+ * Pre build, build and post build of the selected builds
+ * 
+ * \returns Exit code
+ */
+int RunBuilds(std::vector<IBuild*>& builders);
+
+/**
+ * Save diffs of the root and the sub solutions after the build
+ */
+void SaveDiffs();
+
+/**
+ * Save inputs of the builds without tasks, so the next same build is skipped
+ */
+void SaveGraph(std::vector<IBuild*>& builders);
+
+/**
+ * Build again on every change of the inputs (`--watch`), the loaded solutions
+ * and diffs are kept between the builds
+ * 
+ * \param argv Arguments to start again with, when some `solution.json` is changed
+ * \returns Exit code on error
+ */
+int WatchBuilds(std::vector<IBuild*>& builders, char* argv[]);
+
 
 #include "AutoGen.h"
 
@@ -94,19 +135,48 @@ int main(int argc, char* argv[]) {
 	);
 	ParseArgs(CArgStream(argc, argv));
 
+	DeltaMake::trace->Init(g_config.tracePath);
+
 	//
 	Init();
+
+	if (g_config.servePort != nullptr)
+		return RunRemoteServer(g_config.servePort, g_config.nMaxWorkers, g_config.serveCompilers);
+
+	// Nothing is changed since the last build without tasks
+	const bool bGraph = (g_config.bNoGraph == false) && (g_config.bForce == false) && (g_config.bNoBuild == false) && (g_config.bWatch == false);
+	if (bGraph == true) {
+		g_graphKey = CBuildGraph::GetKey(argc, argv);
+
+		bool bUpToDate;
+		{
+			CTraceScope scope("Check build graph");
+			bUpToDate = CBuildGraph::IsUpToDate(DELTAMAKE_GRAPH_FILENAME, g_graphKey);
+		}
+
+		if (bUpToDate == true) {
+			DeltaMake::trace->Save();
+			terminal->Log(LOG_INFO, "Nothing to do.\n");
+			return EXIT_SUCCESS;
+		}
+	}
+
+	// Shared with `make` of the parent or the children
+	DeltaMake::jobServer->Init((remoteExecutor->IsEnabled() == true) ? g_config.nCores : g_config.nMaxWorkers);
+
 	LoadPlugins();
 
 
 
 	DeltaMake::scheduler->Init(g_config.nMaxWorkers);
+	DeltaMake::objectCache->Init(g_config.cachePath, static_cast<uint64_t>(g_config.cacheSize) << 20);
 	//DeltaMake::scheduler->Start();
 
 	//return 0;
 
 	// Loading
 	try {
+		CTraceScope scope("Load solutions");
 		g_config.root = ISolution::Load(DELTAMAKE_CONFIG_FILENAME);
 		if (g_config.root == nullptr)
 			return EXIT_FAILURE;
@@ -124,18 +194,28 @@ int main(int argc, char* argv[]) {
 		return EXIT_FAILURE;
 	}
 
+	if ((g_config.bForce == false) && ((g_config.bNoBuild == false) || (g_config.bScan == true))) { // The listing cache of the scan is there too
+		CTraceScope scope("Load diff");
+		g_config.root->LoadDiff(DELTAMAKE_DIFF_FILENAME);
+	}
+
 	if (g_config.bScan == true) {
+		CTraceScope scope("Scan");
 		if (g_config.root->ScanFolders() == false)
 			return EXIT_FAILURE;
 	}
 
 
 	// Building
-	if (g_config.bNoBuild == true)
-		return EXIT_SUCCESS;
+	if (g_config.bNoBuild == true) {
+		if ((g_config.bScan == true) && (g_config.bDontSaveDiff == false)) {
+			CTraceScope scope("Save diff");
+			g_config.root->SaveDiff(DELTAMAKE_DIFF_FILENAME);
+		}
 
-	if (g_config.bForce == false)
-		g_config.root->LoadDiff(DELTAMAKE_DIFF_FILENAME);
+		DeltaMake::trace->Save();
+		return EXIT_SUCCESS;
+	}
 
 	if (g_config.builds.size() == 0) {
 		terminal->Log(LOG_DETAIL, "No builds setted. Default value is used\n");
@@ -144,42 +224,194 @@ int main(int argc, char* argv[]) {
 
 	terminal->Log(LOG_DETAIL, "Selected builds:\n");
 	std::vector<DeltaMake::IBuild*> builders(g_config.builds.size());
-	for (size_t i = 0; i < g_config.builds.size(); ++i) {
-		builders[i] = g_config.root->GenBuild(g_config.builds[i]);
-		if (builders[i] == nullptr) {
-			terminal->Log(LOG_ERROR, "Build not found: \"%s\"\n", g_config.builds[i]);
-			return EXIT_FAILURE;
-		}
+	{
+		CTraceScope scope("Load sub solutions"); // By the builds
+		for (size_t i = 0; i < g_config.builds.size(); ++i) {
+			builders[i] = g_config.root->GenBuild(g_config.builds[i]);
+			if (builders[i] == nullptr) {
+				terminal->Log(LOG_ERROR, "Build not found: \"%s\"\n", g_config.builds[i]);
+				return EXIT_FAILURE;
+			}
 
-		terminal->Log(LOG_DETAIL, "\t\"%s\"\n", g_config.builds[i]);
+			terminal->Log(LOG_DETAIL, "\t\"%s\"\n", g_config.builds[i]);
+		}
 	}
 
+	const int exitCode = RunBuilds(builders);
+	if (g_config.bWatch == false)
+		return exitCode;
+
+	return WatchBuilds(builders, argv);
+}
+
+// ******************************************************************************** //
+
+/* ****************************************
+ * RunBuilds
+ */
+int RunBuilds(std::vector<IBuild*>& builders) {
 	ITaskList* taskList = scheduler->GetList();
 
-	for (size_t i = 0; i < g_config.builds.size(); ++i) {
-		builders[i]->PreBuild();
+	DeltaMake::solutionRegistry->NextRun(); // Shared sub builds are visited once per run
+
+	for (size_t i = 0; i < builders.size(); ++i) {
+		{
+			CTraceScope scope("Pre build");
+			builders[i]->PreBuild();
+		}
+
+		CTraceScope scope("Generate scans");
+		builders[i]->Scan(taskList);
+	}
+
+	// Tasks of the builds depend on what the scans find, so they are generated after them
+	if (taskList->GetTaskCount() != 0) {
+		bool bScanned;
+		{
+			CTraceScope scope("Scan sources");
+			bScanned = DeltaMake::scheduler->Start();
+		}
+
+		if (bScanned == false) { // Failed scans are not errors, so it's stopped
+			DeltaMake::trace->Save();
+			terminal->Log(LOG_ERROR, "Build failed.\n");
+			return EXIT_FAILURE;
+		}
+	}
+
+	for (size_t i = 0; i < builders.size(); ++i) {
+		CTraceScope scope("Generate tasks");
 		builders[i]->Build(taskList);
 	}
 
 	if (taskList->GetTaskCount() == 0) {
+		if ((g_config.bDontSaveDiff == false) && ((g_config.root->IsDiffChanged() == true) || (DeltaMake::solutionRegistry->IsDiffChanged() == true)))
+			SaveDiffs();
+
+		SaveGraph(builders);
+		DeltaMake::trace->Save(); // No-op builds are measured too
 		terminal->Log(LOG_INFO, "Nothing to do.\n");
 		return EXIT_SUCCESS;
 	}
 
 	// DANGER: THREADS!
-	DeltaMake::scheduler->Start();
+	bool bBuilt;
+	{
+		CTraceScope scope("Build");
+		bBuilt = DeltaMake::scheduler->Start();
+	}
+
+	DeltaMake::objectCache->ShowStats();
+	{
+		CTraceScope scope("Cache trim");
+		DeltaMake::objectCache->Trim();
+	}
+	DeltaMake::remoteExecutor->ShowStats();
+
+	CBuildGraph::Remove(DELTAMAKE_GRAPH_FILENAME); // Next build checks the results of this one
+
+	if (bBuilt == false) {
+		SaveDiffs(); // Only ended tasks are in the diff, so the finished ones are not executed again
+
+		DeltaMake::trace->Save();
+		terminal->Log(LOG_ERROR, "Build failed.\n");
+		return EXIT_FAILURE;
+	}
 
-	for (size_t i = 0; i < g_config.builds.size(); ++i)
+	for (size_t i = 0; i < builders.size(); ++i) {
+		CTraceScope scope("Post build");
 		builders[i]->PostBuild();
+	}
 
-	if (g_config.bDontSaveDiff == false)
-		g_config.root->SaveDiff(DELTAMAKE_DIFF_FILENAME);
+	SaveDiffs();
 
+	DeltaMake::trace->Save();
 	terminal->Log(LOG_INFO, "Done.\n");
 
 	return EXIT_SUCCESS;
 }
 
+/* ****************************************
+ * SaveDiffs
+ */
+void SaveDiffs() {
+	if (g_config.bForce == false) {
+		CTraceScope scope("Save sub diffs");
+		DeltaMake::solutionRegistry->SaveDiffs();
+	}
+
+	if (g_config.bDontSaveDiff == false) {
+		CTraceScope scope("Save diff");
+		g_config.root->SaveDiff(DELTAMAKE_DIFF_FILENAME);
+	}
+}
+
+/* ****************************************
+ * SaveGraph
+ */
+void SaveGraph(std::vector<IBuild*>& builders) {
+	if (g_graphKey.size() == 0)
+		return; // Disabled
+
+	CTraceScope scope("Save build graph");
+
+	std::vector<std::filesystem::path> paths;
+	time_t expires = std::numeric_limits<time_t>::max();
+	for (size_t i = 0; i < builders.size(); ++i) {
+		if (builders[i]->GetGraphInputs(paths, expires) == false) {
+			CBuildGraph::Remove(DELTAMAKE_GRAPH_FILENAME);
+			return;
+		}
+	}
+
+	CBuildGraph::Save(DELTAMAKE_GRAPH_FILENAME, g_graphKey, std::move(paths), expires);
+}
+
+/* ****************************************
+ * WatchBuilds
+ */
+int WatchBuilds(std::vector<IBuild*>& builders, char* argv[]) {
+	CWatcher watcher;
+	if (watcher.Init() == false)
+		return EXIT_FAILURE;
+
+	while (true) {
+		// Included headers may be new after every build
+		std::vector<std::filesystem::path> paths;
+		std::vector<std::filesystem::path> excluded;
+		for (size_t i = 0; i < builders.size(); ++i)
+			builders[i]->GetWatchPaths(paths, excluded);
+
+		for (size_t i = 0; i < excluded.size(); ++i)
+			watcher.Exclude(excluded[i]);
+
+		for (size_t i = 0; i < paths.size(); ++i)
+			watcher.Add(paths[i]);
+
+		terminal->Log(LOG_INFO, "Watching for changes...\n");
+
+		EWatchChange change = EWatchChange::NONE;
+		while (change == EWatchChange::NONE) {
+			std::set<std::filesystem::path> changed;
+			if (watcher.Wait(changed) == false)
+				return EXIT_FAILURE;
+
+			for (size_t i = 0; i < builders.size(); ++i)
+				change = std::max(change, builders[i]->Update(changed));
+		}
+
+		if (change == EWatchChange::CONFIG) { // Builds, sub solutions and flags may be different, so it's a new start
+			terminal->Log(LOG_INFO, "Solution is changed. Restarting...\n");
+			execv("/proc/self/exe", argv);
+
+			terminal->Log(LOG_ERROR, "Can't restart: %s\n", strerror(errno));
+			return EXIT_FAILURE;
+		}
+
+		RunBuilds(builders);
+	}
+}
+
 // ******************************************************************************** //
 
 /* ****************************************
@@ -209,8 +441,49 @@ void ParseArgs(CArgStream&& stream) {
 				g_config.bNoBuild = true;
 			else if (CheckArg(arg, "force"))
 				g_config.bForce = true;
+			else if (CheckArg(arg, "keep-going"))
+				g_config.bKeepGoing = true;
 			else if (CheckArg(arg, "dont-save-diff"))
 				g_config.bDontSaveDiff = true;
+			else if (CheckArg(arg, "measure"))
+				g_config.bMeasure = true;
+			else if (CheckArg(arg, "checksum"))
+				g_config.bChecksum = true;
+			else if (CheckArg(arg, "plain"))
+				g_config.bPlain = true;
+			else if (CheckArg(arg, "scan"))
+				g_config.bScan = true;
+			else if (strcmp(arg, "--watch") == 0) // `-w` is taken
+				g_config.bWatch = true;
+			else if (strcmp(arg, "--binary-diff") == 0)
+				g_config.bBinaryDiff = true;
+			else if (strcmp(arg, "--no-graph") == 0)
+				g_config.bNoGraph = true;
+			else if ((strcmp(arg, "--cache") == 0) || (strcmp(arg, "--cache-size") == 0) || (strcmp(arg, "--remote") == 0) || (strcmp(arg, "--serve") == 0) || (strcmp(arg, "--serve-compilers") == 0) || (strcmp(arg, "--trace") == 0) || (strcmp(arg, "--mem-limit") == 0) || (strcmp(arg, "--link-jobs") == 0) || (strcmp(arg, "--adaptive") == 0)) { // No short names, `-c` and `-s` are taken
+				if (stream.GetNext() == nullptr) {
+					PrintHelp();
+					exit(EXIT_SUCCESS);
+				}
+
+				if (strcmp(arg, "--cache") == 0)
+					g_config.cachePath = stream.GetCurret();
+				else if (strcmp(arg, "--cache-size") == 0)
+					g_config.cacheSize = static_cast<size_t>(atoll(stream.GetCurret()));
+				else if (strcmp(arg, "--remote") == 0)
+					g_config.remoteHosts = stream.GetCurret();
+				else if (strcmp(arg, "--serve-compilers") == 0)
+					g_config.serveCompilers = stream.GetCurret();
+				else if (strcmp(arg, "--trace") == 0)
+					g_config.tracePath = stream.GetCurret();
+				else if (strcmp(arg, "--mem-limit") == 0)
+					g_config.memoryLimit = static_cast<size_t>(atoll(stream.GetCurret()));
+				else if (strcmp(arg, "--link-jobs") == 0)
+					g_config.nLinkJobs = static_cast<size_t>(atoll(stream.GetCurret()));
+				else if (strcmp(arg, "--adaptive") == 0)
+					g_config.nMinWorkers = std::max<size_t>(static_cast<size_t>(atoll(stream.GetCurret())), 1);
+				else
+					g_config.servePort = stream.GetCurret();
+			}
 			else if (CheckArg(arg, "workers")) {
 				if (stream.GetNext() == nullptr) {
 					PrintHelp();
@@ -243,16 +516,50 @@ void PrintHelp() {
 		"Note:\n" \
 		"    If build names are not specified, the \"default\" build name will be used.\n" \
 		"flags:\n" \
+		"    --adaptive <min workers>\n" \
+		"        Add and remove workers between it and -w by CPU and memory pressure of the host\n" \
+		"    --binary-diff\n" \
+		"        Save the differential file in binary, finished tasks go to its journal at once\n" \
+		"    -c --checksum\n" \
+		"        Compare content hashes of changed sources and objects\n" \
+		"    --cache <path>\n" \
+		"        Object cache directory (or " DELTAMAKE_CACHE_ENV " environment variable)\n" \
+		"    --cache-size <MiB>\n" \
+		"        Max size of cached objects (default: 5120)\n" \
 		"    -d --dont-save-diff\n" \
 		"        Don't save differential file\n" \
 		"    -f --force\n" \
 		"        Force rebuild all solutions (ignore all pre-builds)\n" \
 		"    -h --help\n" \
 		"        Show this help text\n" \
+		"    -k --keep-going\n" \
+		"        Execute all tasks that don't depend on a failed one, and save their results\n" \
+		"    --link-jobs <count>\n" \
+		"        Max number of links at once (default: no limit)\n" \
+		"    --mem-limit <MiB>\n" \
+		"        Memory budget of the running tasks (default: 80% of available memory)\n" \
+		"    -m --measure\n" \
+		"        Show scheduler dispatch latency, idle time and CPU time of the workers\n" \
 		"    -n --no-build\n" \
 		"        Don't build anything (useful with scan flag)\n" \
+		"    --no-graph\n" \
+		"        Don't skip the build when nothing is changed since the last one without tasks\n" \
+		"    -p --plain\n" \
+		"        Line per ended task without status redraw (default if not a terminal)\n" \
+		"    --remote <host[:port][/slots],...>\n" \
+		"        Compile on build nodes (or " DELTAMAKE_REMOTE_ENV " environment variable)\n" \
+		"    -s --scan\n" \
+		"        Add sources found in paths.scan to the files of the solutions\n" \
+		"    --serve <[address:]port>\n" \
+		"        Be a build node (loopback if no address), number of workers is number of jobs at once\n" \
+		"    --serve-compilers <compiler,...>\n" \
+		"        Compilers the build node executes (default: " DELTAMAKE_REMOTE_COMPILERS ")\n" \
+		"    --trace <file>\n" \
+		"        Save the build timeline for chrome://tracing or Perfetto\n" \
 		"    -v --verbose\n" \
 		"        Enable verbose logging\n" \
+		"    --watch\n" \
+		"        Build again on every change of the sources or headers, until Ctrl+C\n" \
 		"    -w <count> --workers <count>\n" \
 		"        Max number of workers\n";
 
@@ -305,15 +612,33 @@ bool CArgStream::IsLast() const {
 void Init() {
 	terminal->Log(LOG_DETAIL, "Terminal: %zux%zu\n", terminal->GetColumns(), terminal->GetRows());
 
+	if (terminal->IsInteractive() == false) // CI logs, pipes and files
+		g_config.bPlain = true;
+
 	//
 	g_config.nCores = static_cast<size_t>(std::thread::hardware_concurrency());
 	g_config.nCores = (g_config.nCores == 0) ? 1 : g_config.nCores;
 	terminal->Log(LOG_DETAIL, "CPU Cores:   %zu\n", g_config.nCores);
 
-	if (g_config.nMaxWorkers == 0)
-		g_config.nMaxWorkers = g_config.nCores;
+	if ((g_config.remoteHosts == nullptr) && (g_config.servePort == nullptr))
+		g_config.remoteHosts = getenv(DELTAMAKE_REMOTE_ENV);
+
+	if (g_config.servePort == nullptr)
+		remoteExecutor->Init(g_config.remoteHosts);
+
+	if (g_config.nMaxWorkers == 0) // Build nodes' slots are workers too
+		g_config.nMaxWorkers = g_config.nCores + remoteExecutor->GetCapacity();
+
+	if (g_config.cachePath == nullptr)
+		g_config.cachePath = getenv(DELTAMAKE_CACHE_ENV);
+
+	if (g_config.cacheSize == 0)
+		g_config.cacheSize = DELTAMAKE_CACHE_DEFAULT_SIZE;
 	
-	terminal->Log(LOG_DETAIL, "CPU Workers: %zu\n", g_config.nCores);
+	terminal->Log(LOG_DETAIL, "CPU Workers: %zu\n", g_config.nMaxWorkers);
+
+	if (g_config.nMinWorkers > g_config.nMaxWorkers)
+		g_config.nMinWorkers = g_config.nMaxWorkers;
 }
 
 /* ****************************************
@@ -7,19 +7,27 @@
 #include "SolutionCPP.h"
 
 #include <stddef.h>
+#include <ctype.h>
 
 #include <new>
 #include <fstream>
+#include <iterator>
 #include <filesystem>
 #include <chrono>
+#include <limits>
 #include <vector>
 #include <string>
+#include <algorithm>
+#include <utility>
 
 #include <json/json.h>
 
 #include "deltamake.h"
 #include "Terminal.h"
 #include "Exception.h"
+#include "FileStat.h"
+#include "Scanner.h"
+#include "Hash.h"
 
  
 using namespace DeltaMake;
@@ -57,17 +65,810 @@ DeltaMake::CSolutionCPP::CSolutionCPP(Json::Value& root, std::filesystem::path&
 }
 
 /* ****************************************
- * DeltaMake::CSolutionCPP::ScanFolders
+ * DeltaMake::CSolutionCPP::ScanHeaders
  */
-inline bool DeltaMake::CSolutionCPP::ScanFolders() { // TODO:
-	return false;
+inline bool DeltaMake::CSolutionCPP::ScanHeaders() {
+	m_headers.clear();
+	m_newestHeaders.clear();
+
+	const Json::Value& trees = static_cast<const Json::Value&>(m_diffFile)["c/cpp"]["headers"];
+	if (trees.isObject() == false) {
+		terminal->Log(LOG_DETAIL, "No header trees in diff. Ignoring...\n");
+		return true;
+	}
+
+	std::vector<std::pair<SHeaderFile*, size_t>> pending; // Header -> index of its path
+	std::map<Json::String, size_t> indices; // Builds share most of them
+	std::vector<std::filesystem::path> paths;
+	for (auto build = trees.begin(); build != trees.end(); ++build) {
+		THeaderMap& headers = m_headers[build.key().asString()];
+
+		for (auto header = (*build).begin(); header != (*build).end(); ++header) {
+			const Json::String key = header.key().asString();
+			SHeaderFile& rHeader = headers[key];
+
+			const Json::Value& files = *header;
+			for (Json::ArrayIndex i = 0; i < files.size(); ++i)
+				rHeader.files.insert(files[i].asString());
+
+			auto index = indices.emplace(key, paths.size());
+			if (index.second == true)
+				paths.push_back(m_currentPath / key);
+
+			pending.emplace_back(&rHeader, index.first->second);
+		}
+	}
+
+	std::vector<SFileStat> stats;
+	CFileStat::GetAll(paths, stats);
+
+	bool bAllExist = true;
+	for (size_t i = 0; i < pending.size(); ++i) {
+		const size_t index = pending[i].second;
+		if (stats[index].bExists == false) { // Includers will fail or don't need it anymore, so rebuild them
+			terminal->Log(LOG_DETAIL, "Header \"%s\" does not exist anymore\n", paths[index].c_str());
+			pending[i].first->mtime = std::numeric_limits<int64_t>::max();
+			bAllExist = false;
+			continue;
+		}
+
+		pending[i].first->mtime = stats[index].mtimeNs;
+	}
+
+	return bAllExist;
 }
 
 /* ****************************************
- * DeltaMake::CSolutionCPP::ScanHeaders
+ * DeltaMake::CSolutionCPP::MergeIncludes
+ */
+void DeltaMake::CSolutionCPP::MergeIncludes() {
+	if (static_cast<const Json::Value&>(m_diffFile)[SOLUTION_CPP_TYPE_NAME]["includes"].isObject() == false)
+		return; // Nothing journaled
+
+	Json::Value& cpp = m_diffFile[SOLUTION_CPP_TYPE_NAME];
+	const Json::Value& includes = cpp["includes"];
+	Json::Value& trees = cpp["headers"];
+	for (auto build = includes.begin(); build != includes.end(); ++build) {
+		Json::Value& tree = trees[build.key().asString()];
+		if (tree.isObject() == false)
+			tree = Json::Value(Json::objectValue);
+
+		// Journaled sources have new header lists, one pass removes the old ones
+		std::set<Json::String> sources;
+		for (auto source = (*build).begin(); source != (*build).end(); ++source)
+			sources.insert(source.key().asString());
+
+		for (auto header = tree.begin(); header != tree.end(); ++header) {
+			Json::Value files = Json::Value(Json::arrayValue);
+			for (Json::ArrayIndex i = 0; i < (*header).size(); ++i) {
+				if (sources.count((*header)[i].asString()) == 0)
+					files.append((*header)[i]);
+			}
+
+			header->swap(files);
+		}
+
+		for (auto source = (*build).begin(); source != (*build).end(); ++source) {
+			for (Json::ArrayIndex i = 0; i < (*source).size(); ++i) {
+				Json::Value& files = tree[(*source)[i].asString()];
+				if (files.isArray() == false)
+					files = Json::Value(Json::arrayValue);
+
+				files.append(source.key());
+			}
+		}
+	}
+
+	cpp.removeMember("includes");
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionCPP::LoadDiff
+ */
+inline bool DeltaMake::CSolutionCPP::LoadDiff(const char path[]) {
+	if (CSolutionDefault::LoadDiff(path) == false)
+		return false;
+
+	MergeIncludes();
+	ScanHeaders();
+
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionCPP::SaveDiff
+ */
+inline bool DeltaMake::CSolutionCPP::SaveDiff(const char path[]) {
+	Json::Value& trees = m_diffFile["c/cpp"]["headers"];
+	for (auto build = m_headers.begin(); build != m_headers.end(); ++build) {
+		Json::Value tree = Json::Value(Json::objectValue);
+
+		for (auto header = build->second.begin(); header != build->second.end(); ++header) {
+			if (header->second.files.size() == 0)
+				continue; // Nobody includes it anymore
+
+			Json::Value& files = tree[header->first];
+			files = Json::Value(Json::arrayValue);
+			for (auto file = header->second.files.begin(); file != header->second.files.end(); ++file)
+				files.append(*file);
+		}
+
+		trees[build->first] = tree;
+	}
+
+	return CSolutionDefault::SaveDiff(path);
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionCPP::GetSourceFlags
+ */
+std::string DeltaMake::CSolutionCPP::GetSourceFlags(const std::string& build, const SSourceFile& file, const std::filesystem::path& outPath) {
+	std::string flags = std::string("-MMD -MF \"") + outPath.c_str() + SOLUTION_CPP_DEPFILE_EXT "\" ";
+
+	static const std::set<std::string> interfaces = { ".cppm", ".ixx", ".mpp" };
+	const bool bModuleExtension = CScanner::IsMatch(file.path, interfaces);
+	auto graph = m_modules.find(build);
+	const SModuleUnit* unit = (graph != m_modules.end()) ? GetModuleUnit(graph->second, file) : nullptr;
+	if (unit == nullptr)
+		return (bModuleExtension == true) ? flags + "-x c++ " : flags; // Compilers don't know `.cppm` and others
+
+	if (graph->second.bClang == false) // BMIs of all modules are where the mapper says
+		return flags + ((bModuleExtension == true) ? "-x c++ " : "") + "-fmodules-ts -fmodule-mapper=\"" + graph->second.mapper.c_str() + "\" ";
+
+	if (unit->provides.size() != 0)
+		flags += "-fmodule-output=\"" + std::string(GetModulePath(graph->second, unit->provides[0]).c_str()) + "\" -x c++-module ";
+	else if (bModuleExtension == true)
+		flags += "-x c++ ";
+
+	return flags + "-fprebuilt-module-path=\"" + graph->second.directory.c_str() + "\" ";
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionCPP::IsSourceOutdated
+ */
+bool DeltaMake::CSolutionCPP::IsSourceOutdated(const std::string& build, const Json::String& source, int64_t builtTime) {
+	auto graph = m_modules.find(build);
+	if (graph != m_modules.end()) {
+		auto unit = graph->second.units.find(source);
+		SFileStat stat;
+		if ((unit != graph->second.units.end()) && (unit->second.provides.size() != 0) && (CFileStat::Get(GetModulePath(graph->second, unit->second.provides[0]).c_str(), stat) == false)) {
+			terminal->Log(LOG_DETAIL, "\"%s\" has no module interface file\n", source.c_str());
+			return true;
+		}
+	}
+
+	const int64_t newest = GetNewestHeader(build, source);
+	if ((newest == 0) || (newest < builtTime - DELTAMAKE_MTIME_SLACK))
+		return false; // No headers known, or they're older
+
+	terminal->Log(LOG_DETAIL, "\"%s\" has changed headers\n", source.c_str());
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionCPP::GetNewestHeader
+ */
+int64_t DeltaMake::CSolutionCPP::GetNewestHeader(const std::string& build, const Json::String& source) {
+	auto newest = m_newestHeaders.find(build);
+	if (newest == m_newestHeaders.end()) { // Let's turn the header tree upside down once per build
+		newest = m_newestHeaders.emplace(build, std::map<Json::String, int64_t>()).first;
+
+		auto headers = m_headers.find(build);
+		if (headers != m_headers.end()) {
+			for (auto header = headers->second.begin(); header != headers->second.end(); ++header) {
+				for (auto file = header->second.files.begin(); file != header->second.files.end(); ++file) {
+					int64_t& rTime = newest->second[*file];
+					if (header->second.mtime > rTime)
+						rTime = header->second.mtime;
+				}
+			}
+		}
+	}
+
+	auto time = newest->second.find(source);
+	return (time != newest->second.end()) ? time->second : 0;
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionCPP::OnSourceCompiled
+ */
+void DeltaMake::CSolutionCPP::OnSourceCompiled(const std::string& build, const Json::String& source, const std::filesystem::path& outPath) {
+	const std::filesystem::path depPath = std::string(outPath.c_str()) + SOLUTION_CPP_DEPFILE_EXT;
+
+	std::vector<std::string> deps;
+	if (ParseDepFile(depPath, deps) == false) {
+		terminal->Log(LOG_WARNING, "Can't read depfile \"%s\"\n", depPath.c_str());
+		return;
+	}
+
+	THeaderMap& headers = m_headers[build];
+
+	// The source may not include some headers anymore
+	for (auto header = headers.begin(); header != headers.end(); ++header)
+		header->second.files.erase(source);
+
+	// Compiler doesn't write the headers of the used precompiled header
+	auto precompiled = m_precompiled.find(build);
+	if ((precompiled != m_precompiled.end()) && (GetUnityExtension(m_sources[source]) == precompiled->second.extension))
+		deps.insert(deps.end(), precompiled->second.headers.begin(), precompiled->second.headers.end());
+
+	std::set<Json::String> keys;
+	Json::Value includes = Json::Value(Json::arrayValue);
+	for (size_t i = 0; i < deps.size(); ++i) {
+		const Json::String key = GetHeaderKey(deps[i]);
+		if ((m_sources.count(key) != 0) || (keys.insert(key).second == false))
+			continue; // Unity sources include the sources of the batch
+
+		headers.emplace(key, SHeaderFile()).first->second.files.insert(source);
+		includes.append(key);
+	}
+
+	RecordDiff({ SOLUTION_CPP_TYPE_NAME, "includes", build, source }, includes);
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionCPP::GetSourceInputs
+ */
+bool DeltaMake::CSolutionCPP::GetSourceInputs(const SSourceFile& /* file */, const std::filesystem::path& outPath, std::vector<std::string>& rInputs) const {
+	return ParseDepFile(std::string(outPath.c_str()) + SOLUTION_CPP_DEPFILE_EXT, rInputs);
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionCPP::SetSourceInputs
+ */
+void DeltaMake::CSolutionCPP::SetSourceInputs(const SSourceFile& file, const std::filesystem::path& outPath, const std::vector<std::string>& inputs) const {
+	std::ofstream depFile(std::string(outPath.c_str()) + SOLUTION_CPP_DEPFILE_EXT);
+
+	depFile << EscapeDepPath(outPath.string()) << ": " << EscapeDepPath(file.path.string());
+	for (size_t i = 0; i < inputs.size(); ++i)
+		depFile << " \\\n " << EscapeDepPath(inputs[i]);
+
+	depFile << "\n";
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionCPP::GetSourceExtensions
+ */
+const std::set<std::string>& DeltaMake::CSolutionCPP::GetSourceExtensions() const {
+	static const std::set<std::string> extensions = { ".c", ".cc", ".cpp", ".cxx", ".c++", ".cppm", ".ixx", ".mpp" }; // With module interfaces
+
+	return extensions;
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionCPP::GetUnityExtension
+ */
+std::string DeltaMake::CSolutionCPP::GetUnityExtension(const SSourceFile& file) const {
+	for (auto graph = m_modules.begin(); graph != m_modules.end(); ++graph) {
+		if (GetModuleUnit(graph->second, file) != nullptr)
+			return std::string(); // Module declaration must be the first one
+	}
+
+	return GetLanguage(file);
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionCPP::GetLanguage
  */
-inline bool DeltaMake::CSolutionCPP::ScanHeaders() { // TODO:
-	return false;
+std::string DeltaMake::CSolutionCPP::GetLanguage(const SSourceFile& file) const {
+	std::string extension = file.path.extension().string();
+	for (size_t i = 0; i < extension.size(); ++i)
+		extension[i] = static_cast<char>(tolower(static_cast<unsigned char>(extension[i])));
+
+	if (GetSourceExtensions().count(extension) == 0)
+		return std::string(); // Assembly and others are compiled alone
+
+	return (extension == ".c") ? ".c" : ".cpp";
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionCPP::WriteUnitySource
+ */
+bool DeltaMake::CSolutionCPP::WriteUnitySource(const std::filesystem::path& path, const std::vector<const SSourceFile*>& files) const {
+	std::ofstream file(path, std::ios::trunc);
+	for (size_t i = 0; i < files.size(); ++i)
+		file << "#include \"" << std::filesystem::absolute(files[i]->path).c_str() << "\"\n";
+
+	return file.good();
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionCPP::GenPrecompiledHeader
+ */
+bool DeltaMake::CSolutionCPP::GenPrecompiledHeader(const std::string& build, const Json::Value& config, const std::string& compiler, SPrecompiledHeader& rHeader) {
+	const Json::Value& members = static_cast<const Json::Value&>(m_diffFile)["c/cpp"]["pch"][build];
+	std::set<Json::String> current;
+	for (Json::ArrayIndex i = 0; (members.isArray() == true) && (i < members.size()); ++i)
+		current.insert(members[i].asString());
+
+	m_diffFile["c/cpp"]["pch"].removeMember(build);
+	SPrecompiled& rPrecompiled = m_precompiled[build];
+	rPrecompiled = SPrecompiled();
+
+	auto headers = m_headers.find(build);
+	if ((headers == m_headers.end()) || (m_sources.size() < SOLUTION_CPP_PCH_MIN_SOURCES))
+		return false; // Nothing is known before the first build
+
+	const double share = ((config.isObject() == true) && (config["share"].isNumeric() == true)) ? config["share"].asDouble() : SOLUTION_CPP_PCH_SHARE;
+
+	// Language of most sources
+	size_t nC = 0;
+	for (auto iterator = m_sources.begin(); iterator != m_sources.end(); ++iterator) {
+		if (GetUnityExtension(iterator->second) == ".c")
+			++nC;
+	}
+
+	rHeader.extension = (nC * 2 > m_sources.size()) ? ".c" : ".cpp";
+	rHeader.header = m_tmpPath / (build + "_pch" + ((rHeader.extension == ".c") ? ".h" : ".hpp"));
+
+	const std::filesystem::path tmpPath = std::filesystem::absolute(m_tmpPath).lexically_normal();
+	const std::filesystem::path buildPath = std::filesystem::absolute(m_buildPath).lexically_normal();
+	auto isInside = [](const std::filesystem::path& path, const std::filesystem::path& directory) {
+		const std::filesystem::path relative = path.lexically_relative(directory);
+		return (relative.empty() == false) && (*relative.begin() != "..");
+	};
+
+	const time_t now = time(nullptr);
+	std::string content;
+	for (auto header = headers->second.begin(); header != headers->second.end(); ++header) {
+		const std::filesystem::path key = header->first;
+		if (key.is_absolute() == true)
+			continue; // System and other libraries' headers may be not for direct include
+
+		const std::filesystem::path path = (m_currentPath / key).lexically_normal();
+		if ((isInside(path, tmpPath) == true) || (isInside(path, buildPath) == true))
+			continue; // Generated
+
+		if (header->second.mtime == std::numeric_limits<int64_t>::max())
+			continue; // Does not exist anymore
+
+		const time_t mtime = static_cast<time_t>(header->second.mtime / 1000000000);
+
+		if (static_cast<double>(header->second.files.size()) < share * static_cast<double>(m_sources.size()))
+			continue;
+
+		// A header being edited would compile all again with every change, so it's added when it's stable
+		if ((current.count(header->first) == 0) && (now - mtime < SOLUTION_CPP_PCH_STABLE_TIME)) {
+			rHeader.expires = std::min(rHeader.expires, mtime + SOLUTION_CPP_PCH_STABLE_TIME);
+			continue;
+		}
+
+		rPrecompiled.headers.push_back(header->first);
+		rHeader.newest = std::max(rHeader.newest, header->second.mtime);
+		content += "#include \"" + std::string(path.c_str()) + "\"\n";
+	}
+
+	rHeader.nHeaders = rPrecompiled.headers.size();
+	if (rHeader.nHeaders == 0) {
+		m_precompiled.erase(build);
+		return false;
+	}
+
+	rPrecompiled.extension = rHeader.extension;
+
+	Json::Value& rNewMembers = m_diffFile["c/cpp"]["pch"][build];
+	rNewMembers = Json::Value(Json::arrayValue);
+	for (size_t i = 0; i < rPrecompiled.headers.size(); ++i)
+		rNewMembers.append(rPrecompiled.headers[i]);
+
+	// Same content keeps the mtime, so the precompiled header stays valid
+	std::ifstream oldFile(rHeader.header);
+	const std::string oldContent((std::istreambuf_iterator<char>(oldFile)), std::istreambuf_iterator<char>());
+	if (oldContent != content) {
+		std::ofstream file(rHeader.header, std::ios::trunc);
+		file << content;
+
+		if (file.good() == false) {
+			terminal->Log(LOG_WARNING, "Can't write \"%s\"\n", rHeader.header.c_str());
+			m_precompiled.erase(build);
+			return false;
+		}
+
+		rHeader.newest = std::numeric_limits<int64_t>::max();
+	}
+
+	const char* language = (rHeader.extension == ".c") ? "c-header" : "c++-header";
+	rHeader.compileFlags = std::string("-x ") + language + " ";
+	rHeader.preprocessFlags = "-include \"" + std::string(rHeader.header.c_str()) + "\" ";
+
+	if (compiler.find("clang") != std::string::npos) {
+		rHeader.outPath = std::string(rHeader.header.c_str()) + ".pch";
+		rHeader.useFlags = "-include-pch \"" + std::string(rHeader.outPath.c_str()) + "\" ";
+	}
+	else { // GCC uses `<header>.gch` instead of the header
+		rHeader.outPath = std::string(rHeader.header.c_str()) + ".gch";
+		rHeader.useFlags = "-include \"" + std::string(rHeader.header.c_str()) + "\" -Winvalid-pch ";
+	}
+
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionCPP::GenScanTasks
+ */
+size_t DeltaMake::CSolutionCPP::GenScanTasks(ITaskList* taskList, const std::string& build, const Json::Value& config, const std::string& compiler, const std::string& flagsBegin) {
+	m_modules.erase(build);
+
+	const Json::Value& oldModules = static_cast<const Json::Value&>(m_diffFile)[SOLUTION_CPP_TYPE_NAME]["modules"];
+	if ((config.isObject() == false) && ((config.isBool() == false) || (config.asBool() == false))) {
+		if (oldModules.isMember(build) == true)
+			m_diffFile[SOLUTION_CPP_TYPE_NAME]["modules"].removeMember(build);
+
+		return 0;
+	}
+
+	SModuleGraph& rGraph = m_modules[build];
+	rGraph.bClang = std::filesystem::path(compiler).filename().string().find("clang") != std::string::npos;
+	rGraph.directory = m_tmpPath / (build + "_modules");
+	rGraph.mapper = m_tmpPath / (build + "_modules.map");
+
+	// Scanners preprocess the source the way it's compiled
+	std::string scanner;
+	if ((config.isObject() == true) && (config["scanner"].isString() == true))
+		scanner = config["scanner"].asString();
+	else if (rGraph.bClang == true)
+		scanner = SOLUTION_CPP_MODULES_SCANNER;
+
+	const std::string scanBegin = (scanner.size() != 0) ? scanner + " -format=p1689 -- " + flagsBegin : flagsBegin + "-fmodules-ts -E -x c++ ";
+
+	CHash scanHash;
+	scanHash.Update(scanBegin);
+	rGraph.scanKey = CHash::ToString(scanHash.Digest());
+	rGraph.scanTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+	std::error_code error;
+	std::filesystem::create_directories(rGraph.directory, error);
+
+	// Sources of the diff that are not C++ anymore are dropped too
+	Json::Value oldEntries;
+	Json::Value& rEntries = m_diffFile[SOLUTION_CPP_TYPE_NAME]["modules"][build];
+	rEntries.swap(oldEntries);
+	rEntries = Json::Value(Json::objectValue);
+
+	for (auto iterator = m_sources.begin(); iterator != m_sources.end(); ++iterator) {
+		if (GetLanguage(iterator->second) != ".cpp")
+			continue;
+
+		// Headers may change the imports too
+		const Json::Value& entry = static_cast<const Json::Value&>(oldEntries)[iterator->first];
+		if ((entry.isObject() == true) && (entry["cmd"] == rGraph.scanKey) && (entry["mtime"].asInt64() == iterator->second.mtimeNs) && (GetNewestHeader(build, iterator->first) < entry["scanned"].asInt64() - DELTAMAKE_MTIME_SLACK)) {
+			SModuleUnit& rUnit = rGraph.cached[iterator->first];
+			for (Json::ArrayIndex i = 0; i < entry["provides"].size(); ++i)
+				rUnit.provides.push_back(entry["provides"][i].asString());
+
+			for (Json::ArrayIndex i = 0; i < entry["imports"].size(); ++i)
+				rUnit.imports.push_back(entry["imports"][i].asString());
+
+			rEntries[iterator->first] = entry;
+			continue;
+		}
+
+		CHash hash;
+		hash.Update(iterator->first);
+
+		SModuleScan scan;
+		scan.source = iterator->first;
+		scan.path = rGraph.directory / (std::string(iterator->second.path.stem()) + "_" + CHash::ToString(hash.Digest()) + SOLUTION_CPP_MODULES_EXT);
+
+		const std::string source = "\"" + std::string(iterator->second.path.c_str()) + "\"";
+		const std::string path = "\"" + std::string(scan.path.c_str()) + "\"";
+		const std::string target = "\"" + std::filesystem::path(scan.path).replace_extension(".o").string() + "\""; // Only named in the scan
+		if (scanner.size() != 0) // Writes P1689 to `stdout`
+			scan.command = scanBegin + "-c " + source + " -o " + target;
+		else
+			scan.command = scanBegin + source + " -MT " + path + " -MD -MF \"" + scan.path.c_str() + ".d\" -fdeps-format=p1689r5 -fdeps-file=" + path + " -fdeps-target=" + target + " -o /dev/null";
+
+		// Failed scan leaves nothing, not the last one
+		std::filesystem::remove(scan.path, error);
+
+		const TaskHandle task = taskList->AddCommand(("Scan " + std::string(iterator->second.path.filename())).c_str(), scan.command, {}, false);
+		if (task == DELTAMAKE_TASK_NONE)
+			continue;
+
+		if (scanner.size() != 0)
+			taskList->SetOutputFile(task, scan.path);
+
+		rGraph.scans.push_back(scan);
+	}
+
+	return rGraph.scans.size();
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionCPP::ScanSourceDeps
+ */
+void DeltaMake::CSolutionCPP::ScanSourceDeps(const std::string& build) {
+	auto graph = m_modules.find(build);
+	if (graph == m_modules.end())
+		return;
+
+	SModuleGraph& rGraph = graph->second;
+	Json::Value& rEntries = m_diffFile[SOLUTION_CPP_TYPE_NAME]["modules"][build];
+
+	std::map<Json::String, SModuleUnit> units;
+	units.swap(rGraph.cached);
+
+	for (size_t i = 0; i < rGraph.scans.size(); ++i) {
+		const SModuleScan& scan = rGraph.scans[i];
+
+		SModuleUnit unit;
+		if (ParseModuleDeps(scan.path, unit) == false) { // Scanned again next time, its task and its compile show the errors
+			terminal->Log(LOG_WARNING, "Can't scan modules of \"%s\":\n\t%s\n", scan.source.c_str(), scan.command.c_str());
+			continue;
+		}
+
+		Json::Value& rEntry = rEntries[scan.source];
+		rEntry["mtime"] = static_cast<Json::Int64>(m_sources[scan.source].mtimeNs);
+		rEntry["scanned"] = static_cast<Json::Int64>(rGraph.scanTime);
+		rEntry["cmd"] = rGraph.scanKey;
+
+		Json::Value& rProvides = rEntry["provides"];
+		rProvides = Json::Value(Json::arrayValue);
+		for (size_t j = 0; j < unit.provides.size(); ++j)
+			rProvides.append(unit.provides[j]);
+
+		Json::Value& rImports = rEntry["imports"];
+		rImports = Json::Value(Json::arrayValue);
+		for (size_t j = 0; j < unit.imports.size(); ++j)
+			rImports.append(unit.imports[j]);
+
+		units[scan.source] = unit;
+	}
+
+	const size_t nScans = rGraph.scans.size();
+	rGraph.scans.clear();
+
+	// Graph of the module units only
+	std::string mapper;
+	for (auto unit = units.begin(); unit != units.end(); ++unit) {
+		if ((unit->second.provides.size() == 0) && (unit->second.imports.size() == 0))
+			continue;
+
+		for (size_t i = 0; i < unit->second.provides.size(); ++i) {
+			auto provider = rGraph.providers.emplace(unit->second.provides[i], unit->first);
+			if (provider.second == false) {
+				terminal->Log(LOG_WARNING, "Module \"%s\" is provided by \"%s\" and \"%s\"\n", unit->second.provides[i].c_str(), provider.first->second.c_str(), unit->first.c_str());
+				continue;
+			}
+
+			mapper += unit->second.provides[i] + " " + GetModulePath(rGraph, unit->second.provides[i]).c_str() + "\n";
+		}
+
+		rGraph.files[&m_sources[unit->first]] = unit->first;
+		rGraph.units[unit->first] = std::move(unit->second);
+	}
+
+	terminal->Log(LOG_DETAIL, "Modules: %zu provided by %zu of %zu C++ sources, %zu scanned\n", rGraph.providers.size(), rGraph.units.size(), units.size(), nScans);
+
+	if (rGraph.bClang == true)
+		return; // Prebuilt module path
+
+	// Same content keeps the mtime
+	std::ifstream oldFile(rGraph.mapper);
+	const std::string oldMapper((std::istreambuf_iterator<char>(oldFile)), std::istreambuf_iterator<char>());
+	if (oldMapper != mapper) {
+		std::ofstream file(rGraph.mapper, std::ios::trunc);
+		file << mapper;
+	}
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionCPP::GetSourceDeps
+ */
+void DeltaMake::CSolutionCPP::GetSourceDeps(const std::string& build, const Json::String& source, std::vector<Json::String>& rDeps) const {
+	auto graph = m_modules.find(build);
+	if (graph == m_modules.end())
+		return;
+
+	auto unit = graph->second.units.find(source);
+	if (unit == graph->second.units.end())
+		return;
+
+	for (size_t i = 0; i < unit->second.imports.size(); ++i) {
+		auto provider = graph->second.providers.find(unit->second.imports[i]);
+		if (provider == graph->second.providers.end()) { // Standard library and header units are the compiler's business
+			terminal->Log(LOG_DETAIL, "\"%s\" imports \"%s\" that is not in the build\n", source.c_str(), unit->second.imports[i].c_str());
+			continue;
+		}
+
+		if (provider->second != source)
+			rDeps.push_back(provider->second);
+	}
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionCPP::ParseModuleDeps
+ */
+bool DeltaMake::CSolutionCPP::ParseModuleDeps(const std::filesystem::path& path, SModuleUnit& rUnit) {
+	std::ifstream file(path);
+	Json::Value root;
+	Json::CharReaderBuilder builder;
+	if ((file.good() == false) || (Json::parseFromStream(builder, file, &root, nullptr) == false) || (root["rules"].isArray() == false))
+		return false;
+
+	const Json::Value& rules = root["rules"];
+	for (Json::ArrayIndex i = 0; i < rules.size(); ++i) {
+		const Json::Value& provides = rules[i]["provides"];
+		for (Json::ArrayIndex j = 0; (provides.isArray() == true) && (j < provides.size()); ++j) {
+			if (provides[j]["logical-name"].isString() == true)
+				rUnit.provides.push_back(provides[j]["logical-name"].asString());
+		}
+
+		const Json::Value& imports = rules[i]["requires"];
+		for (Json::ArrayIndex j = 0; (imports.isArray() == true) && (j < imports.size()); ++j) {
+			if ((imports[j]["logical-name"].isString() == true) && (imports[j]["lookup-method"].isNull() == true)) // Header units have one
+				rUnit.imports.push_back(imports[j]["logical-name"].asString());
+		}
+	}
+
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionCPP::GetModulePath
+ */
+std::filesystem::path DeltaMake::CSolutionCPP::GetModulePath(const SModuleGraph& graph, const Json::String& name) {
+	std::string fileName = name;
+	std::replace(fileName.begin(), fileName.end(), ':', '-'); // Partitions like clang names them
+
+	return graph.directory / (fileName + ((graph.bClang == true) ? ".pcm" : ".gcm"));
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionCPP::GetModuleUnit
+ */
+const DeltaMake::SModuleUnit* DeltaMake::CSolutionCPP::GetModuleUnit(const SModuleGraph& graph, const SSourceFile& file) {
+	auto key = graph.files.find(&file);
+	if (key == graph.files.end())
+		return nullptr;
+
+	return &graph.units.at(key->second);
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionCPP::GetWatchPaths
+ */
+void DeltaMake::CSolutionCPP::GetWatchPaths(std::vector<std::filesystem::path>& rPaths) const {
+	CSolutionDefault::GetWatchPaths(rPaths);
+
+	std::set<Json::String> keys; // Builds share headers
+	for (auto build = m_headers.begin(); build != m_headers.end(); ++build) {
+		for (auto header = build->second.begin(); header != build->second.end(); ++header) {
+			if ((header->second.files.size() != 0) && (keys.insert(header->first).second == true))
+				rPaths.push_back(m_currentPath / header->first);
+		}
+	}
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionCPP::Update
+ */
+bool DeltaMake::CSolutionCPP::Update(const std::set<std::filesystem::path>& changed) {
+	bool bChanged = CSolutionDefault::Update(changed);
+
+	for (auto build = m_headers.begin(); build != m_headers.end(); ++build) {
+		for (auto header = build->second.begin(); header != build->second.end(); ++header) {
+			const std::filesystem::path path = m_currentPath / header->first;
+			if (IsChanged(changed, path) == false)
+				continue;
+
+			SFileStat stat;
+			const int64_t mtime = (CFileStat::Get(path.c_str(), stat) == true) ? stat.mtimeNs : std::numeric_limits<int64_t>::max();
+			if (mtime == header->second.mtime)
+				continue;
+
+			terminal->Log(LOG_DETAIL, "Header \"%s\" is changed\n", header->first.c_str());
+			header->second.mtime = mtime;
+			bChanged = true;
+		}
+	}
+
+	if (bChanged == true)
+		m_newestHeaders.clear(); // Turned upside down again by the next build
+
+	return bChanged;
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionCPP::ParseDepFile
+ */
+bool DeltaMake::CSolutionCPP::ParseDepFile(const std::filesystem::path& path, std::vector<std::string>& rDeps) {
+	std::ifstream file(path);
+	if (file.good() == false)
+		return false;
+
+	const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	// "target: source header1 \\\n header2"
+	size_t i = 0;
+	for (; i < content.size(); ++i) {
+		if ((content[i] == ':') && ((i + 1 == content.size()) || (isspace(content[i + 1]) != 0)))
+			break;
+	}
+
+	if (i == content.size())
+		return false;
+
+	std::string token;
+	bool bSource = true; // The first prerequisite is the source itself
+	auto flush = [&]() {
+		if (token.size() == 0)
+			return;
+
+		if (bSource == true)
+			bSource = false;
+		else
+			rDeps.push_back(token);
+
+		token.clear();
+	};
+
+	for (++i; i < content.size(); ++i) {
+		const char ch = content[i];
+		const char next = (i + 1 < content.size()) ? content[i + 1] : '\0';
+
+		if (ch == '\\') {
+			if (next == '\n') { // Line continuation
+				flush();
+				++i;
+				continue;
+			}
+
+			if ((next == ' ') || (next == '#') || (next == '\\')) { // Escaped
+				token += next;
+				++i;
+				continue;
+			}
+		}
+		else if ((ch == '$') && (next == '$')) {
+			token += '$';
+			++i;
+			continue;
+		}
+		else if (ch == '\n') { // End of the rule
+			break;
+		}
+		else if (isspace(ch) != 0) {
+			flush();
+			continue;
+		}
+
+		token += ch;
+	}
+
+	flush();
+
+	return true;
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionCPP::EscapeDepPath
+ */
+std::string DeltaMake::CSolutionCPP::EscapeDepPath(const std::string& path) {
+	std::string escaped;
+	for (size_t i = 0; i < path.size(); ++i) {
+		if ((path[i] == ' ') || (path[i] == '#') || (path[i] == '\\'))
+			escaped += '\\';
+		else if (path[i] == '$')
+			escaped += '$';
+
+		escaped += path[i];
+	}
+
+	return escaped;
+}
+
+/* ****************************************
+ * DeltaMake::CSolutionCPP::GetHeaderKey
+ */
+Json::String DeltaMake::CSolutionCPP::GetHeaderKey(const std::string& path) const {
+	const std::filesystem::path absolute = std::filesystem::absolute(path).lexically_normal();
+	const std::filesystem::path relative = absolute.lexically_relative(m_currentPath);
+
+	if ((relative.empty() == false) && (*relative.begin() != ".."))
+		return relative.string();
+
+	return absolute.string();
 }
 
 // ******************************************************************************** //
@@ -11,7 +11,9 @@
 
 #include <vector>
 #include <map>
+#include <set>
 #include <string>
+#include <filesystem>
 
 #include <json/json.h>
 
@@ -21,6 +23,12 @@
 
 
 #define SOLUTION_CPP_TYPE_NAME			"c/cpp"
+#define SOLUTION_CPP_DEPFILE_EXT		".d"
+#define SOLUTION_CPP_PCH_SHARE			0.8 // Of the sources that include a header of the precompiled header, if `pch.share` is not set
+#define SOLUTION_CPP_PCH_MIN_SOURCES	4 // Less sources don't pay for the precompiled header compile
+#define SOLUTION_CPP_PCH_STABLE_TIME	3600 // s, a header changed so recently is not added to the precompiled header
+#define SOLUTION_CPP_MODULES_EXT		".ddi" // P1689 dependency info of the module scan
+#define SOLUTION_CPP_MODULES_SCANNER	"clang-scan-deps" // Of clang, if `modules.scanner` is not set
 
  
 // ******************************************************************************** //
@@ -31,8 +39,47 @@ namespace DeltaMake {
 	 * C/C++ header file state
 	 */
 	struct SHeaderFile {
-		std::vector<SSourceFile*>		files;
-		time_t							mtime;
+		std::set<Json::String>			files; /* Sources that include the header */
+		int64_t							mtime; /* ns */
+	};
+
+	/**
+	 * Header tree of a build: header path -> header
+	 */
+	typedef std::map<Json::String, SHeaderFile> THeaderMap;
+
+	/**
+	 * C++20 module names of a source, from the P1689 scan
+	 */
+	struct SModuleUnit {
+		std::vector<Json::String>		provides; /* Exported module or partition */
+		std::vector<Json::String>		imports;
+	};
+
+	/**
+	 * Scan task of one source
+	 */
+	struct SModuleScan {
+		Json::String					source;
+		std::string						command;
+		std::filesystem::path			path; /* Dependency info */
+	};
+
+	/**
+	 * Modules of a build (`modules` of the build)
+	 */
+	struct SModuleGraph {
+		std::map<Json::String, SModuleUnit> units; /* Source -> its modules, only sources that have some */
+		std::map<Json::String, Json::String> providers; /* Module -> source of its interface */
+		std::map<const SSourceFile*, Json::String> files; /* Source of `units` -> its key */
+		std::filesystem::path			directory; /* Of the BMIs and the scans */
+		std::filesystem::path			mapper; /* Module mapper file of GCC */
+		bool							bClang									= false; /* Flags of clang, not of GCC */
+
+		std::map<Json::String, SModuleUnit> cached; /* C++ sources not scanned again, from the diff */
+		std::vector<SModuleScan>		scans; /* Tasks of `GenScanTasks()` */
+		std::string						scanKey; /* Hash of the scan command */
+		int64_t							scanTime								= 0; /* ns, before the scans */
 	};
 
 	/**
@@ -43,15 +90,151 @@ namespace DeltaMake {
 										CSolutionCPP(Json::Value& root, std::filesystem::path& currentPath);
 			virtual						~CSolutionCPP() override				= default;
 
-			virtual bool				ScanFolders() override;
+			/**
+			 * Load header trees from the diff and get modification times of headers
+			 * 
+			 * \returns `false` if some header does not exist anymore
+			 */
 			virtual bool				ScanHeaders();
 
+			/**
+			 * Move the header lists of the journaled sources into the header trees
+			 */
+			void						MergeIncludes();
+
+			virtual bool				LoadDiff(const char path[]) override;
+			virtual bool				SaveDiff(const char path[]) override;
+
 			static IPlugin*				GetInstance();
 
 		protected:
+			/**
+			 * Compiler writes the header tree of the source with `-MMD`, module units get their BMI flags
+			 */
+			virtual std::string			GetSourceFlags(const std::string& build, const SSourceFile& file, const std::filesystem::path& outPath) override;
+
+			/**
+			 * Is some included header changed since `builtTime`, or the BMI of the module interface missing
+			 */
+			virtual bool				IsSourceOutdated(const std::string& build, const Json::String& source, int64_t builtTime) override;
+
+			/**
+			 * Update header tree from the compiler depfile
+			 */
+			virtual void				OnSourceCompiled(const std::string& build, const Json::String& source, const std::filesystem::path& outPath) override;
+
+			/**
+			 * Headers of the depfile
+			 */
+			virtual bool				GetSourceInputs(const SSourceFile& file, const std::filesystem::path& outPath, std::vector<std::string>& rInputs) const override;
+
+			/**
+			 * Write the depfile, like the compiler does with `-MMD`
+			 */
+			virtual void				SetSourceInputs(const SSourceFile& file, const std::filesystem::path& outPath, const std::vector<std::string>& inputs) const override;
+
+			/**
+			 * C and C++ sources
+			 */
+			virtual const std::set<std::string>& GetSourceExtensions() const override;
+
+			/**
+			 * C sources are in `.c` unity sources, C++ ones are in `.cpp`, module units are compiled alone
+			 */
+			virtual std::string			GetUnityExtension(const SSourceFile& file) const override;
+
+			/**
+			 * `#include` of every file
+			 */
+			virtual bool				WriteUnitySource(const std::filesystem::path& path, const std::vector<const SSourceFile*>& files) const override;
+
+			/**
+			 * Headers of the solution included by most sources of the build, by the header tree
+			 */
+			virtual bool				GenPrecompiledHeader(const std::string& build, const Json::Value& config, const std::string& compiler, SPrecompiledHeader& rHeader) override;
+
+			/**
+			 * Task of the P1689 scanner of the compiler for every C++ source changed since its last scan
+			 */
+			virtual size_t				GenScanTasks(ITaskList* taskList, const std::string& build, const Json::Value& config, const std::string& compiler, const std::string& flagsBegin) override;
+
+			/**
+			 * Map the modules of the scans to the sources that provide them
+			 */
+			virtual void				ScanSourceDeps(const std::string& build) override;
+
+			/**
+			 * Interfaces of the imported modules
+			 */
+			virtual void				GetSourceDeps(const std::string& build, const Json::String& source, std::vector<Json::String>& rDeps) const override;
+
+			/**
+			 * Parse P1689 dependency info of one source
+			 * 
+			 * \returns `false` if it's not valid
+			 */
+			static bool					ParseModuleDeps(const std::filesystem::path& path, SModuleUnit& rUnit);
+
+			/**
+			 * \returns BMI of the module in the directory of the build
+			 */
+			static std::filesystem::path GetModulePath(const SModuleGraph& graph, const Json::String& name);
+
+			/**
+			 * \returns Modules of the source, `nullptr` if it has none
+			 */
+			static const SModuleUnit*	GetModuleUnit(const SModuleGraph& graph, const SSourceFile& file);
+
+			/**
+			 * \returns `.c`, `.cpp` or empty for other sources
+			 */
+			std::string					GetLanguage(const SSourceFile& file) const;
+
+			/**
+			 * \returns mtime of the newest header included by the source in ns, `0` if none is known
+			 */
+			int64_t						GetNewestHeader(const std::string& build, const Json::String& source);
+
+			/**
+			 * Included headers are inputs too
+			 */
+			virtual void				GetWatchPaths(std::vector<std::filesystem::path>& rPaths) const override;
+
+			/**
+			 * Get modification times of the changed headers again
+			 */
+			virtual bool				Update(const std::set<std::filesystem::path>& changed) override;
+
+			/**
+			 * Parse make rule of depfile
+			 * 
+			 * \param rDeps Prerequisites without the source itself
+			 */
+			static bool					ParseDepFile(const std::filesystem::path& path, std::vector<std::string>& rDeps);
+
+			/**
+			 * \returns Path escaped for a make rule
+			 */
+			static std::string			EscapeDepPath(const std::string& path);
+
+			/**
+			 * \returns Header path relative to the solution if it's inside
+			 */
+			Json::String				GetHeaderKey(const std::string& path) const;
+
+			std::map<std::string, THeaderMap> m_headers; /* Build name -> header tree */
+			std::map<std::string, std::map<Json::String, int64_t>> m_newestHeaders; /* Build name -> source -> mtime of its newest header */
 
-			std::map<Json::String, SHeaderFile> m_headers;
+			/**
+			 * Precompiled header of a build
+			 */
+			struct SPrecompiled {
+				std::string				extension; /* Of the sources that use it */
+				std::vector<Json::String> headers; /* Keys of the header tree */
+			};
 
+			std::map<std::string, SPrecompiled> m_precompiled; /* Build name -> its precompiled header */
+			std::map<std::string, SModuleGraph> m_modules; /* Build name -> its modules */
 	};
 }
 
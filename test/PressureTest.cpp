@@ -0,0 +1,141 @@
+/**
+ * \file	PressureTest.cpp
+ * \brief	Parsing of PSI and `loadavg`, and the worker count of `--adaptive`
+ * \date	14 oct 2026
+ * \author	Reklov
+ *
+ * g++ --std=c++17 -Wall -I/usr/include/jsoncpp -I./source/ ./test/PressureTest.cpp ./source/Pressure.cpp -o pressuretest
+ * ./pressuretest
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Pressure.h"
+
+using namespace DeltaMake;
+
+// ******************************************************************************** //
+
+#define TEST_CHECK(condition)			Check((condition), #condition, __LINE__)
+
+static DeltaMake::SConfig g_config;
+extern DeltaMake::SConfig* const DeltaMake::config = &g_config;
+
+static size_t g_nFailed = 0;
+
+/**
+ * Records and prints a failed check
+ */
+static void Check(bool bPassed, const char condition[], int line) {
+	if (bPassed == true)
+		return;
+
+	fprintf(stderr, "PressureTest.cpp:%d: %s\n", line, condition);
+	++g_nFailed;
+}
+
+/**
+ * \returns The pressure of the given shares
+ */
+static SPressure MakePressure(double cpu, double memory) {
+	SPressure pressure;
+	pressure.cpu = cpu;
+	pressure.memory = memory;
+	return pressure;
+}
+
+/**
+ * Recorded `/proc/pressure/cpu` and `/proc/pressure/memory`
+ */
+static void TestPsi() {
+	uint64_t total = 0;
+	TEST_CHECK(CPressureMonitor::ParsePsi(
+		"some avg10=1.53 avg60=0.87 avg300=0.35 total=2860575\n"
+		"full avg10=0.00 avg60=0.00 avg300=0.00 total=0\n", total) == true);
+	TEST_CHECK(total == 2860575);
+
+	// `full` is only in the file since Linux 5.13, for the CPU
+	TEST_CHECK(CPressureMonitor::ParsePsi("some avg10=0.00 avg60=0.00 avg300=0.00 total=18446744073709551\n", total) == true);
+	TEST_CHECK(total == 18446744073709551ull);
+
+	total = 42;
+	TEST_CHECK(CPressureMonitor::ParsePsi("", total) == false);
+	TEST_CHECK(CPressureMonitor::ParsePsi("full avg10=0.00 avg60=0.00 avg300=0.00 total=7\n", total) == false);
+	TEST_CHECK(CPressureMonitor::ParsePsi("some avg10=0.00 avg60=0.00\n", total) == false);
+	TEST_CHECK(total == 42);
+
+	TEST_CHECK(CPressureMonitor::GetStallShare(1250000, 1000000, 1000000) == 0.25);
+	TEST_CHECK(CPressureMonitor::GetStallShare(3000000, 1000000, 1000000) == 1.0);
+	TEST_CHECK(CPressureMonitor::GetStallShare(1000000, 1000000, 1000000) == 0.0);
+	TEST_CHECK(CPressureMonitor::GetStallShare(500000, 1000000, 1000000) == 0.0); // Counter reset
+	TEST_CHECK(CPressureMonitor::GetStallShare(1000, 0, 0) == 0.0);
+}
+
+/**
+ * Recorded `/proc/loadavg`
+ */
+static void TestLoad() {
+	size_t runnable = 0;
+	TEST_CHECK(CPressureMonitor::ParseLoad("0.50 0.40 0.30 5/345 6789\n", runnable) == true);
+	TEST_CHECK(runnable == 4);
+	TEST_CHECK(CPressureMonitor::ParseLoad("12.08 9.71 6.02 17/1503 412399\n", runnable) == true);
+	TEST_CHECK(runnable == 16);
+	TEST_CHECK(CPressureMonitor::ParseLoad("0.00 0.00 0.00 0/98 1\n", runnable) == true);
+	TEST_CHECK(runnable == 0);
+
+	runnable = 42;
+	TEST_CHECK(CPressureMonitor::ParseLoad("", runnable) == false);
+	TEST_CHECK(CPressureMonitor::ParseLoad("0.50 0.40\n", runnable) == false);
+	TEST_CHECK(runnable == 42);
+
+	TEST_CHECK(CPressureMonitor::GetLoadShare(4, 8) == 0.0);
+	TEST_CHECK(CPressureMonitor::GetLoadShare(8, 8) == 0.0);
+	TEST_CHECK(CPressureMonitor::GetLoadShare(16, 8) == 0.5);
+}
+
+/**
+ * Worker count of `--adaptive`
+ */
+static void TestWorkers() {
+	// Scale up by one, only if tasks wait for a worker
+	TEST_CHECK(CPressureMonitor::GetWorkers(MakePressure(0.05, 0.0), 4, 1, 8, true) == 5);
+	TEST_CHECK(CPressureMonitor::GetWorkers(MakePressure(0.05, 0.0), 4, 1, 8, false) == 4);
+	TEST_CHECK(CPressureMonitor::GetWorkers(MakePressure(0.05, 0.0), 8, 1, 8, true) == 8);
+
+	// Hysteresis between the low and high marks
+	TEST_CHECK(CPressureMonitor::GetWorkers(MakePressure(DELTAMAKE_ADAPTIVE_CPU_LOW, 0.0), 4, 1, 8, true) == 4);
+	TEST_CHECK(CPressureMonitor::GetWorkers(MakePressure(0.20, 0.0), 4, 1, 8, true) == 4);
+	TEST_CHECK(CPressureMonitor::GetWorkers(MakePressure(DELTAMAKE_ADAPTIVE_CPU_HIGH, 0.0), 4, 1, 8, true) == 4);
+
+	// Scale down by a quarter and one
+	TEST_CHECK(CPressureMonitor::GetWorkers(MakePressure(0.50, 0.0), 8, 1, 8, true) == 5);
+	TEST_CHECK(CPressureMonitor::GetWorkers(MakePressure(0.50, 0.0), 3, 1, 8, false) == 2);
+	TEST_CHECK(CPressureMonitor::GetWorkers(MakePressure(0.50, 0.0), 1, 1, 8, false) == 1);
+	TEST_CHECK(CPressureMonitor::GetWorkers(MakePressure(0.50, 0.0), 8, 6, 8, false) == 6);
+
+	// Memory stalls halve them, before the CPU is looked at
+	TEST_CHECK(CPressureMonitor::GetWorkers(MakePressure(0.0, 0.10), 8, 1, 8, true) == 4);
+	TEST_CHECK(CPressureMonitor::GetWorkers(MakePressure(0.0, 0.10), 8, 6, 8, true) == 6);
+	TEST_CHECK(CPressureMonitor::GetWorkers(MakePressure(0.0, DELTAMAKE_ADAPTIVE_MEMORY_HIGH), 4, 1, 8, true) == 5);
+
+	// Clamped to the minimum, the workers and one
+	TEST_CHECK(CPressureMonitor::GetWorkers(MakePressure(0.20, 0.0), 2, 4, 8, false) == 4);
+	TEST_CHECK(CPressureMonitor::GetWorkers(MakePressure(0.20, 0.0), 4, 16, 8, false) == 8);
+	TEST_CHECK(CPressureMonitor::GetWorkers(MakePressure(0.20, 0.0), 12, 1, 8, false) == 8);
+	TEST_CHECK(CPressureMonitor::GetWorkers(MakePressure(0.0, 0.50), 1, 1, 8, false) == 1);
+	TEST_CHECK(CPressureMonitor::GetWorkers(MakePressure(0.50, 0.0), 0, 0, 8, false) == 1);
+}
+
+int main() {
+	TestPsi();
+	TestLoad();
+	TestWorkers();
+
+	if (g_nFailed != 0) {
+		fprintf(stderr, "%zu checks failed\n", g_nFailed);
+		return EXIT_FAILURE;
+	}
+
+	printf("All checks passed\n");
+	return EXIT_SUCCESS;
+}